@@ -509,6 +509,7 @@ gnc_sx_instance_model_dispose(GObject *object)
     model->disposed = TRUE;
 
     qof_event_unregister_handler(model->qof_event_handler_id);
+    qof_event_unregister_handler(model->qof_sxes_event_handler_id);
 
     G_OBJECT_CLASS(parent_class)->dispose(object);
 }
@@ -625,7 +626,13 @@ gnc_sx_instance_model_init(GTypeInstance *instance, gpointer klass)
 
     g_date_clear(&inst->range_end, 1);
     inst->sx_instance_list = NULL;
-    inst->qof_event_handler_id = qof_event_register_handler(_gnc_sx_instance_event_handler, inst);
+    inst->qof_event_handler_id
+    = qof_event_register_filtered_handler(_gnc_sx_instance_event_handler, inst,
+                                          GNC_ID_SCHEDXACTION, QOF_EVENT_MODIFY);
+    inst->qof_sxes_event_handler_id
+    = qof_event_register_filtered_handler(_gnc_sx_instance_event_handler, inst,
+                                          GNC_ID_SXES,
+                                          GNC_EVENT_ITEM_ADDED | GNC_EVENT_ITEM_REMOVED);
 }
 
 static gint
@@ -689,7 +696,13 @@ _gnc_sx_instance_event_handler(QofInstance *ent, QofEventId event_type, gpointer
     }
     else if (GNC_IS_SXES(ent))
     {
-        SchedXaction *sx = GNC_SX(evt_data);
+        SchedXaction *sx;
+
+        /* Events held back while events were suspended still come
+         * with their sx; guard against anyone sending one without. */
+        if (evt_data == NULL)
+            return;
+        sx = GNC_SX(evt_data);
 
         if (event_type & GNC_EVENT_ITEM_REMOVED)
         {
@@ -190,6 +190,44 @@ test_state_changes()
     remove_sx(foo);
 }
 
+static void
+_remove_sx_instances(GncSxInstanceModel *model, SchedXaction *sx, gpointer user_data)
+{
+    gnc_sx_instance_model_remove_sx_instances(model, sx);
+}
+
+static void
+test_suspended_events()
+{
+    GncSxInstanceModel *model;
+    GncSxInstances *insts;
+    SchedXaction *kept, *dropped;
+    GDate today, tomorrow;
+
+    g_date_clear(&today, 1);
+    gnc_gdate_set_today (&today);
+    tomorrow = today;
+    g_date_add_days(&tomorrow, 1);
+
+    model = gnc_sx_get_instances(&tomorrow, TRUE);
+    g_signal_connect(model, "removing", (GCallback)_remove_sx_instances, NULL);
+
+    /* The SchedXactions list's events come with their sx, which may be
+     * gone by the resume, so they arrive while events are suspended. */
+    qof_event_suspend();
+    dropped = add_daily_sx("dropped", &today, NULL, NULL);
+    kept = add_daily_sx("kept", &today, NULL, NULL);
+    remove_sx(dropped);
+    qof_event_resume();
+
+    do_test(g_list_length(model->sx_instance_list) == 1, "one sx after resume");
+    insts = model->sx_instance_list ? model->sx_instance_list->data : NULL;
+    do_test(insts && insts->sx == kept, "the sx that was kept");
+
+    g_object_unref(model);
+    remove_sx(kept);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -205,6 +243,7 @@ main(int argc, char **argv)
     }
     test_basic();
     test_state_changes();
+    test_suspended_events();
 
     print_test_results();
     exit(get_rv());
@@ -221,6 +221,7 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
     ENTER( "be=%p, book=%p", be, book );
 
     be->loading = TRUE;
+    qof_book_begin_bulk_load( book );
 
     if ( loadType == LOAD_TYPE_INITIAL_LOAD )
     {
@@ -263,6 +264,8 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
         gnc_sql_transaction_load_all_tx( be );
     }
 
+    /* Sort the splits and compute the balances put off while loading */
+    qof_book_end_bulk_load( book );
     be->loading = FALSE;
 
     /* Mark the sessoion as clean -- though it should never be marked
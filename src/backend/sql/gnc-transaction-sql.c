@@ -625,7 +625,7 @@ commit_split( GncSqlBackend* be, QofInstance* inst )
         is_ok = gnc_sql_slots_save( be,
                                     guid,
                                     is_infant,
-                                    qof_instance_get_slots( inst ) );
+                                    qof_instance_peek_slots( inst ) );
     }
 
     return is_ok;
@@ -719,7 +719,7 @@ save_transaction( GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits )
         guid = qof_instance_get_guid( inst );
         if ( !qof_instance_get_destroying(inst) )
         {
-            is_ok = gnc_sql_slots_save( be, guid, is_infant, qof_instance_get_slots( inst ) );
+            is_ok = gnc_sql_slots_save( be, guid, is_infant, qof_instance_peek_slots( inst ) );
             if ( ! is_ok )
             {
                 err = "Slots save failed. Check trace log for SQL errors";
@@ -129,7 +129,7 @@ split_to_dom_tree(const gchar *tag, Split *spl)
     }
     {
         xmlNodePtr kvpnode = kvp_frame_to_dom_tree("split:slots",
-                             xaccSplitGetSlots(spl));
+                             qof_instance_peek_slots (QOF_INSTANCE (spl)));
         if (kvpnode)
         {
             xmlAddChild(ret, kvpnode);
@@ -192,7 +192,7 @@ gnc_transaction_dom_tree_create(Transaction *trn)
 
     {
         xmlNodePtr kvpnode = kvp_frame_to_dom_tree("trn:slots",
-                             xaccTransGetSlots(trn));
+                             qof_instance_peek_slots (QOF_INSTANCE (trn)));
         if (kvpnode)
         {
             xmlAddChild(ret, kvpnode);
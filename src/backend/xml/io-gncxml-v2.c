@@ -39,6 +39,7 @@
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gnc-book-snapshot.h"
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
@@ -771,6 +772,7 @@ qof_session_load_from_xml_file_v2_full(
     /* stop logging while we load */
     xaccLogDisable ();
     xaccDisableDataScrubbing();
+    qof_book_begin_bulk_load (book);
 
     if (push_handler)
     {
@@ -814,6 +816,7 @@ qof_session_load_from_xml_file_v2_full(
     if (!retval)
     {
         sixtp_destroy(top_parser);
+        qof_book_end_bulk_load (book);
         xaccLogEnable ();
         xaccEnableDataScrubbing();
         goto bail;
@@ -824,6 +827,10 @@ qof_session_load_from_xml_file_v2_full(
     sixtp_destroy (top_parser);
     g_free(gd);
 
+    /* sort the splits and compute the balances put off while loading,
+     * which the scrubs below rely on */
+    qof_book_end_bulk_load (book);
+
     xaccEnableDataScrubbing();
 
     /* Mark the session as saved */
@@ -1189,17 +1196,55 @@ xml_add_trn_data(Transaction *t, gpointer data)
     return 0;
 }
 
-static gboolean
-write_transactions(FILE *out, QofBook *book, sixtp_gdv2 *gd)
+struct snapshot_trn_data
 {
     struct file_backend be_data;
+    GncBookSnapshot *snapshot;
+    Account *root;
+};
 
-    be_data.out = out;
-    be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction(gnc_book_get_root_account(book),
-                   xml_add_trn_data,
-                   (gpointer) &be_data);
+/* The snapshot has all the book's transactions; only write those the
+ * account tree walk would, leaving out the template transactions. */
+static int
+xml_add_snapshot_trn_data(Transaction *t, gpointer data)
+{
+    struct snapshot_trn_data *std = data;
+    GList *node;
+
+    for (node = xaccTransGetSplitList(t); node; node = node->next)
+    {
+        Account *acc = gnc_book_snapshot_get_account(std->snapshot,
+                       xaccSplitGetAccount(node->data));
+        if (acc && gnc_account_get_root(acc) == std->root)
+            return xml_add_trn_data(t, &std->be_data);
+    }
+    return 0;
+}
+
+/* The transactions are written from a snapshot, so that one left open
+ * in a register is saved as it was last committed rather than half
+ * edited.  If an account is open there is no snapshot, and they are
+ * written as they are. */
+static gboolean
+write_transactions(FILE *out, QofBook *book, sixtp_gdv2 *gd)
+{
+    struct snapshot_trn_data std;
+    gint result;
+
+    std.be_data.out = out;
+    std.be_data.gd = gd;
+    std.root = gnc_book_get_root_account(book);
+    std.snapshot = gnc_book_snapshot_new(book);
+    if (!std.snapshot)
+        return 0 ==
+               xaccAccountTreeForEachTransaction(std.root, xml_add_trn_data,
+                       (gpointer) &std.be_data);
+
+    result = gnc_book_snapshot_foreach_transaction(std.snapshot,
+             xml_add_snapshot_trn_data,
+             (gpointer) &std);
+    gnc_book_snapshot_destroy(std.snapshot);
+    return result == 0;
 }
 
 static gboolean
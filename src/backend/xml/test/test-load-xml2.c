@@ -39,6 +39,7 @@
 
 #include <cashobjects.h>
 #include <TransLog.h>
+#include <Transaction.h>
 #include <gnc-engine.h>
 #include "../gnc-backend-xml.h"
 #include "../io-gncxml-v2.h"
@@ -73,6 +74,54 @@ remove_locks(const char *filename)
     remove_files_pattern(filename, ".LCK");
 }
 
+static int
+first_transaction(Transaction *trans, gpointer data)
+{
+    *(Transaction **) data = trans;
+    return 1;
+}
+
+static gchar *
+save_and_read(QofSession *session, const char *filename, gsize *length)
+{
+    gchar *contents = NULL;
+
+    qof_session_save(session, NULL);
+    if (!g_file_get_contents(filename, &contents, length, NULL))
+        *length = 0;
+    return contents;
+}
+
+/* Saving twice writes the same file, even with a transaction left open
+ * in between, which is saved as it was last committed. */
+static void
+test_save_twice(QofSession *session, const char *filename)
+{
+    QofBook *book = qof_session_get_book(session);
+    Transaction *trans = NULL;
+    gchar *first, *second;
+    gsize first_len, second_len;
+
+    first = save_and_read(session, filename, &first_len);
+    xaccAccountTreeForEachTransaction(gnc_book_get_root_account(book),
+                                      first_transaction, &trans);
+    if (trans)
+    {
+        xaccTransBeginEdit(trans);
+        xaccTransSetDescription(trans, "Left open while saving");
+    }
+    second = save_and_read(session, filename, &second_len);
+    if (trans)
+        xaccTransRollbackEdit(trans);
+
+    do_test_args(first && second && first_len == second_len &&
+                 memcmp(first, second, first_len) == 0,
+                 "save xml2 twice", __FILE__, __LINE__,
+                 "two saves of [%s] differ", filename);
+    g_free(first);
+    g_free(second);
+}
+
 static void
 test_load_file(const char *filename)
 {
@@ -106,6 +155,7 @@ test_load_file(const char *filename)
                  qof_session_get_error(session), filename);
     /* Uncomment the line below to generate corrected files */
     qof_session_save( session, NULL );
+    test_save_twice(session, filename);
     qof_session_end(session);
 }
 
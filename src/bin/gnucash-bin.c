@@ -87,6 +87,16 @@ static const char  *add_quotes_file  = NULL;
 static char        *namespace_regexp = NULL;
 static const char  *file_to_load     = NULL;
 static gchar      **args_remaining   = NULL;
+static gchar       *stats_filename   = NULL;
+
+static gboolean
+parse_stats_option (const gchar *option_name, const gchar *value,
+                    gpointer data, GError **error)
+{
+    g_free (stats_filename);
+    stats_filename = g_strdup (value ? value : "stdout");
+    return TRUE;
+}
 
 static GOptionEntry options[] =
 {
@@ -117,6 +127,15 @@ static GOptionEntry options[] =
         NULL
     },
 
+    {
+        "stats", '\0', G_OPTION_FLAG_OPTIONAL_ARG, G_OPTION_ARG_CALLBACK,
+        (gpointer) parse_stats_option,
+        N_("Gather engine statistics and write them as JSON on exit to FILE; defaults to \"stdout\"; can be \"stderr\"."),
+        /* Translators: Argument description for autohelp; see
+           http://developer.gnome.org/doc/API/2.0/glib/glib-Commandline-option-parser.html */
+        N_("FILE")
+    },
+
     {
         "nofile", '\0', 0, G_OPTION_ARG_NONE, &nofile,
         N_("Do not load the last file opened"), NULL
@@ -366,6 +385,13 @@ load_user_config(void)
     try_load_config_array(stylesheet_files);
 }
 
+static void
+gnc_dump_stats (gpointer unused, gpointer user_data)
+{
+    if (stats_filename)
+        qof_stats_dump (stats_filename);
+}
+
 /* Parse command line options, using GOption interface.
  * We can't let gtk_init_with_args do it because it fails
  * before parsing any arguments if the GUI can't be initialized.
@@ -430,6 +456,14 @@ gnc_parse_command_line(int *argc, char ***argv)
 
     if (args_remaining)
         file_to_load = args_remaining[0];
+
+    if (stats_filename)
+    {
+        qof_stats_set_enabled (TRUE);
+        /* Fetching quotes dumps them itself before it exits. */
+        if (!add_quotes_file)
+            gnc_hook_add_dangler (HOOK_SHUTDOWN, (GFunc)gnc_dump_stats, NULL);
+    }
 }
 
 static void
@@ -541,12 +575,14 @@ inner_main_add_price_quotes(void *closure, int argc, char **argv)
     }
 
     qof_event_resume();
+    gnc_dump_stats(NULL, NULL);
     gnc_shutdown(0);
     return;
 fail:
     if (session && qof_session_get_error(session) != ERR_BACKEND_NO_ERR)
         g_warning("Session Error: %s", qof_session_get_error_message(session));
     qof_event_resume();
+    gnc_dump_stats(NULL, NULL);
     gnc_shutdown(1);
 }
 
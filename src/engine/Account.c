@@ -36,6 +36,7 @@
 #include "TransactionP.h"
 #include "gnc-event.h"
 #include "gnc-glib-utils.h"
+#include "gnc-book-snapshot-p.h"
 #include "gnc-lot.h"
 #include "gnc-pricedb.h"
 
@@ -45,6 +46,10 @@ static QofLogModule log_module = GNC_MOD_ACCOUNT;
 static gchar account_separator[8] = ".";
 static gunichar account_uc_separator = ':';
 
+/* Bumped whenever an account is renamed or moved, or the separator
+ * changes, which makes every account's cached full name stale. */
+static guint account_names_generation = 1;
+
 enum
 {
     LAST_SIGNAL
@@ -97,6 +102,7 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void gnc_account_splits_clear (AccountPrivate *priv);
 
 
 /********************************************************************\
@@ -129,12 +135,14 @@ gnc_set_account_separator (const gchar *separator)
     {
         account_uc_separator = ':';
         strcpy(account_separator, ":");
+        account_names_generation++;
         return;
     }
 
     account_uc_separator = uc;
     count = g_unichar_to_utf8(uc, account_separator);
     account_separator[count] = '\0';
+    account_names_generation++;
 }
 
 gchar *gnc_account_name_violations_errmsg (const gchar *separator, GList* invalid_account_names)
@@ -251,8 +259,14 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
-
-    priv->splits = NULL;
+    priv->balance_dirty_from = G_MAXUINT;
+    priv->subtree_balances = NULL;
+    priv->subtree_dirty = TRUE;
+
+    priv->split_chunks = g_ptr_array_new ();
+    priv->split_chunk_tree = NULL;
+    priv->n_splits = 0;
+    priv->split_list = NULL;
     priv->sort_dirty = FALSE;
 }
 
@@ -265,6 +279,14 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    gnc_account_splits_clear (priv);
+    g_ptr_array_free (priv->split_chunks, TRUE);
+    g_free (priv->split_chunk_tree);
+    if (priv->subtree_balances)
+        g_array_free (priv->subtree_balances, TRUE);
+
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -983,7 +1005,8 @@ xaccCloneAccount(const Account *from, QofBook *book)
     priv->description = CACHE_INSERT(from_priv->description);
 
     kvp_frame_delete(ret->inst.kvp_data);
-    ret->inst.kvp_data = kvp_frame_copy(from->inst.kvp_data);
+    ret->inst.kvp_data = from->inst.kvp_data ?
+                         kvp_frame_copy(from->inst.kvp_data) : NULL;
 
     /* The new book should contain a commodity that matches
      * the one in the old book. Find it, use it. */
@@ -1072,7 +1095,7 @@ xaccFreeAccount (Account *acc)
     /* NB there shouldn't be any splits by now ... they should
      * have been all been freed by CommitEdit().  We can remove this
      * check once we know the warning isn't occurring any more. */
-    if (priv->splits)
+    if (priv->n_splits)
     {
         GList *slist;
         PERR (" instead of calling xaccFreeAccount(), please call \n"
@@ -1080,7 +1103,7 @@ xaccFreeAccount (Account *acc)
 
         qof_instance_reset_editlevel(acc);
 
-        slist = g_list_copy(priv->splits);
+        slist = g_list_copy(priv->split_list);
         for (lp = slist; lp; lp = lp->next)
         {
             Split *s = (Split *) lp->data;
@@ -1088,14 +1111,17 @@ xaccFreeAccount (Account *acc)
             xaccSplitDestroy (s);
         }
         g_list_free(slist);
-/* Nothing here (or in xaccAccountCommitEdit) NULLs priv->splits, so this asserts every time.
-        g_assert(priv->splits == NULL);
+/* Nothing here (or in xaccAccountCommitEdit) NULLs priv->split_list, so this asserts every time.
+        g_assert(priv->split_list == NULL);
 */
     }
 
     CACHE_REPLACE(priv->accountName, NULL);
     CACHE_REPLACE(priv->accountCode, NULL);
     CACHE_REPLACE(priv->description, NULL);
+    g_free (priv->full_name);
+    g_free (priv->full_name_key);
+    priv->full_name = priv->full_name_key = NULL;
 
     /* zero out values, just in case stray
      * pointers are pointing here. */
@@ -1112,12 +1138,73 @@ xaccFreeAccount (Account *acc)
     priv->commodity = NULL;
 
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = G_MAXUINT;
     priv->sort_dirty = FALSE;
 
     /* qof_instance_release (&acc->inst); */
     g_object_unref(acc);
 }
 
+/* A copy of the account's own fields, for a book snapshot to show
+ * once the account is edited.  Like xaccDupeTransaction(), the copy is
+ * in no collection and sends no events; it shares the live parent and
+ * has no children, splits or lots. */
+Account *
+xaccDupeAccount (const Account *from)
+{
+    Account *to;
+    AccountPrivate *from_priv, *priv;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(from), NULL);
+
+    to = g_object_new (GNC_TYPE_ACCOUNT, NULL);
+    from_priv = GET_PRIVATE(from);
+    priv = GET_PRIVATE(to);
+
+    to->inst.e_type = NULL;
+    qof_instance_copy_guid(to, from);
+    qof_instance_copy_book(to, from);
+    if (from->inst.kvp_data)
+        to->inst.kvp_data = kvp_frame_copy (from->inst.kvp_data);
+
+    CACHE_REPLACE(priv->accountName, from_priv->accountName);
+    CACHE_REPLACE(priv->accountCode, from_priv->accountCode);
+    CACHE_REPLACE(priv->description, from_priv->description);
+
+    priv->type = from_priv->type;
+    priv->commodity = from_priv->commodity;
+    priv->commodity_scu = from_priv->commodity_scu;
+    priv->non_standard_scu = from_priv->non_standard_scu;
+    priv->policy = from_priv->policy;
+    priv->parent = from_priv->parent;
+
+    priv->starting_balance = from_priv->starting_balance;
+    priv->starting_cleared_balance = from_priv->starting_cleared_balance;
+    priv->starting_reconciled_balance = from_priv->starting_reconciled_balance;
+
+    return to;
+}
+
+void
+xaccFreeDupeAccount (Account *acc)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    priv = GET_PRIVATE(acc);
+    CACHE_REPLACE(priv->accountName, NULL);
+    CACHE_REPLACE(priv->accountCode, NULL);
+    CACHE_REPLACE(priv->description, NULL);
+    g_free (priv->full_name);
+    g_free (priv->full_name_key);
+    priv->full_name = priv->full_name_key = NULL;
+    priv->parent = NULL;
+    priv->commodity = NULL;
+
+    g_object_unref(acc);
+}
+
 /********************************************************************\
  * transactional routines
 \********************************************************************/
@@ -1126,7 +1213,8 @@ void
 xaccAccountBeginEdit (Account *acc)
 {
     g_return_if_fail(acc);
-    qof_begin_edit(&acc->inst);
+    if (qof_begin_edit(&acc->inst))
+        gnc_book_snapshot_freeze (&acc->inst);
 }
 
 static void on_done(QofInstance *inst)
@@ -1170,7 +1258,17 @@ xaccAccountCommitEdit (Account *acc)
     QofBook *book;
 
     g_return_if_fail(acc);
-    if (!qof_commit_edit(&acc->inst)) return;
+
+    /* Keep readers out until the whole commit is done, not just the
+     * edit; the book outlives the account. */
+    book = qof_instance_get_book(acc);
+    if (!qof_book_write_lock(book))
+        return;
+    if (!qof_commit_edit(&acc->inst))
+    {
+        qof_book_write_unlock(book);
+        return;
+    }
 
     /* If marked for deletion, get rid of subaccounts first,
      * and then the splits ... */
@@ -1188,13 +1286,11 @@ xaccAccountCommitEdit (Account *acc)
         PINFO ("freeing splits for account %p (%s)",
                acc, priv->accountName ? priv->accountName : "(null)");
 
-        book = qof_instance_get_book(acc);
-
         /* If book is shutting down, just clear the split list.  The splits
            themselves will be destroyed by the transaction code */
         if (!qof_book_shutting_down(book))
         {
-            slist = g_list_copy(priv->splits);
+            slist = g_list_copy(priv->split_list);
             for (lp = slist; lp; lp = lp->next)
             {
                 Split *s = lp->data;
@@ -1204,8 +1300,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            gnc_account_splits_clear (priv);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1213,7 +1308,7 @@ xaccAccountCommitEdit (Account *acc)
            deleting all the splits in it.  The splits will just get
            recreated and put right back into the same account!
 
-           g_assert(priv->splits == NULL || qof_book_shutting_down(acc->inst.book));
+           g_assert(priv->split_list == NULL || qof_book_shutting_down(acc->inst.book));
         */
 
         if (!qof_book_shutting_down(book))
@@ -1240,6 +1335,7 @@ xaccAccountCommitEdit (Account *acc)
     }
 
     qof_commit_edit_part2(&acc->inst, on_err, on_done, acc_free);
+    qof_book_write_unlock(book);
 }
 
 void
@@ -1368,13 +1464,14 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
         }
     }
 
-    if (kvp_frame_compare(aa->inst.kvp_data, ab->inst.kvp_data) != 0)
+    if (kvp_frame_compare(qof_instance_peek_slots (QOF_INSTANCE (aa)),
+                          qof_instance_peek_slots (QOF_INSTANCE (ab))) != 0)
     {
         char *frame_a;
         char *frame_b;
 
-        frame_a = kvp_frame_to_string (aa->inst.kvp_data);
-        frame_b = kvp_frame_to_string (ab->inst.kvp_data);
+        frame_a = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (aa)));
+        frame_b = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (ab)));
 
         PWARN ("kvp frames differ:\n%s\n\nvs\n\n%s", frame_a, frame_b);
 
@@ -1485,36 +1582,31 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
     /* no parent; always compare downwards. */
 
     {
-        GList *la = priv_aa->splits;
-        GList *lb = priv_ab->splits;
+        GPtrArray *la = priv_aa->splits;
+        GPtrArray *lb = priv_ab->splits;
+        guint i;
 
-        if ((la && !lb) || (!la && lb))
+        if ((la->len && !lb->len) || (!la->len && lb->len))
         {
             PWARN ("only one has splits");
             return FALSE;
         }
 
-        if (la && lb)
+        if (la->len != lb->len)
         {
-            /* presume that the splits are in the same order */
-            while (la && lb)
-            {
-                Split *sa = (Split *) la->data;
-                Split *sb = (Split *) lb->data;
-
-                if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
-                {
-                    PWARN ("splits differ");
-                    return(FALSE);
-                }
+            PWARN ("number of splits differs");
+            return(FALSE);
+        }
 
-                la = la->next;
-                lb = lb->next;
-            }
+        /* presume that the splits are in the same order */
+        for (i = 0; i < la->len; i++)
+        {
+            Split *sa = g_ptr_array_index (la, i);
+            Split *sb = g_ptr_array_index (lb, i);
 
-            if ((la != NULL) || (lb != NULL))
+            if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
             {
-                PWARN ("number of splits differs");
+                PWARN ("splits differ");
                 return(FALSE);
             }
         }
@@ -1531,6 +1623,375 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
 
 /********************************************************************\
 \********************************************************************/
+/* Note that the running balances from the split at position pos
+ * onwards, and hence the account balances, need recomputing. */
+static inline void
+gnc_account_balance_dirty_from (AccountPrivate *priv, guint pos)
+{
+    priv->balance_dirty_from = MIN (priv->balance_dirty_from, pos);
+    /* Readers may be checking the flag; see xaccAccountSortSplits(). */
+    g_atomic_int_set (&priv->balance_dirty, TRUE);
+}
+
+/* Note that the subtree balances of the account and its ancestors need
+ * summing again.  An ancestor that is already dirty has dirty ancestors
+ * too, so the walk up the tree can stop there. */
+static void
+gnc_account_subtree_changed (AccountPrivate *priv)
+{
+    while (priv && !g_atomic_int_get (&priv->subtree_dirty))
+    {
+        g_atomic_int_set (&priv->subtree_dirty, TRUE);
+        priv = priv->parent ? GET_PRIVATE (priv->parent) : NULL;
+    }
+}
+
+static void gnc_account_recompute_balance_unlocked (AccountPrivate *priv);
+
+/* The split array; see AccountP.h. */
+
+static inline gboolean
+gnc_account_splits_contains (const AccountPrivate *priv, const Split *s)
+{
+    return s->acc_chunk && s->acc_chunk->owner == priv;
+}
+
+/* Lay the Fenwick tree out afresh over the chunk lengths, and number
+ * the chunks, after chunks are added or taken away. */
+static void
+gnc_account_splits_rebuild_tree (AccountPrivate *priv)
+{
+    guint n = priv->split_chunks->len;
+    guint i;
+
+    g_free (priv->split_chunk_tree);
+    priv->split_chunk_tree = g_new (guint, n + 1);
+    priv->split_chunk_tree[0] = 0;
+    for (i = 1; i <= n; i++)
+    {
+        SplitChunk *chunk = g_ptr_array_index (priv->split_chunks, i - 1);
+
+        chunk->index = i - 1;
+        priv->split_chunk_tree[i] = chunk->len;
+    }
+    for (i = 1; i <= n; i++)
+    {
+        guint up = i + (i & -i);
+        if (up <= n)
+            priv->split_chunk_tree[up] += priv->split_chunk_tree[i];
+    }
+}
+
+static void
+gnc_account_splits_tree_add (AccountPrivate *priv, guint index, gint delta)
+{
+    guint n = priv->split_chunks->len;
+    guint i;
+
+    for (i = index + 1; i <= n; i += i & -i)
+        priv->split_chunk_tree[i] += delta;
+}
+
+/* The number of splits in the chunks before the one at index. */
+static guint
+gnc_account_splits_chunk_start (const AccountPrivate *priv, guint index)
+{
+    guint start = 0;
+
+    for (; index > 0; index -= index & -index)
+        start += priv->split_chunk_tree[index];
+    return start;
+}
+
+/* Find the chunk holding the split at pos, which must be less than
+ * n_splits, and the split's offset in it. */
+static SplitChunk *
+gnc_account_splits_locate (const AccountPrivate *priv, guint pos,
+                           guint *offset)
+{
+    guint n = priv->split_chunks->len;
+    guint index = 0, step = 1;
+
+    while (step * 2 <= n)
+        step *= 2;
+    for (; step; step /= 2)
+    {
+        if (index + step <= n && priv->split_chunk_tree[index + step] <= pos)
+        {
+            index += step;
+            pos -= priv->split_chunk_tree[index];
+        }
+    }
+    *offset = pos;
+    return g_ptr_array_index (priv->split_chunks, index);
+}
+
+static GList *
+gnc_account_splits_node_at (const AccountPrivate *priv, guint pos)
+{
+    SplitChunk *chunk;
+    guint offset;
+
+    if (pos >= priv->n_splits)
+        return NULL;
+    chunk = gnc_account_splits_locate (priv, pos, &offset);
+    return chunk->nodes[offset];
+}
+
+static inline Split *
+gnc_account_splits_at (const AccountPrivate *priv, guint pos)
+{
+    GList *node = gnc_account_splits_node_at (priv, pos);
+    return node ? node->data : NULL;
+}
+
+static guint
+gnc_account_splits_offset (const SplitChunk *chunk, const Split *s)
+{
+    guint offset;
+
+    for (offset = 0; offset < chunk->len; offset++)
+        if (chunk->nodes[offset]->data == s)
+            break;
+    return offset;
+}
+
+/* The position of a split known to be in the account. */
+static guint
+gnc_account_splits_find (const AccountPrivate *priv, const Split *s)
+{
+    SplitChunk *chunk = s->acc_chunk;
+
+    return gnc_account_splits_chunk_start (priv, chunk->index) +
+           gnc_account_splits_offset (chunk, s);
+}
+
+/* Return the position of the first split for which before() is FALSE.
+ * It must be TRUE for all the splits ahead of that one and FALSE for
+ * the rest, which holds when the splits are sorted.  A binary search of
+ * the chunks' last splits finds the chunk, and another the split. */
+typedef gboolean (*SplitBeforeFunc) (const Split *split, gconstpointer data);
+
+static guint
+gnc_account_splits_bsearch (const AccountPrivate *priv,
+                            SplitBeforeFunc before, gconstpointer data)
+{
+    guint lo = 0, hi = priv->split_chunks->len;
+    guint index;
+    SplitChunk *chunk;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        chunk = g_ptr_array_index (priv->split_chunks, mid);
+        if (before (chunk->nodes[chunk->len - 1]->data, data))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == priv->split_chunks->len)
+        return priv->n_splits;
+
+    index = lo;
+    chunk = g_ptr_array_index (priv->split_chunks, index);
+    lo = 0;
+    hi = chunk->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (before (chunk->nodes[mid]->data, data))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return gnc_account_splits_chunk_start (priv, index) + lo;
+}
+
+/* Add an empty chunk to the account at index. */
+static SplitChunk *
+gnc_account_splits_add_chunk (AccountPrivate *priv, guint index)
+{
+    GPtrArray *chunks = priv->split_chunks;
+    SplitChunk *chunk = g_slice_new (SplitChunk);
+
+    chunk->owner = priv;
+    chunk->len = 0;
+    g_ptr_array_add (chunks, chunk);
+    memmove (&chunks->pdata[index + 1], &chunks->pdata[index],
+             (chunks->len - 1 - index) * sizeof (gpointer));
+    chunks->pdata[index] = chunk;
+    gnc_account_splits_rebuild_tree (priv);
+    return chunk;
+}
+
+static void
+gnc_account_splits_drop_chunk (AccountPrivate *priv, guint index)
+{
+    SplitChunk *chunk = g_ptr_array_index (priv->split_chunks, index);
+
+    g_ptr_array_remove_index (priv->split_chunks, index);
+    g_slice_free (SplitChunk, chunk);
+    gnc_account_splits_rebuild_tree (priv);
+}
+
+/* Move count nodes from the start of one chunk to the end of another. */
+static void
+gnc_account_splits_move_nodes (SplitChunk *to, SplitChunk *from,
+                               guint start, guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++)
+    {
+        GList *node = from->nodes[start + i];
+
+        to->nodes[to->len++] = node;
+        ((Split *) node->data)->acc_chunk = to;
+    }
+    memmove (&from->nodes[start], &from->nodes[start + count],
+             (from->len - start - count) * sizeof (GList *));
+    from->len -= count;
+}
+
+/* Make room in a full chunk for a node at offset.  A split on the end
+ * of the full chunk goes in a new one after it, as appended splits do;
+ * otherwise the chunk is split in half. */
+static SplitChunk *
+gnc_account_splits_make_room (AccountPrivate *priv, SplitChunk *chunk,
+                              guint *offset)
+{
+    SplitChunk *next = gnc_account_splits_add_chunk (priv, chunk->index + 1);
+
+    if (*offset == SPLIT_CHUNK_SIZE)
+    {
+        *offset = 0;
+        return next;
+    }
+    gnc_account_splits_move_nodes (next, chunk, SPLIT_CHUNK_SIZE / 2,
+                                   SPLIT_CHUNK_SIZE / 2);
+    gnc_account_splits_rebuild_tree (priv);
+    if (*offset <= SPLIT_CHUNK_SIZE / 2)
+        return chunk;
+    *offset -= SPLIT_CHUNK_SIZE / 2;
+    return next;
+}
+
+/* Insert a split at pos, and into split_list in front of the node of
+ * the split it displaces, so that the two stay in step. */
+static void
+gnc_account_splits_insert (AccountPrivate *priv, Split *s, guint pos)
+{
+    SplitChunk *chunk;
+    GList *node;
+    guint offset;
+
+    if (pos < priv->n_splits)
+    {
+        GList *sibling;
+
+        chunk = gnc_account_splits_locate (priv, pos, &offset);
+        sibling = chunk->nodes[offset];
+        priv->split_list = g_list_insert_before (priv->split_list, sibling, s);
+        node = sibling->prev;
+    }
+    else
+    {
+        GList *last = NULL;
+
+        if (priv->split_chunks->len)
+        {
+            chunk = g_ptr_array_index (priv->split_chunks,
+                                       priv->split_chunks->len - 1);
+            offset = chunk->len;
+            last = chunk->nodes[offset - 1];
+        }
+        else
+        {
+            chunk = gnc_account_splits_add_chunk (priv, 0);
+            offset = 0;
+        }
+        node = g_list_alloc ();
+        node->data = s;
+        node->prev = last;
+        if (last)
+            last->next = node;
+        else
+            priv->split_list = node;
+    }
+
+    if (chunk->len == SPLIT_CHUNK_SIZE)
+        chunk = gnc_account_splits_make_room (priv, chunk, &offset);
+    memmove (&chunk->nodes[offset + 1], &chunk->nodes[offset],
+             (chunk->len - offset) * sizeof (GList *));
+    chunk->nodes[offset] = node;
+    chunk->len++;
+    s->acc_chunk = chunk;
+    priv->n_splits++;
+    gnc_account_splits_tree_add (priv, chunk->index, 1);
+}
+
+/* Take a split out of the account, and return where it was.  A chunk
+ * left empty is dropped, and one that now fits into half a chunk with
+ * a neighbour is merged with it, so that the chunks stay reasonably
+ * full. */
+static guint
+gnc_account_splits_remove (AccountPrivate *priv, Split *s)
+{
+    SplitChunk *chunk = s->acc_chunk;
+    SplitChunk *next = NULL, *prev = NULL;
+    guint index = chunk->index;
+    guint offset = gnc_account_splits_offset (chunk, s);
+    guint pos = gnc_account_splits_chunk_start (priv, index) + offset;
+    GList *node = chunk->nodes[offset];
+
+    memmove (&chunk->nodes[offset], &chunk->nodes[offset + 1],
+             (chunk->len - offset - 1) * sizeof (GList *));
+    chunk->len--;
+    priv->n_splits--;
+    s->acc_chunk = NULL;
+    priv->split_list = g_list_delete_link (priv->split_list, node);
+
+    if (index + 1 < priv->split_chunks->len)
+        next = g_ptr_array_index (priv->split_chunks, index + 1);
+    if (index > 0)
+        prev = g_ptr_array_index (priv->split_chunks, index - 1);
+
+    if (chunk->len == 0)
+        gnc_account_splits_drop_chunk (priv, index);
+    else if (next && chunk->len + next->len <= SPLIT_CHUNK_SIZE / 2)
+    {
+        gnc_account_splits_move_nodes (chunk, next, 0, next->len);
+        gnc_account_splits_drop_chunk (priv, index + 1);
+    }
+    else if (prev && prev->len + chunk->len <= SPLIT_CHUNK_SIZE / 2)
+    {
+        gnc_account_splits_move_nodes (prev, chunk, 0, chunk->len);
+        gnc_account_splits_drop_chunk (priv, index);
+    }
+    else
+        gnc_account_splits_tree_add (priv, index, -1);
+    return pos;
+}
+
+/* Forget all the splits without touching them, as the book is going
+ * away with them. */
+static void
+gnc_account_splits_clear (AccountPrivate *priv)
+{
+    guint i;
+
+    for (i = 0; i < priv->split_chunks->len; i++)
+        g_slice_free (SplitChunk, g_ptr_array_index (priv->split_chunks, i));
+    g_ptr_array_set_size (priv->split_chunks, 0);
+    gnc_account_splits_rebuild_tree (priv);
+    priv->n_splits = 0;
+    g_list_free (priv->split_list);
+    priv->split_list = NULL;
+}
+
+
 void
 gnc_account_set_sort_dirty (Account *acc)
 {
@@ -1556,43 +2017,100 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
+}
+
+void
+gnc_account_set_split_balance_dirty (Account *acc, const Split *split)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    /* The whole account is recomputed when the bulk load ends. */
+    if (qof_book_is_bulk_loading (qof_instance_get_book (acc)))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    if (gnc_account_splits_contains (priv, split))
+        gnc_account_balance_dirty_from (priv, gnc_account_splits_find (priv, split));
+    else
+        gnc_account_balance_dirty_from (priv, 0);
 }
 
 /********************************************************************\
 \********************************************************************/
 
+typedef struct
+{
+    const Split *split;
+    gboolean action_for_num;
+} SplitOrderData;
+
+static gboolean
+split_sorts_before (const Split *split, gconstpointer data)
+{
+    const SplitOrderData *order = data;
+    return xaccSplitOrderForNum (split, order->split,
+                                 order->action_for_num) < 0;
+}
+
+/* Find the position at which s sorts.  Only meaningful when the splits
+ * are sorted, i.e. sort_dirty is clear. */
+static guint
+gnc_account_splits_search (AccountPrivate *priv, const Split *s)
+{
+    SplitOrderData order;
+
+    if (!priv->n_splits) return 0;
+    order.split = s;
+    order.action_for_num = qof_book_use_split_action_for_num_field
+                           (xaccSplitGetBook (s));
+    return gnc_account_splits_bsearch (priv, split_sorts_before, &order);
+}
+
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (gnc_account_splits_contains (priv, s))
         return FALSE;
 
+    /* Nobody is listening while the book is loaded in bulk, and the
+     * account is sorted and its balances computed when the load ends. */
+    if (qof_book_is_bulk_loading (qof_instance_get_book (acc)))
+    {
+        gnc_account_splits_insert (priv, s, priv->n_splits);
+        priv->sort_dirty = TRUE;
+        return TRUE;
+    }
+
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        pos = gnc_account_splits_search (priv, s);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        pos = priv->n_splits;
         priv->sort_dirty = TRUE;
     }
+    gnc_account_splits_insert (priv, s, pos);
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, pos);
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1602,40 +2120,204 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    if (!gnc_account_splits_contains (priv, s))
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+    pos = gnc_account_splits_remove (priv, s);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, pos);
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
 
+static gint
+split_order_for_num (gconstpointer a, gconstpointer b, gpointer action_for_num)
+{
+    return xaccSplitOrderForNum (a, b, GPOINTER_TO_INT (action_for_num));
+}
+
+/* Sort the list in place, so that its nodes stay valid for anyone
+ * walking it, and then bring the chunks back in step with it, leaving
+ * their lengths as they were.  Only the running balances from the
+ * first split that moved are stale.  The caller sees to it that nobody
+ * else sorts the account at once. */
+static void
+gnc_account_sort_splits_unlocked (AccountPrivate *priv,
+                                  gboolean action_for_num)
+{
+    GList *lp;
+    guint index, offset, pos = 0;
+
+    QOF_STATS_RECORD ("gnc.account.sort.splits", priv->n_splits);
+    priv->split_list = g_list_sort_with_data(priv->split_list,
+                                             split_order_for_num,
+                                             GINT_TO_POINTER (action_for_num));
+    lp = priv->split_list;
+    for (index = 0; index < priv->split_chunks->len; index++)
+    {
+        SplitChunk *chunk = g_ptr_array_index (priv->split_chunks, index);
+
+        for (offset = 0; offset < chunk->len; offset++, pos++, lp = lp->next)
+        {
+            if (chunk->nodes[offset] == lp)
+                continue;
+            gnc_account_balance_dirty_from (priv, pos);
+            chunk->nodes[offset] = lp;
+            ((Split *) lp->data)->acc_chunk = chunk;
+        }
+    }
+    g_atomic_int_set (&priv->sort_dirty, FALSE);
+}
+
 void
 xaccAccountSortSplits (Account *acc, gboolean force)
 {
     AccountPrivate *priv;
+    QofBook *book;
+    gboolean bulk;
 
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     priv = GET_PRIVATE(acc);
-    if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
+    if (!force && qof_instance_get_editlevel(acc) > 0)
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
-    priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    /* Every account is sorted when a bulk load ends, so until then only
+     * sort when asked to. */
+    book = qof_instance_get_book (acc);
+    bulk = qof_book_is_bulk_loading (book);
+    if (bulk ? !force : !g_atomic_int_get (&priv->sort_dirty))
+        return;
+
+    /* Several threads reading the book may find the account unsorted
+     * at once; the first one sorts it. */
+    qof_book_cache_lock (book);
+    if (priv->sort_dirty)
+        gnc_account_sort_splits_unlocked
+            (priv, qof_book_use_split_action_for_num_field (book));
+    /* Nothing says which balances are out of date during a bulk load,
+     * and xaccAccountRecomputeBalance() leaves them all to its end, so
+     * bring the whole account up to date here. */
+    if (bulk)
+    {
+        gnc_account_balance_dirty_from (priv, 0);
+        gnc_account_recompute_balance_unlocked (priv);
+    }
+    qof_book_cache_unlock (book);
+}
+
+static gboolean
+split_posted_before_date (const Split *split, gconstpointer data)
+{
+    return xaccTransGetDate (xaccSplitGetParent (split)) <
+           *(const time64 *) data;
+}
+
+/* Binary search the splits for the first split posted on or after
+ * date.  Returns its position, which is also the number of splits
+ * posted before date.  The caller is expected to have sorted the
+ * splits first. */
+static guint
+gnc_account_splits_search_date (AccountPrivate *priv, time64 date)
+{
+    return gnc_account_splits_bsearch (priv, split_posted_before_date, &date);
+}
+
+typedef struct
+{
+    const Timespec *ts;
+    gboolean after;
+} SplitPostedData;
+
+static gboolean
+split_posted_before_ts (const Split *split, gconstpointer data)
+{
+    const SplitPostedData *posted_data = data;
+    Timespec posted = xaccTransRetDatePostedTS (xaccSplitGetParent (split));
+    int cmp = timespec_cmp (&posted, posted_data->ts);
+
+    return cmp < 0 || (posted_data->after && cmp == 0);
+}
+
+/* Binary search the splits for the first split posted on or after ts,
+ * or strictly after it if after is set. */
+static guint
+gnc_account_splits_search_ts (AccountPrivate *priv, const Timespec *ts,
+                              gboolean after)
+{
+    SplitPostedData posted_data;
+
+    posted_data.ts = ts;
+    posted_data.after = after;
+    return gnc_account_splits_bsearch (priv, split_posted_before_ts,
+                                       &posted_data);
+}
+
+SplitList *
+gnc_account_get_splits_in_date_range (Account *acc,
+                                      const Timespec *start,
+                                      gboolean start_inclusive,
+                                      const Timespec *end,
+                                      gboolean end_inclusive)
+{
+    AccountPrivate *priv;
+    SplitList *list = NULL;
+    GList *node;
+    guint lo, hi;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+
+    priv = GET_PRIVATE(acc);
+    xaccAccountSortSplits (acc, FALSE);  // normally a noop
+
+    /* Only sorted splits can be searched.  An account that is being
+     * edited isn't re-sorted behind the editor's back, and splits without
+     * a transaction sort after all the dated ones, so in those cases
+     * check each of the splits instead. */
+    if (priv->sort_dirty ||
+            (priv->n_splits &&
+             !xaccSplitGetParent (gnc_account_splits_at (priv,
+                                  priv->n_splits - 1))))
+    {
+        for (node = priv->split_list; node; node = node->next)
+        {
+            Split *split = node->data;
+            Timespec posted = xaccTransRetDatePostedTS (xaccSplitGetParent (split));
+            int cmp;
+
+            if (start)
+            {
+                cmp = timespec_cmp (&posted, start);
+                if (cmp < 0 || (cmp == 0 && !start_inclusive))
+                    continue;
+            }
+            if (end)
+            {
+                cmp = timespec_cmp (&posted, end);
+                if (cmp > 0 || (cmp == 0 && !end_inclusive))
+                    continue;
+            }
+            list = g_list_prepend (list, split);
+        }
+        return g_list_reverse (list);
+    }
+
+    lo = start ? gnc_account_splits_search_ts (priv, start, !start_inclusive) : 0;
+    hi = end ? gnc_account_splits_search_ts (priv, end, end_inclusive) :
+         priv->n_splits;
+    for (node = gnc_account_splits_node_at (priv, lo); node && lo < hi;
+            node = node->next, lo++)
+        list = g_list_prepend (list, node->data);
+    return g_list_reverse (list);
 }
 
 static void
@@ -1833,7 +2515,7 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 
     /* optimizations */
     from_priv = GET_PRIVATE(accfrom);
-    if (!from_priv->splits || accfrom == accto)
+    if (!from_priv->n_splits || accfrom == accto)
         return;
 
     /* check for book mix-up */
@@ -1843,7 +2525,7 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
     xaccAccountBeginEdit(accfrom);
     xaccAccountBeginEdit(accto);
     /* Begin editing both accounts and all transactions in accfrom. */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
+    g_list_foreach(from_priv->split_list, (GFunc)xaccPreSplitMove, NULL);
 
     /* Concatenate accfrom's lists of splits and lots to accto's lists. */
     //to_priv->splits = g_list_concat(to_priv->splits, from_priv->splits);
@@ -1860,10 +2542,10 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
      * Convert each split's amount to accto's commodity.
      * Commit to editing each transaction.
      */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    g_list_foreach(from_priv->split_list, (GFunc)xaccPostSplitMove, (gpointer)accto);
 
     /* Finally empty accfrom. */
-    g_assert(from_priv->splits == NULL);
+    g_assert(from_priv->split_list == NULL);
     g_assert(from_priv->lots == NULL);
     xaccAccountCommitEdit(accfrom);
     xaccAccountCommitEdit(accto);
@@ -1900,32 +2582,44 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * Return: void                                                     *
 \********************************************************************/
 
-void
-xaccAccountRecomputeBalance (Account * acc)
+/* The caller sees to it that nobody else recomputes the account at
+ * once, as for gnc_account_sort_splits_unlocked(). */
+static void
+gnc_account_recompute_balance_unlocked (AccountPrivate *priv)
 {
-    AccountPrivate *priv;
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
-
-    if (NULL == acc) return;
+    GList *node;
+    guint i;
 
-    priv = GET_PRIVATE(acc);
-    if (qof_instance_get_editlevel(acc) > 0) return;
-    if (!priv->balance_dirty) return;
-    if (qof_instance_get_destroying(acc)) return;
-    if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
+    /* The running balances before the first dirty split are still
+     * good, so pick up from the one just before it. */
+    i = MIN (priv->balance_dirty_from, priv->n_splits);
+    if (i == 0)
+    {
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+        node = priv->split_list;
+    }
+    else
+    {
+        GList *prev_node = gnc_account_splits_node_at (priv, i - 1);
+        Split *prev = prev_node->data;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+        balance            = prev->balance;
+        cleared_balance    = prev->cleared_balance;
+        reconciled_balance = prev->reconciled_balance;
+        node = prev_node->next;
+    }
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    PINFO ("acct=%s from split %u baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
+           priv->accountName, i, balance.num, balance.denom);
+    QOF_STATS_RECORD ("gnc.account.recompute.splits", priv->n_splits - i);
+    for (; node; node = node->next)
     {
-        Split *split = (Split *) lp->data;
+        Split *split = node->data;
         gnc_numeric amt = xaccSplitGetAmount (split);
 
         balance = gnc_numeric_add_fixed(balance, amt);
@@ -1948,10 +2642,38 @@ xaccAccountRecomputeBalance (Account * acc)
 
     }
 
+    if (!gnc_numeric_equal (balance, priv->balance) ||
+            !gnc_numeric_equal (cleared_balance, priv->cleared_balance) ||
+            !gnc_numeric_equal (reconciled_balance, priv->reconciled_balance))
+        gnc_account_subtree_changed (priv);
     priv->balance = balance;
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
-    priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = G_MAXUINT;
+    g_atomic_int_set (&priv->balance_dirty, FALSE);
+}
+
+void
+xaccAccountRecomputeBalance (Account * acc)
+{
+    AccountPrivate *priv;
+    QofBook *book;
+
+    if (NULL == acc) return;
+
+    priv = GET_PRIVATE(acc);
+    if (qof_instance_get_editlevel(acc) > 0) return;
+    if (!g_atomic_int_get (&priv->balance_dirty)) return;
+    if (qof_instance_get_destroying(acc)) return;
+    book = qof_instance_get_book(acc);
+    if (qof_book_shutting_down(book)) return;
+    if (qof_book_is_bulk_loading(book)) return;
+
+    /* As for sorting, the first of several readers does the work. */
+    qof_book_cache_lock (book);
+    if (priv->balance_dirty)
+        gnc_account_recompute_balance_unlocked (priv);
+    qof_book_cache_unlock (book);
 }
 
 /********************************************************************\
@@ -2066,7 +2788,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    gnc_account_balance_dirty_from (priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2087,6 +2809,7 @@ xaccAccountSetName (Account *acc, const char *str)
 
     xaccAccountBeginEdit(acc);
     CACHE_REPLACE(priv->accountName, str);
+    account_names_generation++;
     mark_account (acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2138,13 +2861,13 @@ xaccAccountSetColor (Account *acc, const char *str)
     if (str)
     {
         gchar *tmp = g_strstrip(g_strdup(str));
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "color",
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "color",
                               strlen(tmp) ? kvp_value_new_string(tmp) : NULL);
         g_free(tmp);
     }
     else
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "color", NULL);
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "color", NULL);
     }
     mark_account (acc);
     xaccAccountCommitEdit(acc);
@@ -2159,13 +2882,13 @@ xaccAccountSetFilter (Account *acc, const char *str)
     if (str)
     {
         gchar *tmp = g_strstrip(g_strdup(str));
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "filter",
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "filter",
                               strlen(tmp) ? kvp_value_new_string(tmp) : NULL);
         g_free(tmp);
     }
     else
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "filter", NULL);
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "filter", NULL);
     }
     mark_account (acc);
     xaccAccountCommitEdit(acc);
@@ -2180,13 +2903,13 @@ xaccAccountSetSortOrder (Account *acc, const char *str)
     if (str)
     {
         gchar *tmp = g_strstrip(g_strdup(str));
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "sort-order",
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "sort-order",
                               strlen(tmp) ? kvp_value_new_string(tmp) : NULL);
         g_free(tmp);
     }
     else
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "sort-order", NULL);
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "sort-order", NULL);
     }
     mark_account (acc);
     xaccAccountCommitEdit(acc);
@@ -2219,13 +2942,13 @@ xaccAccountSetNotes (Account *acc, const char *str)
     if (str)
     {
         gchar *tmp = g_strstrip(g_strdup(str));
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "notes",
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "notes",
                               strlen(tmp) ? kvp_value_new_string(tmp) : NULL);
         g_free(tmp);
     }
     else
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data, "notes", NULL);
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "notes", NULL);
     }
     mark_account(acc);
     xaccAccountCommitEdit(acc);
@@ -2254,7 +2977,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     priv->non_standard_scu = FALSE;
 
     /* iterate over splits */
-    for (lp = priv->splits; lp; lp = lp->next)
+    for (lp = priv->split_list; lp; lp = lp->next)
     {
         Split *s = (Split *) lp->data;
         Transaction *trans = xaccSplitGetParent (s);
@@ -2265,7 +2988,8 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
+    gnc_account_subtree_changed (priv);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -2351,7 +3075,7 @@ DxaccAccountSetCurrency (Account * acc, gnc_commodity * currency)
 
     xaccAccountBeginEdit(acc);
     string = gnc_commodity_get_unique_name (currency);
-    kvp_frame_set_slot_nc(acc->inst.kvp_data, "old-currency",
+    kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "old-currency",
                           kvp_value_new_string(string));
     mark_account (acc);
     xaccAccountCommitEdit(acc);
@@ -2415,6 +3139,8 @@ gnc_account_append_child (Account *new_parent, Account *child)
     }
     cpriv->parent = new_parent;
     ppriv->children = g_list_append(ppriv->children, child);
+    account_names_generation++;
+    gnc_account_subtree_changed (ppriv);
     qof_instance_set_dirty(&new_parent->inst);
     qof_instance_set_dirty(&child->inst);
 
@@ -2461,6 +3187,8 @@ gnc_account_remove_child (Account *parent, Account *child)
 
     /* clear the account's parent pointer after REMOVE event generation. */
     cpriv->parent = NULL;
+    account_names_generation++;
+    gnc_account_subtree_changed (ppriv);
 
     qof_event_gen (&parent->inst, QOF_EVENT_MODIFY, NULL);
 }
@@ -2928,6 +3656,79 @@ gnc_account_get_full_name(const Account *account)
     return fullname;
 }
 
+/* The names only change while the book is locked for writing, so
+ * threads reading it just need to agree on who fills them in. */
+static void
+account_update_full_name (AccountPrivate *priv, const Account *acc)
+{
+    QofBook *book;
+
+    if (g_atomic_int_get (&priv->full_name_generation) ==
+            account_names_generation)
+        return;
+    book = qof_instance_get_book (acc);
+    qof_book_cache_lock (book);
+    if (priv->full_name_generation != account_names_generation)
+    {
+        g_free (priv->full_name);
+        g_free (priv->full_name_key);
+        priv->full_name = gnc_account_get_full_name (acc);
+        priv->full_name_key = NULL;
+        g_atomic_int_set (&priv->full_name_generation,
+                          account_names_generation);
+    }
+    qof_book_cache_unlock (book);
+}
+
+const gchar *
+gnc_account_get_cached_full_name (const Account *acc)
+{
+    AccountPrivate *priv;
+
+    if (NULL == acc)
+        return "";
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), "");
+
+    priv = GET_PRIVATE(acc);
+    account_update_full_name (priv, acc);
+    return priv->full_name;
+}
+
+const gchar *
+gnc_account_get_full_name_collate_key (const Account *acc)
+{
+    static gsize empty_key = 0;
+    AccountPrivate *priv;
+    gchar *key;
+
+    if (NULL == acc)
+    {
+        if (g_once_init_enter (&empty_key))
+            g_once_init_leave (&empty_key,
+                               (gsize) g_utf8_collate_key ("", -1));
+        return (const gchar *) empty_key;
+    }
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), "");
+
+    priv = GET_PRIVATE(acc);
+    account_update_full_name (priv, acc);
+    key = g_atomic_pointer_get (&priv->full_name_key);
+    if (!key)
+    {
+        QofBook *book = qof_instance_get_book (acc);
+
+        qof_book_cache_lock (book);
+        key = priv->full_name_key;
+        if (!key)
+        {
+            key = g_utf8_collate_key (priv->full_name, -1);
+            g_atomic_pointer_set (&priv->full_name_key, key);
+        }
+        qof_book_cache_unlock (book);
+    }
+    return key;
+}
+
 const char *
 xaccAccountGetCode (const Account *acc)
 {
@@ -3042,7 +3843,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3055,7 +3856,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3068,7 +3869,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3105,7 +3906,8 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (node = gnc_account_splits_node_at (priv, priv->n_splits - 1); node;
+            node = node->prev)
     {
         Split *split = node->data;
 
@@ -3130,20 +3932,24 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
-gnc_numeric
-xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
+/* The split array holds the splits in posted-date order and each split
+ * caches the running balances up to and including itself, so the
+ * balance as of a date is the running balance of the last split posted
+ * before that date. */
+typedef enum
+{
+    ACCOUNT_BALANCE,
+    ACCOUNT_CLEARED_BALANCE,
+    ACCOUNT_RECONCILED_BALANCE
+} AccountBalanceKind;
+
+static gnc_numeric
+xaccAccountGetXxxBalanceAsOfDate (Account *acc, time64 date,
+                                  AccountBalanceKind kind)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
     AccountPrivate *priv;
-    GList   *lp;
-    Timespec ts, trans_ts;
-    gboolean found = FALSE;
-    gnc_numeric balance;
+    Split *split;
+    guint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
@@ -3151,55 +3957,57 @@ xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
     priv = GET_PRIVATE(acc);
-    balance = priv->balance;
-
-    /* Since transaction post times are stored as a Timespec,
-     * convert date into a Timespec as well rather than converting
-     * each transaction's Timespec into a time64.
-     *
-     * FIXME: CAS: I think this comment is a bogus justification for
-     * using xaccTransGetDatePostedTS.  There's no benefit to using
-     * Timespec when the input argument is time64, and it's hard to
-     * imagine that casting long long to long and comparing two longs is
-     * worse than comparing two long longs every time.  IMO,
-     * xaccAccountGetPresentBalance gets this right, and its algorithm
-     * should be used here.
-     */
-    ts.tv_sec = date;
-    ts.tv_nsec = 0;
+    pos = gnc_account_splits_search_date (priv, date);
 
-    lp = priv->splits;
-    while ( lp && !found )
+    /* No splits were posted on or after the given date, so the latest
+     * account balance is good enough. */
+    if (pos == priv->n_splits)
     {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
-        if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
-            found = TRUE;
-        else
-            lp = lp->next;
+        switch (kind)
+        {
+        case ACCOUNT_CLEARED_BALANCE:
+            return priv->cleared_balance;
+        case ACCOUNT_RECONCILED_BALANCE:
+            return priv->reconciled_balance;
+        default:
+            return priv->balance;
+        }
     }
 
-    if ( lp )
+    /* AsOf date must be before any entries, return zero. */
+    if (pos == 0)
+        return gnc_numeric_zero();
+
+    split = gnc_account_splits_at (priv, pos - 1);
+    switch (kind)
     {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
-        }
+    case ACCOUNT_CLEARED_BALANCE:
+        return xaccSplitGetClearedBalance (split);
+    case ACCOUNT_RECONCILED_BALANCE:
+        return xaccSplitGetReconciledBalance (split);
+    default:
+        return xaccSplitGetBalance (split);
     }
+}
 
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
+gnc_numeric
+xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate (acc, date, ACCOUNT_BALANCE);
+}
+
+gnc_numeric
+xaccAccountGetClearedBalanceAsOfDate (Account *acc, time64 date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate (acc, date,
+            ACCOUNT_CLEARED_BALANCE);
+}
 
-    return( balance );
+gnc_numeric
+xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
+{
+    return xaccAccountGetXxxBalanceAsOfDate (acc, date,
+            ACCOUNT_RECONCILED_BALANCE);
 }
 
 /*
@@ -3221,7 +4029,8 @@ xaccAccountGetPresentBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (node = gnc_account_splits_node_at (priv, priv->n_splits - 1); node;
+            node = node->prev)
     {
         Split *split = node->data;
 
@@ -3346,6 +4155,7 @@ typedef struct
     xaccGetBalanceFn fn;
     xaccGetBalanceAsOfDateFn asOfDateFn;
     time64 date;
+    GArray *balances;
 } CurrencyBalance;
 
 
@@ -3363,9 +4173,7 @@ xaccAccountBalanceHelper (Account *acc, gpointer data)
     if (!cb->fn || !cb->currency)
         return;
     balance = xaccAccountGetXxxBalanceInCurrency (acc, cb->fn, cb->currency);
-    cb->balance = gnc_numeric_add (cb->balance, balance,
-                                   gnc_commodity_get_fraction (cb->currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
+    g_array_append_val (cb->balances, balance);
 }
 
 static void
@@ -3378,12 +4186,153 @@ xaccAccountBalanceAsOfDateHelper (Account *acc, gpointer data)
 
     balance = xaccAccountGetXxxBalanceAsOfDateInCurrency (
                   acc, cb->date, cb->asOfDateFn, cb->currency);
-    cb->balance = gnc_numeric_add (cb->balance, balance,
-                                   gnc_commodity_get_fraction (cb->currency),
-                                   GNC_HOW_RND_ROUND_HALF_UP);
+    g_array_append_val (cb->balances, balance);
+}
+
+/*
+ * Add the balances collected by the helpers above to cb->balance, in
+ * the currency's fraction, and free them.
+ */
+static gnc_numeric
+xaccAccountBalanceTotal (CurrencyBalance *cb)
+{
+    gnc_numeric total;
+
+    total = gnc_numeric_sum (cb->balance, (gnc_numeric *) cb->balances->data,
+                             cb->balances->len,
+                             gnc_commodity_get_fraction (cb->currency),
+                             GNC_HOW_RND_ROUND_HALF_UP);
+    g_array_free (cb->balances, TRUE);
+    cb->balances = NULL;
+    return total;
+}
+
+
+/*
+ * The balances of a subtree in one commodity; see subtree_balances in
+ * AccountP.h.
+ */
+typedef struct
+{
+    gnc_commodity *commodity;
+    gnc_numeric balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+} AccountSubtreeBalance;
+
+static void
+subtree_balance_add (GArray *balances, const AccountSubtreeBalance *add)
+{
+    AccountSubtreeBalance *b;
+    guint i;
+
+    for (i = 0; i < balances->len; i++)
+    {
+        b = &g_array_index (balances, AccountSubtreeBalance, i);
+        if (b->commodity != add->commodity)
+            continue;
+        b->balance = gnc_numeric_add (b->balance, add->balance,
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        b->cleared_balance =
+            gnc_numeric_add (b->cleared_balance, add->cleared_balance,
+                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        b->reconciled_balance =
+            gnc_numeric_add (b->reconciled_balance, add->reconciled_balance,
+                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        return;
+    }
+    g_array_append_vals (balances, add, 1);
 }
 
+/* Sum the subtree balances of acc, reusing those of its descendants
+ * that are still good.  The caller holds the book's cache lock, since
+ * threads reading the book share the sums. */
+static GArray *
+gnc_account_get_subtree_balances (const Account *acc)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    AccountSubtreeBalance own;
+    GList *node;
+    guint i;
+
+    if (priv->subtree_balances && !priv->subtree_dirty)
+        return priv->subtree_balances;
+
+    if (priv->subtree_balances)
+        g_array_set_size (priv->subtree_balances, 0);
+    else
+        priv->subtree_balances =
+            g_array_new (FALSE, FALSE, sizeof (AccountSubtreeBalance));
+
+    own.commodity = priv->commodity;
+    own.balance = priv->balance;
+    own.cleared_balance = priv->cleared_balance;
+    own.reconciled_balance = priv->reconciled_balance;
+    subtree_balance_add (priv->subtree_balances, &own);
+    for (node = priv->children; node; node = node->next)
+    {
+        GArray *child = gnc_account_get_subtree_balances (node->data);
+
+        for (i = 0; i < child->len; i++)
+            subtree_balance_add (priv->subtree_balances,
+                                 &g_array_index (child,
+                                                 AccountSubtreeBalance, i));
+    }
+    g_atomic_int_set (&priv->subtree_dirty, FALSE);
+    return priv->subtree_balances;
+}
+
+/*
+ * Sum the balances of acc and all its descendants in report_commodity
+ * from the subtree balances, converting each commodity once rather
+ * than each account.  Only the balances kept in the accounts can be
+ * summed this way; returns FALSE for any other fn.
+ */
+static gboolean
+xaccAccountGetSubtreeBalanceInCurrency (const Account *acc,
+                                        xaccGetBalanceFn fn,
+                                        const gnc_commodity *report_commodity,
+                                        gnc_numeric *result)
+{
+    QofBook *book = gnc_account_get_book (acc);
+    GArray *balances, *sums;
+    CurrencyBalance cb = { report_commodity, { 0 }, NULL, NULL, 0, NULL };
+    guint i;
+
+    if (fn != xaccAccountGetBalance && fn != xaccAccountGetClearedBalance &&
+            fn != xaccAccountGetReconciledBalance)
+        return FALSE;
 
+    qof_book_cache_lock (book);
+    balances = gnc_account_get_subtree_balances (acc);
+    sums = g_array_sized_new (FALSE, FALSE, sizeof (AccountSubtreeBalance),
+                              balances->len);
+    g_array_append_vals (sums, balances->data, balances->len);
+    qof_book_cache_unlock (book);
+
+    cb.balance = gnc_numeric_zero ();
+    cb.balances = g_array_new (FALSE, FALSE, sizeof (gnc_numeric));
+    for (i = 0; i < sums->len; i++)
+    {
+        AccountSubtreeBalance *b = &g_array_index (sums,
+                                   AccountSubtreeBalance, i);
+        gnc_numeric balance;
+
+        if (fn == xaccAccountGetBalance)
+            balance = b->balance;
+        else if (fn == xaccAccountGetClearedBalance)
+            balance = b->cleared_balance;
+        else
+            balance = b->reconciled_balance;
+        balance = xaccAccountConvertBalanceToCurrency (acc, balance,
+                  b->commodity,
+                  report_commodity);
+        g_array_append_val (cb.balances, balance);
+    }
+    g_array_free (sums, TRUE);
+    *result = xaccAccountBalanceTotal (&cb);
+    return TRUE;
+}
 
 /*
  * Common function that iterates recursively over all accounts below
@@ -3409,6 +4358,11 @@ xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
     if (!report_commodity)
         return gnc_numeric_zero();
 
+    if (include_children &&
+            xaccAccountGetSubtreeBalanceInCurrency (acc, fn, report_commodity,
+                    &balance))
+        return balance;
+
     balance = xaccAccountGetXxxBalanceInCurrency (acc, fn, report_commodity);
 
     /* If needed, sum up the children converting to the *requested*
@@ -3419,14 +4373,15 @@ xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
         /* MSVC compiler: Somehow, the struct initialization containing a
            gnc_numeric doesn't work. As an exception, we hand-initialize
            that member afterwards. */
-        CurrencyBalance cb = { report_commodity, { 0 }, fn, NULL, 0 };
+        CurrencyBalance cb = { report_commodity, { 0 }, fn, NULL, 0, NULL };
         cb.balance = balance;
 #else
-        CurrencyBalance cb = { report_commodity, balance, fn, NULL, 0 };
+        CurrencyBalance cb = { report_commodity, balance, fn, NULL, 0, NULL };
 #endif
 
+        cb.balances = g_array_new (FALSE, FALSE, sizeof (gnc_numeric));
         gnc_account_foreach_descendant (acc, xaccAccountBalanceHelper, &cb);
-        balance = cb.balance;
+        balance = xaccAccountBalanceTotal (&cb);
     }
 
     return balance;
@@ -3456,14 +4411,15 @@ xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
         /* MSVC compiler: Somehow, the struct initialization containing a
            gnc_numeric doesn't work. As an exception, we hand-initialize
            that member afterwards. */
-        CurrencyBalance cb = { report_commodity, 0, NULL, fn, date };
+        CurrencyBalance cb = { report_commodity, 0, NULL, fn, date, NULL };
         cb.balance = balance;
 #else
-        CurrencyBalance cb = { report_commodity, balance, NULL, fn, date };
+        CurrencyBalance cb = { report_commodity, balance, NULL, fn, date, NULL };
 #endif
 
+        cb.balances = g_array_new (FALSE, FALSE, sizeof (gnc_numeric));
         gnc_account_foreach_descendant (acc, xaccAccountBalanceAsOfDateHelper, &cb);
-        balance = cb.balance;
+        balance = xaccAccountBalanceTotal (&cb);
     }
 
     return balance;
@@ -3564,7 +4520,25 @@ xaccAccountGetSplitList (const Account *acc)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
-    return GET_PRIVATE(acc)->splits;
+    return GET_PRIVATE(acc)->split_list;
+}
+
+guint
+xaccAccountGetSplitsSize (const Account *acc)
+{
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+    return GET_PRIVATE(acc)->n_splits;
+}
+
+Split *
+xaccAccountGetSplitAt (const Account *acc, guint n)
+{
+    AccountPrivate *priv;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
+    priv = GET_PRIVATE(acc);
+    return gnc_account_splits_at (priv, n);
 }
 
 LotList *
@@ -3651,16 +4625,30 @@ xaccAccountSetTaxRelated (Account *acc, gboolean tax_related)
         new_value = NULL;
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_slot_nc(acc->inst.kvp_data, "tax-related", new_value);
+    kvp_frame_set_slot_nc(xaccAccountGetSlots (acc), "tax-related", new_value);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
 }
 
+/* The getters below get called for every account by the reports and
+ * the reconcile dialogs, so keep their key paths split up in a static
+ * KvpPath instead of parsing the string on every call. */
+static KvpValue *
+account_get_static_path_value (const Account *acc, gsize *path,
+                               const char *key_path)
+{
+    return kvp_frame_get_path_value (acc->inst.kvp_data,
+                                     kvp_path_get_static (path, key_path));
+}
+
 const char *
 xaccAccountGetTaxUSCode (const Account *acc)
 {
+    static gsize path = 0;
+
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
-    return kvp_frame_get_string(acc->inst.kvp_data, "tax-US/code");
+    return kvp_value_get_string(
+               account_get_static_path_value(acc, &path, "tax-US/code"));
 }
 
 void
@@ -3669,11 +4657,11 @@ xaccAccountSetTaxUSCode (Account *acc, const char *code)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_string (acc->inst.kvp_data, "/tax-US/code", code);
+    kvp_frame_set_string (xaccAccountGetSlots (acc), "/tax-US/code", code);
     if (!code)
     {
         KvpFrame  *frame = NULL;
-        kvp_frame_set_frame (acc->inst.kvp_data, "/tax-US", frame);
+        kvp_frame_set_frame (xaccAccountGetSlots (acc), "/tax-US", frame);
     }
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -3682,9 +4670,12 @@ xaccAccountSetTaxUSCode (Account *acc, const char *code)
 const char *
 xaccAccountGetTaxUSPayerNameSource (const Account *acc)
 {
+    static gsize path = 0;
+
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
-    return kvp_frame_get_string(acc->inst.kvp_data,
-                                "tax-US/payer-name-source");
+    return kvp_value_get_string(
+               account_get_static_path_value(acc, &path,
+                                             "tax-US/payer-name-source"));
 }
 
 void
@@ -3693,7 +4684,7 @@ xaccAccountSetTaxUSPayerNameSource (Account *acc, const char *source)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_string (acc->inst.kvp_data,
+    kvp_frame_set_string (xaccAccountGetSlots (acc),
                           "/tax-US/payer-name-source", source);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -3702,11 +4693,13 @@ xaccAccountSetTaxUSPayerNameSource (Account *acc, const char *source)
 gint64
 xaccAccountGetTaxUSCopyNumber (const Account *acc)
 {
+    static gsize path = 0;
     gint64 copy_number;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 1);
-    copy_number = kvp_frame_get_gint64(acc->inst.kvp_data,
-                                       "tax-US/copy-number");
+    copy_number = kvp_value_get_gint64(
+                      account_get_static_path_value(acc, &path,
+                                                    "tax-US/copy-number"));
     return (copy_number == 0) ? 1 : copy_number;
 }
 
@@ -3717,14 +4710,14 @@ xaccAccountSetTaxUSCopyNumber (Account *acc, gint64 copy_number)
 
     xaccAccountBeginEdit (acc);
     if (copy_number != 0)
-        kvp_frame_set_gint64 (acc->inst.kvp_data, "/tax-US/copy-number", copy_number);
+        kvp_frame_set_gint64 (xaccAccountGetSlots (acc), "/tax-US/copy-number", copy_number);
     else
     {
         KvpFrame * frame;
         KvpValue *value;
 
         value = NULL;
-        frame = kvp_frame_set_value_nc (acc->inst.kvp_data,
+        frame = kvp_frame_set_value_nc (xaccAccountGetSlots (acc),
                                         "/tax-US/copy-number", value);
         if (!frame) kvp_value_delete (value);
     }
@@ -3752,7 +4745,7 @@ xaccAccountSetPlaceholder (Account *acc, gboolean val)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_string (acc->inst.kvp_data,
+    kvp_frame_set_string (xaccAccountGetSlots (acc),
                           "placeholder", val ? "true" : NULL);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -3799,7 +4792,7 @@ xaccAccountSetHidden (Account *acc, gboolean val)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_string (acc->inst.kvp_data, "hidden",
+    kvp_frame_set_string (xaccAccountGetSlots (acc), "hidden",
                           val ? "true" : NULL);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -4054,11 +5047,12 @@ xaccAccountIsPriced(const Account *acc)
 gboolean
 xaccAccountGetReconcileLastDate (const Account *acc, time64 *last_date)
 {
+    static gsize path = 0;
     KvpValue *v;
 
     if (!acc) return FALSE;
 
-    v = kvp_frame_get_value(acc->inst.kvp_data, "reconcile-info/last-date");
+    v = account_get_static_path_value(acc, &path, "reconcile-info/last-date");
 
     if (!v || kvp_value_get_type(v) != KVP_TYPE_GINT64)
         return FALSE;
@@ -4078,7 +5072,7 @@ xaccAccountSetReconcileLastDate (Account *acc, time64 last_date)
     if (!acc) return;
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_gint64 (acc->inst.kvp_data,
+    kvp_frame_set_gint64 (xaccAccountGetSlots (acc),
                           "/reconcile-info/last-date", last_date);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -4091,14 +5085,15 @@ gboolean
 xaccAccountGetReconcileLastInterval (const Account *acc,
                                      int *months, int *days)
 {
+    static gsize months_path = 0, days_path = 0;
     KvpValue *v1, *v2;
 
     if (!acc) return FALSE;
 
-    v1 = kvp_frame_get_value(acc->inst.kvp_data,
-                             "reconcile-info/last-interval/months");
-    v2 = kvp_frame_get_value(acc->inst.kvp_data,
-                             "reconcile-info/last-interval/days");
+    v1 = account_get_static_path_value(acc, &months_path,
+                                       "reconcile-info/last-interval/months");
+    v2 = account_get_static_path_value(acc, &days_path,
+                                       "reconcile-info/last-interval/days");
     if (!v1 || (kvp_value_get_type (v1) != KVP_TYPE_GINT64) ||
             !v2 || (kvp_value_get_type (v2) != KVP_TYPE_GINT64))
         return FALSE;
@@ -4121,7 +5116,7 @@ xaccAccountSetReconcileLastInterval (Account *acc, int months, int days)
 
     xaccAccountBeginEdit (acc);
 
-    frame = kvp_frame_get_frame_slash (acc->inst.kvp_data,
+    frame = kvp_frame_get_frame_slash (xaccAccountGetSlots (acc),
                                        "/reconcile-info/last-interval");
     g_assert(frame);
 
@@ -4138,11 +5133,13 @@ xaccAccountSetReconcileLastInterval (Account *acc, int months, int days)
 gboolean
 xaccAccountGetReconcilePostponeDate (const Account *acc, time64 *postpone_date)
 {
+    static gsize path = 0;
     KvpValue *v;
 
     if (!acc) return FALSE;
 
-    v = kvp_frame_get_value(acc->inst.kvp_data, "reconcile-info/postpone/date");
+    v = account_get_static_path_value(acc, &path,
+                                      "reconcile-info/postpone/date");
     if (!v || kvp_value_get_type (v) != KVP_TYPE_GINT64)
         return FALSE;
 
@@ -4163,7 +5160,7 @@ xaccAccountSetReconcilePostponeDate (Account *acc, time64 postpone_date)
     xaccAccountBeginEdit (acc);
 
     /* XXX this should be using timespecs, not gints !! */
-    kvp_frame_set_gint64 (acc->inst.kvp_data,
+    kvp_frame_set_gint64 (xaccAccountGetSlots (acc),
                           "reconcile-info/postpone/date", postpone_date);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -4176,12 +5173,13 @@ gboolean
 xaccAccountGetReconcilePostponeBalance (const Account *acc,
                                         gnc_numeric *balance)
 {
+    static gsize path = 0;
     KvpValue *v;
 
     if (!acc) return FALSE;
 
-    v = kvp_frame_get_value(acc->inst.kvp_data,
-                            "reconcile-info/postpone/balance");
+    v = account_get_static_path_value(acc, &path,
+                                      "reconcile-info/postpone/balance");
     if (!v || kvp_value_get_type (v) != KVP_TYPE_NUMERIC)
         return FALSE;
 
@@ -4200,7 +5198,7 @@ xaccAccountSetReconcilePostponeBalance (Account *acc, gnc_numeric balance)
     if (!acc) return;
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_gnc_numeric (acc->inst.kvp_data,
+    kvp_frame_set_gnc_numeric (xaccAccountGetSlots (acc),
                                "/reconcile-info/postpone/balance", balance);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
@@ -4216,7 +5214,7 @@ xaccAccountClearReconcilePostpone (Account *acc)
     if (!acc) return;
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_value (acc->inst.kvp_data, "reconcile-info/postpone", NULL);
+    kvp_frame_set_value (xaccAccountGetSlots (acc), "reconcile-info/postpone", NULL);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
 }
@@ -4231,11 +5229,13 @@ xaccAccountClearReconcilePostpone (Account *acc)
 gboolean
 xaccAccountGetAutoInterestXfer (const Account *acc, gboolean default_value)
 {
+    static gsize path = 0;
     const char *str = NULL;
     if (!acc) return default_value;
 
-    str = kvp_frame_get_string(acc->inst.kvp_data,
-                               "reconcile-info/auto-interest-transfer");
+    str = kvp_value_get_string(
+              account_get_static_path_value(acc, &path,
+                                            "reconcile-info/auto-interest-transfer"));
     return str ? !strcmp(str, "true") : default_value;
 }
 
@@ -4249,7 +5249,7 @@ xaccAccountSetAutoInterestXfer (Account *acc, gboolean option)
 
     xaccAccountBeginEdit (acc);
     /* FIXME: need KVP_TYPE_BOOLEAN for this someday */
-    kvp_frame_set_string (acc->inst.kvp_data,
+    kvp_frame_set_string (xaccAccountGetSlots (acc),
                           "/reconcile-info/auto-interest-transfer",
                           (option ? "true" : "false"));
     mark_account (acc);
@@ -4274,7 +5274,7 @@ xaccAccountSetLastNum (Account *acc, const char *num)
     if (!acc) return;
 
     xaccAccountBeginEdit (acc);
-    kvp_frame_set_string(acc->inst.kvp_data, "last-num", num);
+    kvp_frame_set_string(xaccAccountGetSlots (acc), "last-num", num);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
 }
@@ -4290,7 +5290,7 @@ dxaccAccountSetPriceSrc(Account *acc, const char *src)
     xaccAccountBeginEdit(acc);
     if (xaccAccountIsPriced(acc))
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data,
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc),
                               "old-price-source",
                               src ? kvp_value_new_string(src) : NULL);
         mark_account (acc);
@@ -4328,7 +5328,7 @@ dxaccAccountSetQuoteTZ(Account *acc, const char *tz)
     xaccAccountBeginEdit(acc);
     if (xaccAccountIsPriced(acc))
     {
-        kvp_frame_set_slot_nc(acc->inst.kvp_data,
+        kvp_frame_set_slot_nc(xaccAccountGetSlots (acc),
                               "old-quote-tz",
                               tz ? kvp_value_new_string(tz) : NULL);
         mark_account (acc);
@@ -4364,7 +5364,7 @@ xaccAccountSetReconcileChildrenStatus(Account *acc, gboolean status)
     xaccAccountBeginEdit (acc);
 
     /* XXX FIXME: someday this should use KVP_TYPE_BOOLEAN */
-    kvp_frame_set_gint64 (acc->inst.kvp_data,
+    kvp_frame_set_gint64 (xaccAccountGetSlots (acc),
                           "/reconcile-info/include-children", status);
     mark_account(acc);
     xaccAccountCommitEdit (acc);
@@ -4380,8 +5380,12 @@ xaccAccountGetReconcileChildrenStatus(const Account *acc)
      * is found then we can assume not to include the children, that being
      * the default behaviour
      */
-    return acc ? kvp_frame_get_gint64(acc->inst.kvp_data,
-                                      "reconcile-info/include-children") : FALSE;
+    static gsize path = 0;
+
+    return acc ? kvp_value_get_gint64(
+               account_get_static_path_value(acc, &path,
+                                             "reconcile-info/include-children"))
+           : FALSE;
 }
 
 /********************************************************************\
@@ -4397,7 +5401,7 @@ finder_help_function(const Account *acc, const char *description,
                      Split **split, Transaction **trans )
 {
     AccountPrivate *priv;
-    GList *slp;
+    GList *node;
 
     /* First, make sure we set the data to NULL BEFORE we start */
     if (split) *split = NULL;
@@ -4410,9 +5414,10 @@ finder_help_function(const Account *acc, const char *description,
      * list is in date order, and the most recent matches should be
      * returned!?  */
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    for (node = gnc_account_splits_node_at (priv, priv->n_splits - 1); node;
+            node = node->prev)
     {
-        Split *lsplit = slp->data;
+        Split *lsplit = node->data;
         Transaction *ltrans = xaccSplitGetParent(lsplit);
 
         if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
@@ -4529,8 +5534,8 @@ gnc_account_merge_children (Account *parent)
             gnc_account_merge_children (acc_a);
 
             /* consolidate transactions */
-            while (priv_b->splits)
-                xaccSplitSetAccount (priv_b->splits->data, acc_a);
+            while (priv_b->split_list)
+                xaccSplitSetAccount (priv_b->split_list->data, acc_a);
 
             /* move back one before removal. next iteration around the loop
              * will get the node after node_b */
@@ -4572,7 +5577,7 @@ xaccAccountBeginStagedTransactionTraversals (const Account *account)
     if (!account)
         return;
     priv = GET_PRIVATE(account);
-    xaccSplitsBeginStagedTransactionTraversals(priv->splits);
+    xaccSplitsBeginStagedTransactionTraversals(priv->split_list);
 }
 
 gboolean
@@ -4598,7 +5603,7 @@ static void do_one_split (Split *s, gpointer data)
 static void do_one_account (Account *account, gpointer data)
 {
     AccountPrivate *priv = GET_PRIVATE(account);
-    g_list_foreach(priv->splits, (GFunc)do_one_split, NULL);
+    g_list_foreach(priv->split_list, (GFunc)do_one_split, NULL);
 }
 
 /* Replacement for xaccGroupBeginStagedTransactionTraversals */
@@ -4628,7 +5633,7 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
     if (!acc) return 0;
 
     priv = GET_PRIVATE(acc);
-    for (split_p = priv->splits; split_p; split_p = next)
+    for (split_p = priv->split_list; split_p; split_p = next)
     {
         /* Get the next element in the split list now, just in case some
          * naughty thunk destroys the one we're using. This reduces, but
@@ -4676,7 +5681,7 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
-    for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
+    for (split_p = priv->split_list; split_p; split_p = g_list_next(split_p))
     {
         s = split_p->data;
         trans = s->parent;
@@ -4737,6 +5742,113 @@ gnc_account_book_end(QofBook* book)
 #else
 # define DI(x) x
 #endif
+static gboolean
+gnc_account_foreach_dependent (gpointer instance, QofIdTypeConst dep_type,
+                               QofInstanceForeachCB cb, gpointer user_data)
+{
+    AccountPrivate *priv = GET_PRIVATE (instance);
+    GList *node;
+
+    if (g_strcmp0 (dep_type, GNC_ID_SPLIT)) return FALSE;
+    for (node = priv->split_list; node; node = node->next)
+        cb (node->data, user_data);
+    return TRUE;
+}
+
+/* Accounts with fewer splits than this between them are sorted and
+ * balanced on the calling thread when a bulk load ends. */
+#define BULK_LOAD_PARALLEL_SPLITS 10000
+
+typedef struct
+{
+    QofBook *book;
+    gboolean action_for_num;
+} BulkLoadData;
+
+static void
+collect_account_cb (QofInstance *inst, gpointer user_data)
+{
+    if (!qof_instance_get_destroying (inst))
+        g_ptr_array_add (user_data, inst);
+}
+
+static void
+bulk_load_finish_account (gpointer data, gpointer user_data)
+{
+    BulkLoadData *bulk = user_data;
+    AccountPrivate *priv = GET_PRIVATE (data);
+
+    gnc_account_sort_splits_unlocked (priv, bulk->action_for_num);
+    gnc_account_recompute_balance_unlocked (priv);
+}
+
+/* A worker thread; see gnc_account_bulk_load_end(). */
+static void
+bulk_load_finish_account_reading (gpointer data, gpointer user_data)
+{
+    BulkLoadData *bulk = user_data;
+
+    qof_book_read_lock (bulk->book);
+    bulk_load_finish_account (data, user_data);
+    qof_book_read_unlock (bulk->book);
+}
+
+/* Sort the splits of every account and compute its balances, which
+ * gnc_account_insert_split() left undone while the book was loaded.
+ * Each account is done by one thread alone, so the accounts can be
+ * shared out between the processors.  The workers read the book, so
+ * they compare splits without filling in the sort keys of transactions
+ * that are in several accounts; they can't read it if this thread is
+ * still writing it, though, and then it does all the work itself. */
+static void
+gnc_account_bulk_load_end (QofBook *book)
+{
+    GPtrArray *accounts = g_ptr_array_new ();
+    BulkLoadData bulk;
+    guint i, n_splits = 0, n_threads;
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            collect_account_cb, accounts);
+    for (i = 0; i < accounts->len; i++)
+    {
+        AccountPrivate *priv = GET_PRIVATE (g_ptr_array_index (accounts, i));
+
+        priv->sort_dirty = TRUE;
+        gnc_account_balance_dirty_from (priv, 0);
+        n_splits += priv->n_splits;
+    }
+
+    bulk.book = book;
+    bulk.action_for_num = qof_book_use_split_action_for_num_field (book);
+    n_threads = MIN (qof_get_num_processors (), accounts->len);
+    if (n_threads > 1 && n_splits >= BULK_LOAD_PARALLEL_SPLITS &&
+            !qof_book_is_writing (book)
+#ifndef HAVE_GLIB_2_32
+            && g_thread_supported ()
+#endif
+       )
+    {
+        GThreadPool *pool;
+
+        pool = g_thread_pool_new (bulk_load_finish_account_reading, &bulk,
+                                  n_threads, FALSE, NULL);
+        for (i = 0; i < accounts->len; i++)
+            g_thread_pool_push (pool, g_ptr_array_index (accounts, i), NULL);
+        /* Wait for all of them */
+        g_thread_pool_free (pool, FALSE, TRUE);
+    }
+    else
+    {
+        for (i = 0; i < accounts->len; i++)
+            bulk_load_finish_account (g_ptr_array_index (accounts, i), &bulk);
+    }
+    PINFO ("sorted %u splits in %u accounts", n_splits, accounts->len);
+
+    for (i = 0; i < accounts->len; i++)
+        qof_event_gen (g_ptr_array_index (accounts, i), QOF_EVENT_MODIFY, NULL);
+    g_ptr_array_free (accounts, TRUE);
+}
+
 static QofObject account_object_def =
 {
     DI(.interface_version = ) QOF_OBJECT_VERSION,
@@ -4750,6 +5862,9 @@ static QofObject account_object_def =
     DI(.foreach           = ) qof_collection_foreach,
     DI(.printable         = ) (const char * (*)(gpointer)) xaccAccountGetName,
     DI(.version_cmp       = ) (int (*)(gpointer, gpointer)) qof_instance_version_cmp,
+    DI(.index_lookup      = ) NULL,
+    DI(.foreach_dependent = ) gnc_account_foreach_dependent,
+    DI(.bulk_load_end     = ) gnc_account_bulk_load_end,
 };
 
 gboolean xaccAccountRegister (void)
@@ -4846,7 +5961,7 @@ gboolean xaccAccountRegister (void)
         },
         {
             ACCOUNT_KVP, QOF_TYPE_KVP,
-            (QofAccessFunc) qof_instance_get_slots, NULL
+            (QofAccessFunc) qof_instance_peek_slots, NULL
         },
         { NULL },
     };
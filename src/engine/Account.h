@@ -344,6 +344,17 @@ void gnc_account_set_start_reconciled_balance (Account *acc,
  *  @param acc Set the flag on this account. */
 void gnc_account_set_balance_dirty (Account *acc);
 
+/** Tell the account that the running balances from the given split
+ *  onwards may be incorrect, e.g. because the split's amount or
+ *  reconcile state changed.  The balances of earlier splits are kept.
+ *  If the split isn't in the account this is the same as
+ *  gnc_account_set_balance_dirty().
+ *
+ *  @param acc Set the flag on this account.
+ *
+ *  @param split The first split whose running balance is incorrect. */
+void gnc_account_set_split_balance_dirty (Account *acc, const Split *split);
+
 /** Tell the account believes that the splits may be incorrectly
  *  sorted and need to be resorted.
  *
@@ -392,13 +403,15 @@ const char * xaccAccountGetLastNum (const Account *account);
 GNCPolicy *gnc_account_get_policy (Account *account);
 
 /** The following recompute the partial balances (stored with the
- *  transaction) and the total balance, for this account
+ *  transaction) and the total balance, for this account.  While the
+ *  book is loaded in bulk this is left until the load ends.
  */
 void xaccAccountRecomputeBalance (Account *);
 
 /** The xaccAccountSortSplits() routine will resort the account's
  *  splits if the sort is dirty. If 'force' is true, the account
- *  is sorted even if the editlevel is not zero.
+ *  is sorted even if the editlevel is not zero, and even while the
+ *  book is loaded in bulk, when its balances are recomputed too.
  */
 void xaccAccountSortSplits (Account *acc, gboolean force);
 
@@ -533,6 +546,14 @@ gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
 /** Get the balance of the account as of the date specified */
 gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
         time64 date);
+/** Get the balance of the account as of the date specified, only
+    including cleared transactions */
+gnc_numeric xaccAccountGetClearedBalanceAsOfDate (Account *account,
+        time64 date);
+/** Get the balance of the account as of the date specified, only
+    including reconciled transactions */
+gnc_numeric xaccAccountGetReconciledBalanceAsOfDate (Account *account,
+        time64 date);
 
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
@@ -961,6 +982,15 @@ guint32 xaccAccountTypesValid(void);
  */
 SplitList* xaccAccountGetSplitList (const Account *account);
 
+/** The xaccAccountGetSplitsSize() routine returns the number of splits
+ *    in the account. */
+guint xaccAccountGetSplitsSize (const Account *account);
+
+/** The xaccAccountGetSplitAt() routine returns the split at position
+ *    @a n of the account, in the same order as xaccAccountGetSplitList(),
+ *    or NULL if @a n is out of range.  This is a constant time lookup. */
+Split* xaccAccountGetSplitAt (const Account *account, guint n);
+
 /** The xaccAccountMoveAllSplits() routine reassigns each of the splits
  *  in accfrom to accto. */
 void xaccAccountMoveAllSplits (Account *accfrom, Account *accto);
@@ -45,6 +45,19 @@
 
 /** STRUCTS *********************************************************/
 
+/** The number of splits one chunk of an account's split array holds. */
+#define SPLIT_CHUNK_SIZE 256
+
+/** One piece of an account's split array: the split_list nodes of up to
+ *  SPLIT_CHUNK_SIZE consecutive splits. */
+typedef struct split_chunk_s
+{
+    struct AccountPrivate *owner;
+    guint index;                /* position in owner->split_chunks */
+    guint len;
+    GList *nodes[SPLIT_CHUNK_SIZE];
+} SplitChunk;
+
 /** This is the data that describes an account.
  *
  * This is the *private* header for the account structure.
@@ -98,6 +111,14 @@ typedef struct AccountPrivate
     Account *parent;    /* back-pointer to parent */
     GList *children;    /* list of sub-accounts */
 
+    /* The full name and its collation key, for sorting splits by
+     * account.  They are made when first wanted and remade once
+     * full_name_generation falls behind the count of account renames
+     * and moves anywhere in the tree. */
+    gchar *full_name;
+    gchar *full_name_key;
+    guint full_name_generation;
+
     /* protected data - should only be set by backends */
     gnc_numeric starting_balance;
     gnc_numeric starting_cleared_balance;
@@ -109,8 +130,37 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
-
-    GList *splits;              /* list of split pointers */
+    /* Position of the first split whose running balance is incorrect.
+     * The running balances of the splits before it are still good, so
+     * xaccAccountRecomputeBalance only needs to start from here. */
+    guint balance_dirty_from;
+
+    /* The balances of the account and all its descendants, summed for
+     * each commodity but not converted, from which the *InCurrency
+     * routines roll up a subtree.  They are summed when first wanted
+     * and again once subtree_dirty is set, which happens whenever the
+     * balances of the account or a descendant change or an account is
+     * moved into or out of the subtree.  No account is clean while
+     * one below it is dirty. */
+    GArray *subtree_balances;   /* of AccountSubtreeBalance */
+    gboolean subtree_dirty;
+
+    /* The splits are kept in xaccSplitOrder order (unless sort_dirty
+     * is set) in split_list, which xaccAccountGetSplitList returns,
+     * and indexed by a chunked array of its nodes.  Each chunk holds up
+     * to SPLIT_CHUNK_SIZE nodes and each split points back at its
+     * chunk, which answers membership.  split_chunk_tree is a Fenwick
+     * tree of the chunks' lengths, which turns a position into a chunk
+     * and back in O(log n).  An insert binary searches for its place,
+     * moves at most one chunk's worth of nodes and updates the tree,
+     * all O(log n); a chunk that fills up is split in two, which costs
+     * a pass over the chunks but only comes once in SPLIT_CHUNK_SIZE/2
+     * inserts.  The as-of-date balance routines binary search over the
+     * running balances cached in each split. */
+    GPtrArray *split_chunks;    /* of SplitChunk, in order */
+    guint *split_chunk_tree;    /* Fenwick tree of the chunk lengths */
+    guint n_splits;
+    GList *split_list;          /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
     LotList   *lots;		/* list of lot pointers */
@@ -132,9 +182,34 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Copy the account's own fields for a book snapshot, and free the
+ * copy.  See gnc-book-snapshot.h. */
+Account *xaccDupeAccount (const Account *from);
+void xaccFreeDupeAccount (Account *acc);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
+/* Return a newly allocated list of the splits in the account whose
+ * transactions were posted within the given range, in date order.  The
+ * range is found by binary search over the sorted splits.  A NULL start
+ * or end leaves that side of the range open; the inclusive flags say
+ * whether splits posted exactly on the bound are wanted.  Used by the
+ * split query index. */
+SplitList * gnc_account_get_splits_in_date_range (Account *acc,
+        const Timespec *start,
+        gboolean start_inclusive,
+        const Timespec *end,
+        gboolean end_inclusive);
+
+/* The account's full name, as gnc_account_get_full_name() returns
+ * it, and its g_utf8_collate_key(), both kept in the account so that
+ * sorting splits by account doesn't build the names over and over.
+ * The strings belong to the account and are good until an account is
+ * next renamed or moved. */
+const gchar *gnc_account_get_cached_full_name (const Account *acc);
+const gchar *gnc_account_get_full_name_collate_key (const Account *acc);
+
 /* Structure for accessing static functions for testing */
 typedef struct
 {
@@ -1139,10 +1139,10 @@ xaccAccountDeleteOldData (Account *account)
     if (!account) return;
     xaccAccountBeginEdit (account);
 
-    kvp_frame_set_slot_nc (account->inst.kvp_data, "old-currency", NULL);
-    kvp_frame_set_slot_nc (account->inst.kvp_data, "old-security", NULL);
-    kvp_frame_set_slot_nc (account->inst.kvp_data, "old-currency-scu", NULL);
-    kvp_frame_set_slot_nc (account->inst.kvp_data, "old-security-scu", NULL);
+    kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "old-currency", NULL);
+    kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "old-security", NULL);
+    kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "old-currency-scu", NULL);
+    kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "old-security-scu", NULL);
     qof_instance_set_dirty (QOF_INSTANCE (account));
     xaccAccountCommitEdit (account);
 }
@@ -1254,18 +1254,18 @@ xaccAccountScrubKvp (Account *account)
     {
         str2 = g_strstrip(g_strdup(str));
         if (strlen(str2) == 0)
-            kvp_frame_set_slot_nc (account->inst.kvp_data, "notes", NULL);
+            kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "notes", NULL);
         g_free(str2);
     }
 
     str = kvp_frame_get_string(account->inst.kvp_data, "placeholder");
     if (str && strcmp(str, "false") == 0)
-        kvp_frame_set_slot_nc (account->inst.kvp_data, "placeholder", NULL);
+        kvp_frame_set_slot_nc (xaccAccountGetSlots (account), "placeholder", NULL);
 
     frame = kvp_frame_get_frame(account->inst.kvp_data, "hbci");
     if (frame && kvp_frame_is_empty(frame))
     {
-        kvp_frame_set_frame_nc(account->inst.kvp_data, "hbci", NULL);
+        kvp_frame_set_frame_nc(xaccAccountGetSlots (account), "hbci", NULL);
     }
 }
 
@@ -271,7 +271,7 @@ remove_guids (Split *sa, Split *sb)
 
     /* Finally, merge b's lot-splits, if any, into a's */
     /* This is an important step, if it got busted into many pieces. */
-    gnc_kvp_bag_merge (sa->inst.kvp_data, "lot-split",
+    gnc_kvp_bag_merge (xaccSplitGetSlots (sa), "lot-split",
                        sb->inst.kvp_data, "lot-split");
 }
 
@@ -28,6 +28,7 @@
 
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #ifdef HAVE_SYS_TIME_H
@@ -40,6 +41,8 @@
 
 #include "qof.h"
 #include "qofbook.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
 #include "Split.h"
 #include "AccountP.h"
 #include "Scrub.h"
@@ -336,7 +339,7 @@ xaccSplitReinit(Split * split)
 
     if (split->inst.kvp_data)
         kvp_frame_delete(split->inst.kvp_data);
-    split->inst.kvp_data = kvp_frame_new();
+    split->inst.kvp_data = NULL;
     qof_instance_set_idata(split, 0);
 
     split->gains = GAINS_STATUS_UNKNOWN;
@@ -388,7 +391,8 @@ xaccDupeSplit (const Split *s)
     split->memo = CACHE_INSERT(s->memo);
     split->action = CACHE_INSERT(s->action);
 
-    split->inst.kvp_data = kvp_frame_copy (s->inst.kvp_data);
+    if (s->inst.kvp_data)
+        split->inst.kvp_data = kvp_frame_copy (s->inst.kvp_data);
 
     split->reconciled = s->reconciled;
     split->date_reconciled = s->date_reconciled;
@@ -426,7 +430,8 @@ xaccSplitClone (const Split *s)
 
     qof_instance_init_data(&split->inst, GNC_ID_SPLIT, qof_instance_get_book(s));
     kvp_frame_delete(split->inst.kvp_data);
-    split->inst.kvp_data = kvp_frame_copy(s->inst.kvp_data);
+    split->inst.kvp_data = s->inst.kvp_data ?
+                           kvp_frame_copy(s->inst.kvp_data) : NULL;
 
     xaccAccountInsertSplit(s->acc, split);
     if (s->lot)
@@ -503,6 +508,20 @@ xaccSplitDump (const Split *split, const char *tag)
 /********************************************************************\
 \********************************************************************/
 
+static void
+split_free_sort_key (Split *split)
+{
+    SplitSortKey *key = split->sort_key;
+
+    if (!key) return;
+    CACHE_REMOVE(key->memo);
+    CACHE_REMOVE(key->action);
+    g_free (key->memo_key);
+    g_free (key->action_key);
+    g_slice_free (SplitSortKey, key);
+    split->sort_key = NULL;
+}
+
 void
 xaccFreeSplit (Split *split)
 {
@@ -516,6 +535,7 @@ xaccFreeSplit (Split *split)
     }
     CACHE_REMOVE(split->memo);
     CACHE_REMOVE(split->action);
+    split_free_sort_key (split);
 
     /* Just in case someone looks up freed memory ... */
     split->memo        = (char *) 1;
@@ -544,7 +564,8 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_split_balance_dirty (s->acc, s);
+        gnc_account_set_sort_dirty (s->acc);
     }
 
     /* set dirty flag on lot too. */
@@ -619,13 +640,14 @@ xaccSplitEqual(const Split *sa, const Split *sb,
         return FALSE;
     }
 
-    if (kvp_frame_compare(sa->inst.kvp_data, sb->inst.kvp_data) != 0)
+    if (kvp_frame_compare(qof_instance_peek_slots (QOF_INSTANCE (sa)),
+                          qof_instance_peek_slots (QOF_INSTANCE (sb))) != 0)
     {
         char *frame_a;
         char *frame_b;
 
-        frame_a = kvp_frame_to_string (sa->inst.kvp_data);
-        frame_b = kvp_frame_to_string (sb->inst.kvp_data);
+        frame_a = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (sa)));
+        frame_b = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (sb)));
 
         PINFO ("kvp frames differ:\n%s\n\nvs\n\n%s", frame_a, frame_b);
 
@@ -831,7 +853,8 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_split_balance_dirty (acc, s);
+        gnc_account_set_sort_dirty (acc);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -887,34 +910,49 @@ xaccSplitLookup (const GncGUID *guid, QofBook *book)
 void
 xaccSplitDetermineGainStatus (Split *split)
 {
+    QofBook *book;
     Split *other;
     KvpValue *val;
+    gint gains;
 
-    if (GAINS_STATUS_UNKNOWN != split->gains) return;
+    if (GAINS_STATUS_UNKNOWN != g_atomic_int_get (&split->gains)) return;
 
-    other = xaccSplitGetCapGainsSplit (split);
-    if (other)
+    /* Threads reading the book may ask at once; the first one works the
+     * status out, and publishes it only once gains_split is set. */
+    book = qof_instance_get_book (split);
+    qof_book_cache_lock (book);
+    if (GAINS_STATUS_UNKNOWN != split->gains)
     {
-        split->gains = GAINS_STATUS_A_VDIRTY | GAINS_STATUS_DATE_DIRTY;
-        split->gains_split = other;
+        qof_book_cache_unlock (book);
         return;
     }
 
-    val = kvp_frame_get_slot (split->inst.kvp_data, "gains-source");
-    if (!val)
+    other = xaccSplitGetCapGainsSplit (split);
+    if (other)
     {
-        // CHECKME: We leave split->gains_split alone.  Is that correct?
-        split->gains = GAINS_STATUS_A_VDIRTY | GAINS_STATUS_DATE_DIRTY;
+        gains = GAINS_STATUS_A_VDIRTY | GAINS_STATUS_DATE_DIRTY;
+        split->gains_split = other;
     }
     else
     {
-        QofCollection *col;
-        col = qof_book_get_collection (qof_instance_get_book(split), GNC_ID_SPLIT);
-        split->gains = GAINS_STATUS_GAINS;
-        other = (Split *) qof_collection_lookup_entity (col,
-                kvp_value_get_guid (val));
-        split->gains_split = other;
+        val = kvp_frame_get_slot (split->inst.kvp_data, "gains-source");
+        if (!val)
+        {
+            // CHECKME: We leave split->gains_split alone.  Is that correct?
+            gains = GAINS_STATUS_A_VDIRTY | GAINS_STATUS_DATE_DIRTY;
+        }
+        else
+        {
+            QofCollection *col;
+            col = qof_book_get_collection (book, GNC_ID_SPLIT);
+            gains = GAINS_STATUS_GAINS;
+            other = (Split *) qof_collection_lookup_entity (col,
+                    kvp_value_get_guid (val));
+            split->gains_split = other;
+        }
     }
+    g_atomic_int_set (&split->gains, gains);
+    qof_book_cache_unlock (book);
 }
 
 /********************************************************************\
@@ -1295,41 +1333,122 @@ xaccSplitDestroy (Split *split)
 /********************************************************************\
 \********************************************************************/
 
+/* Bring the split's sort key up to date with its strings.  The key
+ * is a cache, so it is remade even for a const split. */
+static SplitSortKey *
+split_get_sort_key (const Split *s)
+{
+    SplitSortKey *key = s->sort_key;
+
+    if (!key)
+        key = ((Split *) s)->sort_key = g_slice_new0 (SplitSortKey);
+    if (key->memo != s->memo)
+    {
+        CACHE_REPLACE(key->memo, s->memo);
+        g_free (key->memo_key);
+        key->memo_key = NULL;
+    }
+    if (key->action != s->action)
+    {
+        CACHE_REPLACE(key->action, s->action);
+        g_free (key->action_key);
+        key->action_key = NULL;
+        key->action_num = s->action ? atoi (s->action) : 0;
+    }
+    return key;
+}
+
+static const gchar *
+split_get_memo_key (const Split *s)
+{
+    SplitSortKey *key = split_get_sort_key (s);
+
+    if (!key->memo_key)
+        key->memo_key = g_utf8_collate_key (s->memo ? s->memo : "", -1);
+    return key->memo_key;
+}
+
+static const gchar *
+split_get_action_key (const Split *s)
+{
+    SplitSortKey *key = split_get_sort_key (s);
+
+    if (!key->action_key)
+        key->action_key = g_utf8_collate_key (s->action ? s->action : "", -1);
+    return key->action_key;
+}
+
+/* Threads reading the book share its splits, so they compare the
+ * strings themselves rather than fill in the sort keys. */
+static int
+split_compare_memos (const Split *sa, const Split *sb, gboolean keyed)
+{
+    if (keyed)
+        return strcmp (split_get_memo_key (sa), split_get_memo_key (sb));
+    return g_utf8_collate (sa->memo ? sa->memo : "", sb->memo ? sb->memo : "");
+}
+
+static int
+split_compare_actions (const Split *sa, const Split *sb, gboolean keyed)
+{
+    if (keyed)
+        return strcmp (split_get_action_key (sa), split_get_action_key (sb));
+    return g_utf8_collate (sa->action ? sa->action : "",
+                           sb->action ? sb->action : "");
+}
+
+static int
+split_action_num (const Split *s, gboolean keyed)
+{
+    return keyed ? split_get_sort_key (s)->action_num : atoi (s->action);
+}
+
 gint
 xaccSplitOrder (const Split *sa, const Split *sb)
+{
+    if (sa == sb) return 0;
+    /* nothing is always less than something */
+    if (!sa) return -1;
+    if (!sb) return +1;
+
+    return xaccSplitOrderForNum (sa, sb,
+                                 qof_book_use_split_action_for_num_field
+                                 (xaccSplitGetBook (sa)));
+}
+
+gint
+xaccSplitOrderForNum (const Split *sa, const Split *sb,
+                      gboolean action_for_num)
 {
     int retval;
     int comp;
-    char *da, *db;
-    gboolean action_for_num;
+    gboolean keyed;
 
     if (sa == sb) return 0;
     /* nothing is always less than something */
     if (!sa) return -1;
     if (!sb) return +1;
 
+    keyed = !qof_book_is_reading (xaccSplitGetBook (sa));
+
     /* sort in transaction order, but use split action rather than trans num
      * according to book option */
-    action_for_num = qof_book_use_split_action_for_num_field
-                                                        (xaccSplitGetBook (sa));
-    if (action_for_num)
-        retval = xaccTransOrder_num_action (sa->parent, sa->action,
-                                            sb->parent, sb->action);
+    if (action_for_num && sa->action && sb->action)
+        retval = xaccTransOrderNums (sa->parent, split_action_num (sa, keyed),
+                                     sb->parent, split_action_num (sb, keyed),
+                                     TRUE);
     else
         retval = xaccTransOrder (sa->parent, sb->parent);
     if (retval) return retval;
 
-    /* otherwise, sort on memo strings */
-    da = sa->memo ? sa->memo : "";
-    db = sb->memo ? sb->memo : "";
-    retval = g_utf8_collate (da, db);
+    /* otherwise, sort on memo strings; the collation keys compare with
+     * strcmp() as the strings do with g_utf8_collate() */
+    retval = split_compare_memos (sa, sb, keyed);
     if (retval)
         return retval;
 
     /* otherwise, sort on action strings */
-    da = sa->action ? sa->action : "";
-    db = sb->action ? sb->action : "";
-    retval = g_utf8_collate (da, db);
+    retval = split_compare_actions (sa, sb, keyed);
     if (retval != 0)
         return retval;
 
@@ -1471,25 +1590,17 @@ xaccSplitGetCorrAccountCode(const Split *sa)
     return xaccAccountGetCode(other_split->acc);
 }
 
-/* TODO: It's not too hard to make this function avoid the malloc/free. */
 int
 xaccSplitCompareAccountFullNames(const Split *sa, const Split *sb)
 {
-    Account *aa, *ab;
-    char *full_a, *full_b;
-    int retval;
     if (!sa && !sb) return 0;
     if (!sa) return -1;
     if (!sb) return 1;
 
-    aa = sa->acc;
-    ab = sb->acc;
-    full_a = gnc_account_get_full_name(aa);
-    full_b = gnc_account_get_full_name(ab);
-    retval = g_utf8_collate(full_a, full_b);
-    g_free(full_a);
-    g_free(full_b);
-    return retval;
+    /* The collation keys compare with strcmp() as the full names do
+     * with g_utf8_collate(), and the accounts keep them. */
+    return strcmp (gnc_account_get_full_name_collate_key (sa->acc),
+                   gnc_account_get_full_name_collate_key (sb->acc));
 }
 
 
@@ -1507,11 +1618,26 @@ xaccSplitCompareAccountCodes(const Split *sa, const Split *sb)
     return g_strcmp0(xaccAccountGetCode(aa), xaccAccountGetCode(ab));
 }
 
+/* xaccSplitGetCorrAccountFullName() without the copy, for sorting. */
+static const char *
+split_peek_corr_account_full_name (const Split *sa)
+{
+    static const char *split_const = NULL;
+    const Split *other_split;
+
+    if (!get_corr_account_split(sa, &other_split))
+    {
+        if (!split_const)
+            split_const = _("-- Split Transaction --");
+
+        return split_const;
+    }
+    return gnc_account_get_cached_full_name (other_split->acc);
+}
+
 int
 xaccSplitCompareOtherAccountFullNames(const Split *sa, const Split *sb)
 {
-    char *ca, *cb;
-    int retval;
     if (!sa && !sb) return 0;
     if (!sa) return -1;
     if (!sb) return 1;
@@ -1520,12 +1646,8 @@ xaccSplitCompareOtherAccountFullNames(const Split *sa, const Split *sb)
      * as long as they are the same
      */
 
-    ca = xaccSplitGetCorrAccountFullName(sa);
-    cb = xaccSplitGetCorrAccountFullName(sb);
-    retval = g_strcmp0(ca, cb);
-    g_free(ca);
-    g_free(cb);
-    return retval;
+    return g_strcmp0 (split_peek_corr_account_full_name (sa),
+                      split_peek_corr_account_full_name (sb));
 }
 
 int
@@ -1840,7 +1962,7 @@ xaccSplitMakeStockSplit(Split *s)
     xaccTransBeginEdit (s->parent);
 
     s->value = gnc_numeric_zero();
-    kvp_frame_set_str(s->inst.kvp_data, "split-type", "stock-split");
+    kvp_frame_set_str(xaccSplitGetSlots (s), "split-type", "stock-split");
     SET_GAINS_VDIRTY(s);
     mark_split(s);
     qof_instance_set_dirty(QOF_INSTANCE(s));
@@ -1936,7 +2058,7 @@ void
 xaccSplitVoid(Split *split)
 {
     gnc_numeric zero = gnc_numeric_zero();
-    KvpFrame *frame = split->inst.kvp_data;
+    KvpFrame *frame = xaccSplitGetSlots (split);
 
     kvp_frame_set_gnc_numeric(frame, void_former_amt_str,
                               xaccSplitGetAmount(split));
@@ -1952,7 +2074,7 @@ xaccSplitVoid(Split *split)
 void
 xaccSplitUnvoid(Split *split)
 {
-    KvpFrame *frame = split->inst.kvp_data;
+    KvpFrame *frame = xaccSplitGetSlots (split);
 
     xaccSplitSetAmount (split, xaccSplitVoidFormerAmount(split));
     xaccSplitSetValue (split, xaccSplitVoidFormerValue(split));
@@ -1968,6 +2090,165 @@ xaccSplitUnvoid(Split *split)
 
 /* Hook into the QofObject registry */
 
+/* Compare a term's parameter path with a NULL-terminated list of names. */
+static gboolean
+param_path_is (const QofQueryParamList *path, ...)
+{
+    const char *name;
+    va_list ap;
+    gboolean match = TRUE;
+
+    va_start (ap, path);
+    for (name = va_arg (ap, const char *); name;
+            name = va_arg (ap, const char *), path = path->next)
+    {
+        if (!path || g_strcmp0 (path->data, name))
+        {
+            match = FALSE;
+            break;
+        }
+    }
+    va_end (ap);
+    return match && !path;
+}
+
+/* Narrow [*start, *end] by a posted-date term.  Only plain comparisons
+ * of the whole timestamp are understood. */
+static gboolean
+split_index_date_term (const QofQueryTerm *qt,
+                       Timespec *start, gboolean *have_start,
+                       gboolean *start_incl,
+                       Timespec *end, gboolean *have_end, gboolean *end_incl)
+{
+    const query_date_def *pdata =
+        (const query_date_def *) qof_query_term_get_pred_data (qt);
+    gboolean lower = FALSE, upper = FALSE, incl = TRUE;
+
+    if (qof_query_term_is_inverted (qt) ||
+            g_strcmp0 (pdata->pd.type_name, QOF_TYPE_DATE) ||
+            pdata->options != QOF_DATE_MATCH_NORMAL)
+        return FALSE;
+
+    switch (pdata->pd.how)
+    {
+    case QOF_COMPARE_LT:
+        incl = FALSE;
+        /* fall through */
+    case QOF_COMPARE_LTE:
+        upper = TRUE;
+        break;
+    case QOF_COMPARE_GT:
+        incl = FALSE;
+        /* fall through */
+    case QOF_COMPARE_GTE:
+        lower = TRUE;
+        break;
+    case QOF_COMPARE_EQUAL:
+        lower = upper = TRUE;
+        break;
+    default:
+        return FALSE;
+    }
+
+    if (lower)
+    {
+        int cmp = *have_start ? timespec_cmp (&pdata->date, start) : 1;
+        if (cmp > 0 || (cmp == 0 && !incl))
+        {
+            *start = pdata->date;
+            *start_incl = incl;
+        }
+        *have_start = TRUE;
+    }
+    if (upper)
+    {
+        int cmp = *have_end ? timespec_cmp (&pdata->date, end) : -1;
+        if (cmp < 0 || (cmp == 0 && !incl))
+        {
+            *end = pdata->date;
+            *end_incl = incl;
+        }
+        *have_end = TRUE;
+    }
+    return TRUE;
+}
+
+/* The query planner's hook: splits are indexed by account, and within
+ * an account by posted date, so a branch that asks for the splits of
+ * some accounts can be answered without looking at the rest of the
+ * book. */
+static gboolean
+split_index_lookup (QofBook *book, GList *and_terms,
+                    GList **used_terms, GList **candidates)
+{
+    const query_guid_def *acct_pdata = NULL;
+    QofQueryTerm *acct_term = NULL;
+    GList *date_terms = NULL, *node, *seen_guids = NULL;
+    Timespec start = {0, 0}, end = {0, 0};
+    gboolean have_start = FALSE, have_end = FALSE;
+    gboolean start_incl = TRUE, end_incl = TRUE;
+
+    *used_terms = NULL;
+    *candidates = NULL;
+
+    for (node = and_terms; node; node = node->next)
+    {
+        QofQueryTerm *qt = node->data;
+        QofQueryParamList *path = qof_query_term_get_param_path (qt);
+
+        if (!acct_term &&
+                (param_path_is (path, SPLIT_ACCOUNT, QOF_PARAM_GUID, NULL) ||
+                 param_path_is (path, SPLIT_ACCOUNT_GUID, NULL)))
+        {
+            const query_guid_def *pdata =
+                (const query_guid_def *) qof_query_term_get_pred_data (qt);
+
+            if (!qof_query_term_is_inverted (qt) &&
+                    !g_strcmp0 (pdata->pd.type_name, QOF_TYPE_GUID) &&
+                    pdata->options == QOF_GUID_MATCH_ANY && pdata->guids)
+            {
+                acct_term = qt;
+                acct_pdata = pdata;
+            }
+        }
+        else if (param_path_is (path, SPLIT_TRANS, TRANS_DATE_POSTED, NULL))
+        {
+            if (split_index_date_term (qt, &start, &have_start, &start_incl,
+                                       &end, &have_end, &end_incl))
+                date_terms = g_list_prepend (date_terms, qt);
+        }
+    }
+
+    if (!acct_term)
+    {
+        g_list_free (date_terms);
+        return FALSE;
+    }
+
+    for (node = acct_pdata->guids; node; node = node->next)
+    {
+        GncGUID *guid = node->data;
+        Account *acc;
+
+        if (!guid || g_list_find_custom (seen_guids, guid,
+                                         (GCompareFunc) guid_compare))
+            continue;
+        seen_guids = g_list_prepend (seen_guids, guid);
+
+        acc = xaccAccountLookup (guid, book);
+        if (!acc) continue;
+        *candidates = g_list_concat (
+                          *candidates,
+                          gnc_account_get_splits_in_date_range (
+                              acc, have_start ? &start : NULL, start_incl,
+                              have_end ? &end : NULL, end_incl));
+    }
+    g_list_free (seen_guids);
+
+    *used_terms = g_list_prepend (date_terms, acct_term);
+    return TRUE;
+}
+
 #ifdef _MSC_VER
 /* MSVC compiler doesn't have C99 "designated initializers"
  * so we wrap them in a macro that is empty on MSVC. */
@@ -1988,6 +2269,7 @@ static QofObject split_object_def =
     DI(.foreach           = ) qof_collection_foreach,
     DI(.printable         = ) (const char * (*)(gpointer)) xaccSplitGetMemo,
     DI(.version_cmp       = ) (int (*)(gpointer, gpointer)) qof_instance_version_cmp,
+    DI(.index_lookup      = ) split_index_lookup,
 };
 
 static gpointer
@@ -2115,7 +2397,7 @@ gboolean xaccSplitRegister (void)
         { SPLIT_ACCT_FULLNAME, SPLIT_ACCT_FULLNAME, no_op, NULL },
         { SPLIT_CORR_ACCT_NAME, SPLIT_CORR_ACCT_NAME, no_op, NULL },
         { SPLIT_CORR_ACCT_CODE, SPLIT_CORR_ACCT_CODE, no_op, NULL },
-        { SPLIT_KVP, QOF_TYPE_KVP, (QofAccessFunc)xaccSplitGetSlots, NULL },
+        { SPLIT_KVP, QOF_TYPE_KVP, (QofAccessFunc)qof_instance_peek_slots, NULL },
         { QOF_PARAM_BOOK, QOF_ID_BOOK, (QofAccessFunc)xaccSplitGetBook, NULL },
         {
             QOF_PARAM_GUID, QOF_TYPE_GUID,
@@ -68,6 +68,21 @@
 #define GAINS_STATUS_VDIRTY    (GAINS_STATUS_VALU_DIRTY)
 #define GAINS_STATUS_A_VDIRTY  (GAINS_STATUS_AMNT_DIRTY|GAINS_STATUS_VALU_DIRTY|GAINS_STATUS_LOT_DIRTY)
 
+/* What xaccSplitOrder() needs from the split's strings, worked out
+ * when first wanted and kept until the strings change.  memo and
+ * action are the split's own strings, each held by a reference in
+ * the string cache, so a part of the key is good for as long as the
+ * split still has the very same string.  The collation keys are made
+ * only when two splits get that far in the comparison. */
+typedef struct
+{
+    const char *memo;
+    const char *action;
+    gchar *memo_key;            /* g_utf8_collate_key() of memo */
+    gchar *action_key;          /* g_utf8_collate_key() of action */
+    int action_num;             /* atoi() of action */
+} SplitSortKey;
+
 struct split_s
 {
     QofInstance inst;
@@ -100,8 +115,10 @@ struct split_s
      * capital-gains splits. Depending on its value, this flag indicates
      * if this split is the source of gains, if this split is a record
      * of the gains, and if values are 'dirty' and need to be recomputed.
+     * An int, so that threads reading the book can work the status out
+     * atomically; see xaccSplitDetermineGainStatus().
      */
-    unsigned char  gains;
+    gint  gains;
 
     /* 'gains_split' is a convenience pointer used to track down the
      * other end of a cap-gains transaction pair.  NULL if this split
@@ -125,6 +142,13 @@ struct split_s
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
+
+    /* Cached for sorting; NULL until the split is first compared. */
+    SplitSortKey *sort_key;
+
+    /* The chunk of its account's split array that holds the split, or
+     * NULL if it is in none; see AccountP.h. */
+    struct split_chunk_s *acc_chunk;
 };
 
 struct _SplitClass
@@ -172,6 +196,12 @@ gboolean xaccSplitRegister (void);
  */
 void xaccSplitDetermineGainStatus (Split *split);
 
+/* xaccSplitOrder() for sorting many splits of one book: the book's
+ * use-split-action-for-num option is looked up once by the caller
+ * rather than on every comparison. */
+gint xaccSplitOrderForNum (const Split *sa, const Split *sb,
+                           gboolean action_for_num);
+
 /* ---------------------------------------------------------------- */
 /* Deprecated routines */
 void         DxaccSplitSetSharePriceAndAmount (Split *split,
@@ -53,6 +53,7 @@ struct timeval
 #include "SplitP.h"
 #include "TransLog.h"
 #include "cap-gains.h"
+#include "gnc-book-snapshot-p.h"
 #include "gnc-commodity.h"
 #include "gnc-engine.h"
 #include "gnc-lot.h"
@@ -564,7 +565,8 @@ xaccDupeTransaction (const Transaction *from)
     to->inst.e_type = NULL;
     qof_instance_set_guid(to, guid_null());
     qof_instance_copy_book(to, from);
-    to->inst.kvp_data = kvp_frame_copy (from->inst.kvp_data);
+    if (from->inst.kvp_data)
+        to->inst.kvp_data = kvp_frame_copy (from->inst.kvp_data);
 
     return to;
 }
@@ -595,7 +597,8 @@ xaccTransClone (const Transaction *from)
 
     qof_instance_init_data (&to->inst, GNC_ID_TRANS, qof_instance_get_book(from));
     kvp_frame_delete (to->inst.kvp_data);
-    to->inst.kvp_data    = kvp_frame_copy (from->inst.kvp_data);
+    to->inst.kvp_data    = from->inst.kvp_data ?
+                           kvp_frame_copy (from->inst.kvp_data) : NULL;
 
     xaccTransBeginEdit(to);
     for (node = from->splits; node; node = node->next)
@@ -700,6 +703,19 @@ xaccTransCopyFromClipBoard(const Transaction *from_trans, Transaction *to_trans,
 
 /*################## Added for Reg2 #################*/
 
+static void
+trans_free_sort_key (Transaction *trans)
+{
+    TransSortKey *key = trans->sort_key;
+
+    if (!key) return;
+    CACHE_REMOVE(key->num);
+    CACHE_REMOVE(key->description);
+    g_free (key->description_key);
+    g_slice_free (TransSortKey, key);
+    trans->sort_key = NULL;
+}
+
 /********************************************************************\
  Free the transaction.
 \********************************************************************/
@@ -727,6 +743,7 @@ xaccFreeTransaction (Transaction *trans)
     /* free up transaction strings */
     CACHE_REMOVE(trans->num);
     CACHE_REMOVE(trans->description);
+    trans_free_sort_key (trans);
 
     /* Just in case someone looks up freed memory ... */
     trans->num         = (char *) 1;
@@ -848,13 +865,14 @@ xaccTransEqual(const Transaction *ta, const Transaction *tb,
         return FALSE;
     }
 
-    if (kvp_frame_compare(ta->inst.kvp_data, tb->inst.kvp_data) != 0)
+    if (kvp_frame_compare(qof_instance_peek_slots (QOF_INSTANCE (ta)),
+                          qof_instance_peek_slots (QOF_INSTANCE (tb))) != 0)
     {
         char *frame_a;
         char *frame_b;
 
-        frame_a = kvp_frame_to_string (ta->inst.kvp_data);
-        frame_b = kvp_frame_to_string (tb->inst.kvp_data);
+        frame_a = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (ta)));
+        frame_b = kvp_frame_to_string (qof_instance_peek_slots (QOF_INSTANCE (tb)));
 
         PINFO ("kvp frames differ:\n%s\n\nvs\n\n%s", frame_a, frame_b);
 
@@ -1290,6 +1308,15 @@ xaccTransSetCurrency (Transaction *trans, gnc_commodity *curr)
     xaccTransCommitEdit(trans);
 }
 
+/* Free a copy made by xaccDupeTransaction() that is kept for longer
+ * than an edit, such as one in a book snapshot. */
+void
+xaccFreeDupeTransaction (Transaction *trans)
+{
+    if (!trans) return;
+    xaccFreeTransaction (trans);
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -1310,6 +1337,9 @@ xaccTransBeginEdit (Transaction *trans)
     /* Make a clone of the transaction; we will use this
      * in case we need to roll-back the edit. */
     trans->orig = xaccDupeTransaction (trans);
+
+    /* Keep the transaction as it was for any snapshots of the book. */
+    gnc_book_snapshot_freeze (&trans->inst);
 }
 
 /********************************************************************\
@@ -1495,11 +1525,22 @@ static void trans_cleanup_commit(Transaction *trans)
 void
 xaccTransCommitEdit (Transaction *trans)
 {
+    QofBook *book;
+
     if (!trans) return;
     ENTER ("(trans=%p)", trans);
 
+    /* Keep readers out until the whole commit is done, not just the
+     * edit; the book outlives the transaction. */
+    book = qof_instance_get_book (trans);
+    if (!qof_book_write_lock (book))
+    {
+        LEAVE("book is being read");
+        return;
+    }
     if (!qof_commit_edit (QOF_INSTANCE(trans)))
     {
+        qof_book_write_unlock (book);
         LEAVE("editlevel non-zero");
         return;
     }
@@ -1561,6 +1602,7 @@ xaccTransCommitEdit (Transaction *trans)
                           trans_on_error,
                           (void (*) (QofInstance *)) trans_cleanup_commit,
                           (void (*) (QofInstance *)) do_destroy);
+    qof_book_write_unlock (book);
     LEAVE ("(trans=%p)", trans);
 }
 
@@ -1582,6 +1624,7 @@ xaccTransRollbackEdit (Transaction *trans)
     Transaction *orig;
     GList *slist;
     int num_preexist, i;
+    QofBook *book;
 
 /* FIXME: This isn't quite the right way to handle nested edits --
  * there should be a stack of transaction states that are popped off
@@ -1600,6 +1643,15 @@ xaccTransRollbackEdit (Transaction *trans)
 
     check_open(trans);
 
+    /* The edit may have let go of the write lock while it was open;
+     * see qof_instance_release_edit_lock(). */
+    book = qof_instance_get_book (trans);
+    if (!qof_book_write_lock (book))
+    {
+        LEAVE ("book is being read");
+        return;
+    }
+
     /* copy the original values back in. */
 
     orig = trans->orig;
@@ -1703,6 +1755,7 @@ xaccTransRollbackEdit (Transaction *trans)
 
             /* push error back onto the stack */
             qof_backend_set_error (be, errcode);
+            qof_book_write_unlock (book);
             LEAVE ("deleted trans addr=%p\n", trans);
             return;
         }
@@ -1729,6 +1782,7 @@ xaccTransRollbackEdit (Transaction *trans)
        reverting to what it was. */
     gen_event_trans (trans);
 
+    qof_book_write_unlock (book);
     LEAVE ("trans addr=%p\n", trans);
 }
 
@@ -1743,15 +1797,60 @@ xaccTransIsOpen (const Transaction *trans)
 int
 xaccTransOrder (const Transaction *ta, const Transaction *tb)
 {
-    return xaccTransOrder_num_action (ta, NULL, tb, NULL);
+    return xaccTransOrderNums (ta, 0, tb, 0, FALSE);
 }
 
 int
 xaccTransOrder_num_action (const Transaction *ta, const char *actna,
                             const Transaction *tb, const char *actnb)
 {
-    char *da, *db;
-    int na, nb, retval;
+    /* split action string, if not NULL, else transaction num string */
+    if (actna && actnb)
+        return xaccTransOrderNums (ta, atoi(actna), tb, atoi(actnb), TRUE);
+    return xaccTransOrderNums (ta, 0, tb, 0, FALSE);
+}
+
+/* Bring the transaction's sort key up to date with its strings.  The
+ * key is a cache, so it is remade even for a const transaction. */
+static TransSortKey *
+trans_get_sort_key (const Transaction *trans)
+{
+    TransSortKey *key = trans->sort_key;
+
+    if (!key)
+        key = ((Transaction *) trans)->sort_key = g_slice_new0 (TransSortKey);
+    if (key->num != trans->num)
+    {
+        CACHE_REPLACE(key->num, trans->num);
+        key->num_value = trans->num ? atoi(trans->num) : 0;
+    }
+    if (key->description != trans->description)
+    {
+        CACHE_REPLACE(key->description, trans->description);
+        g_free (key->description_key);
+        key->description_key = NULL;
+    }
+    return key;
+}
+
+static const gchar *
+trans_get_description_key (const Transaction *trans)
+{
+    TransSortKey *key = trans_get_sort_key (trans);
+
+    if (!key->description_key)
+        key->description_key =
+            g_utf8_collate_key (trans->description ? trans->description : "",
+                                -1);
+    return key->description_key;
+}
+
+int
+xaccTransOrderNums (const Transaction *ta, int na,
+                    const Transaction *tb, int nb, gboolean use_nums)
+{
+    int retval;
+    gboolean keyed;
 
     if ( ta && !tb ) return -1;
     if ( !ta && tb ) return +1;
@@ -1760,16 +1859,15 @@ xaccTransOrder_num_action (const Transaction *ta, const char *actna,
     /* if dates differ, return */
     DATE_CMP(ta, tb, date_posted);
 
-    /* otherwise, sort on number string */
-    if (actna && actnb) /* split action string, if not NULL */
-    {
-        na = atoi(actna);
-        nb = atoi(actnb);
-    }
-    else                /* else transaction num string */
+    /* Threads reading the book share its transactions, so they leave
+     * the sort keys alone. */
+    keyed = !qof_book_is_reading (qof_instance_get_book (ta));
+
+    /* otherwise, sort on number */
+    if (!use_nums)
     {
-        na = atoi(ta->num);
-        nb = atoi(tb->num);
+        na = keyed ? trans_get_sort_key (ta)->num_value : atoi (ta->num);
+        nb = keyed ? trans_get_sort_key (tb)->num_value : atoi (tb->num);
     }
     if (na < nb) return -1;
     if (na > nb) return +1;
@@ -1777,10 +1875,14 @@ xaccTransOrder_num_action (const Transaction *ta, const char *actna,
     /* if dates differ, return */
     DATE_CMP(ta, tb, date_entered);
 
-    /* otherwise, sort on description string */
-    da = ta->description ? ta->description : "";
-    db = tb->description ? tb->description : "";
-    retval = g_utf8_collate (da, db);
+    /* otherwise, sort on description string; the collation keys
+     * compare with strcmp() as the strings do with g_utf8_collate() */
+    if (keyed)
+        retval = strcmp (trans_get_description_key (ta),
+                         trans_get_description_key (tb));
+    else
+        retval = g_utf8_collate (ta->description ? ta->description : "",
+                                 tb->description ? tb->description : "");
     if (retval)
         return retval;
 
@@ -1852,7 +1954,7 @@ xaccTransSetDatePostedGDate (Transaction *trans, GDate date)
      * the future a date which was set as *date* (without time) can
      * clearly be distinguished from the Timespec. */
     kvp_value = kvp_value_new_gdate(date);
-    frame = kvp_frame_set_value_nc(trans->inst.kvp_data, TRANS_DATE_POSTED, kvp_value);
+    frame = kvp_frame_set_value_nc(xaccTransGetSlots (trans), TRANS_DATE_POSTED, kvp_value);
     if (!frame)
     {
         kvp_value_delete(kvp_value);
@@ -1924,7 +2026,7 @@ xaccTransSetDateDueTS (Transaction *trans, const Timespec *ts)
 {
     if (!trans || !ts) return;
     xaccTransBeginEdit(trans);
-    kvp_frame_set_timespec (trans->inst.kvp_data, TRANS_DATE_DUE_KVP, *ts);
+    kvp_frame_set_timespec (xaccTransGetSlots (trans), TRANS_DATE_DUE_KVP, *ts);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -1935,7 +2037,7 @@ xaccTransSetTxnType (Transaction *trans, char type)
     char s[2] = {type, '\0'};
     g_return_if_fail(trans);
     xaccTransBeginEdit(trans);
-    kvp_frame_set_str (trans->inst.kvp_data, TRANS_TXN_TYPE_KVP, s);
+    kvp_frame_set_str (xaccTransGetSlots (trans), TRANS_TXN_TYPE_KVP, s);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -1945,7 +2047,7 @@ void xaccTransClearReadOnly (Transaction *trans)
     if (trans)
     {
         xaccTransBeginEdit(trans);
-        kvp_frame_set_slot_path (trans->inst.kvp_data, NULL,
+        kvp_frame_set_slot_path (xaccTransGetSlots (trans), NULL,
                                  TRANS_READ_ONLY_REASON, NULL);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
         xaccTransCommitEdit(trans);
@@ -1958,7 +2060,7 @@ xaccTransSetReadOnly (Transaction *trans, const char *reason)
     if (trans && reason)
     {
         xaccTransBeginEdit(trans);
-        kvp_frame_set_str (trans->inst.kvp_data,
+        kvp_frame_set_str (xaccTransGetSlots (trans),
                            TRANS_READ_ONLY_REASON, reason);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
         xaccTransCommitEdit(trans);
@@ -2015,7 +2117,7 @@ xaccTransSetAssociation (Transaction *trans, const char *assoc)
     if (!trans || !assoc) return;
     xaccTransBeginEdit(trans);
 
-    kvp_frame_set_str (trans->inst.kvp_data, assoc_uri_str, assoc);
+    kvp_frame_set_str (xaccTransGetSlots (trans), assoc_uri_str, assoc);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2034,7 +2136,7 @@ xaccTransSetNotes (Transaction *trans, const char *notes)
     if (!trans || !notes) return;
     xaccTransBeginEdit(trans);
 
-    kvp_frame_set_str (trans->inst.kvp_data, trans_notes_str, notes);
+    kvp_frame_set_str (xaccTransGetSlots (trans), trans_notes_str, notes);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2046,9 +2148,9 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
     xaccTransBeginEdit(trans);
 
     if (is_closing)
-        kvp_frame_set_gint64 (trans->inst.kvp_data, trans_is_closing_str, 1);
+        kvp_frame_set_gint64 (xaccTransGetSlots (trans), trans_is_closing_str, 1);
     else
-        kvp_frame_replace_value_nc (trans->inst.kvp_data, trans_is_closing_str, NULL);
+        kvp_frame_replace_value_nc (xaccTransGetSlots (trans), trans_is_closing_str, NULL);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2393,7 +2495,7 @@ xaccTransVoid(Transaction *trans, const char *reason)
     g_return_if_fail(trans && reason);
 
     xaccTransBeginEdit(trans);
-    frame = trans->inst.kvp_data;
+    frame = xaccTransGetSlots (trans);
 
     val = kvp_frame_get_slot(frame, trans_notes_str);
     kvp_frame_set_slot(frame, void_former_notes_str, val);
@@ -2486,7 +2588,7 @@ xaccTransReverse (Transaction *orig)
 
     /* Now update the original with a pointer to the new one */
     kvp_val = kvp_value_new_guid(xaccTransGetGUID(trans));
-    kvp_frame_set_slot_nc(orig->inst.kvp_data, TRANS_REVERSED_BY, kvp_val);
+    kvp_frame_set_slot_nc(xaccTransGetSlots (orig), TRANS_REVERSED_BY, kvp_val);
 
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
@@ -2619,15 +2721,35 @@ xaccTransFindSplitByAccount(const Transaction *trans, const Account *acc)
 \********************************************************************/
 /* QofObject function implementation */
 
+/* Everything in the book is going away, so there's no point in the
+ * edit/commit cycle xaccTransDestroy() puts each split through: no
+ * backend commit or log entry, no removing the splits one at a time
+ * from accounts that have already been freed or from lots that are
+ * about to be, and no events for the splits.  Just let the listeners
+ * know the transaction is gone and free it with its splits. */
 static void
 destroy_tx_on_book_close(QofInstance *ent, gpointer data)
 {
     Transaction* tx = GNC_TRANSACTION(ent);
+    GList *node;
+
+    qof_event_gen (&tx->inst, QOF_EVENT_DESTROY, NULL);
 
-    xaccTransDestroy(tx);
+    /* Free only the splits that still think they belong to us, as
+     * do_destroy does; the others are freed with their own
+     * transaction. */
+    for (node = tx->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        if (s && s->parent == tx)
+            xaccFreeSplit (s);
+    }
+    g_list_free (tx->splits);
+    tx->splits = NULL;
+    xaccFreeTransaction (tx);
 }
 
-/** Handles book end - frees all transactions from the book
+/** Handles book end - frees all transactions from the book in bulk
  *
  * @param book Book being closed
  */
@@ -2649,6 +2771,18 @@ gnc_transaction_book_end(QofBook* book)
 #endif
 
 /* Hook into the QofObject registry */
+/* The splits read their dates, description etc. from the transaction. */
+static gboolean
+trans_foreach_dependent (gpointer instance, QofIdTypeConst dep_type,
+                         QofInstanceForeachCB cb, gpointer user_data)
+{
+    Transaction *trans = instance;
+
+    if (g_strcmp0 (dep_type, GNC_ID_SPLIT)) return FALSE;
+    FOR_EACH_SPLIT (trans, cb (QOF_INSTANCE (s), user_data));
+    return TRUE;
+}
+
 static QofObject trans_object_def =
 {
     DI(.interface_version = ) QOF_OBJECT_VERSION,
@@ -2662,6 +2796,8 @@ static QofObject trans_object_def =
     DI(.foreach           = ) qof_collection_foreach,
     DI(.printable         = ) (const char * (*)(gpointer)) xaccTransGetDescription,
     DI(.version_cmp       = ) (int (*)(gpointer, gpointer)) qof_instance_version_cmp,
+    DI(.index_lookup      = ) NULL,
+    DI(.foreach_dependent = ) trans_foreach_dependent,
 };
 
 static gboolean
@@ -2744,7 +2880,7 @@ gboolean xaccTransRegister (void)
         },
         {
             TRANS_KVP, QOF_TYPE_KVP,
-            (QofAccessFunc)qof_instance_get_slots, NULL
+            (QofAccessFunc)qof_instance_peek_slots, NULL
         },
         {
             QOF_PARAM_BOOK, QOF_ID_BOOK,
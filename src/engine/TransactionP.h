@@ -71,6 +71,17 @@
  * A "split" is more commonly referred to as an "entry" in a "transaction".
  */
 
+/* What xaccTransOrder() needs from the transaction's strings, kept
+ * the same way as a split's SplitSortKey: num and description are
+ * string cache references to the transaction's own strings. */
+typedef struct
+{
+    const char *num;
+    const char *description;
+    int num_value;              /* atoi() of num */
+    gchar *description_key;     /* g_utf8_collate_key() of description */
+} TransSortKey;
+
 struct transaction_s
 {
     QofInstance inst;     /* glbally unique id */
@@ -110,6 +121,9 @@ struct transaction_s
      * any changes made if/when the edit is abandoned.
      */
     Transaction *orig;
+
+    /* Cached for sorting; NULL until the transaction is first compared. */
+    TransSortKey *sort_key;
 };
 
 struct _TransactionClass
@@ -132,6 +146,13 @@ struct _TransactionClass
  * as the parent, not the new transaction.
  */
 Transaction * xaccDupeTransaction (const Transaction *t);
+void xaccFreeDupeTransaction (Transaction *trans);
+
+/* xaccTransOrder_num_action() with the numbers to sort on already
+ * worked out.  When use_nums is set, na and nb are used in place of
+ * the transactions' num fields, as the split actions are. */
+int xaccTransOrderNums (const Transaction *ta, int na,
+                        const Transaction *tb, int nb, gboolean use_nums);
 
 /* The xaccTransSet/GetVersion() routines set & get the version
  *    numbers on this transaction.  The version number is used to manage
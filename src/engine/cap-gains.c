@@ -550,11 +550,11 @@ xaccSplitAssignToLot (Split *split, GNCLot *lot)
         /* Add kvp markup to indicate that these two splits used
          * to be one before being 'split'
          */
-        gnc_kvp_bag_add (split->inst.kvp_data, "lot-split", now,
+        gnc_kvp_bag_add (xaccSplitGetSlots (split), "lot-split", now,
                          "peer_guid", xaccSplitGetGUID (new_split),
                          NULL);
 
-        gnc_kvp_bag_add (new_split->inst.kvp_data, "lot-split", now,
+        gnc_kvp_bag_add (xaccSplitGetSlots (new_split), "lot-split", now,
                          "peer_guid", xaccSplitGetGUID (split),
                          NULL);
 
@@ -970,11 +970,11 @@ xaccSplitComputeCapGains(Split *split, Account *gain_acc)
              * to the gains source.
              */
             xaccTransBeginEdit (base_txn);
-            kvp_frame_set_guid (split->inst.kvp_data, "gains-split",
+            kvp_frame_set_guid (xaccSplitGetSlots (split), "gains-split",
                                 xaccSplitGetGUID (lot_split));
             qof_instance_set_dirty (QOF_INSTANCE (split));
             xaccTransCommitEdit (base_txn);
-            kvp_frame_set_guid (lot_split->inst.kvp_data, "gains-source",
+            kvp_frame_set_guid (xaccSplitGetSlots (lot_split), "gains-source",
                                 xaccSplitGetGUID (split));
 
         }
@@ -1057,11 +1057,14 @@ xaccSplitGetCapGains(Split * split)
     if (!split) return gnc_numeric_zero();
     ENTER("(split=%p)", split);
 
-    if (GAINS_STATUS_UNKNOWN == split->gains)
-        xaccSplitDetermineGainStatus(split);
-    if ((split->gains & GAINS_STATUS_A_VDIRTY) ||
+    xaccSplitDetermineGainStatus(split);
+    /* Computing the gains may change the book, which a thread reading
+     * it must not do; it gets the gains as last computed instead. */
+    if (((split->gains & GAINS_STATUS_A_VDIRTY) ||
             (split->gains_split &&
-             (split->gains_split->gains & GAINS_STATUS_A_VDIRTY)))
+             (g_atomic_int_get (&split->gains_split->gains) &
+              GAINS_STATUS_A_VDIRTY))) &&
+            !qof_book_is_reading (qof_instance_get_book (split)))
     {
         xaccSplitComputeCapGains (split, NULL);
     }
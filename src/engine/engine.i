@@ -147,6 +147,15 @@ void qof_book_kvp_changed (QofBook *book);
 // TODO: Unroll/remove
 const char *qof_session_get_url (QofSession *session);
 
+void qof_stats_set_enabled (gboolean enabled);
+gboolean qof_stats_is_enabled (void);
+void qof_stats_reset (void);
+gint64 qof_stats_get_count (const char *name);
+gint64 qof_stats_get_sum (const char *name);
+%newobject qof_stats_to_json;
+gchar * qof_stats_to_json (void);
+gboolean qof_stats_dump (const char *filename);
+
 extern const char *gnc_default_strftime_date_format;
 const char *gnc_print_date (Timespec ts);
 
@@ -0,0 +1,43 @@
+/********************************************************************\
+ * gnc-book-snapshot-p.h -- private hooks for book snapshots        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/*
+ * FILE:
+ * gnc-book-snapshot-p.h
+ *
+ * FUNCTION:
+ * The hook by which editing an account or transaction keeps a copy
+ * of it for the snapshots of its book.  See gnc-book-snapshot.h.
+ */
+
+#ifndef GNC_BOOK_SNAPSHOT_P_H
+#define GNC_BOOK_SNAPSHOT_P_H
+
+#include "gnc-book-snapshot.h"
+
+/* Give each snapshot of the instance's book that still shares the
+ * instance a copy of it, waiting for any callback reading it to
+ * finish.  Called by xaccAccountBeginEdit() and xaccTransBeginEdit()
+ * before anything is changed.  Costs an atomic read while the book has
+ * no snapshots. */
+void gnc_book_snapshot_freeze (QofInstance *inst);
+
+#endif /* GNC_BOOK_SNAPSHOT_P_H */
@@ -0,0 +1,473 @@
+/********************************************************************\
+ * gnc-book-snapshot.c -- point-in-time views of a book             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/*
+ * FILE:
+ * gnc-book-snapshot.c
+ *
+ * FUNCTION:
+ * A snapshot lists the accounts and transactions of the book, in the
+ * order of a walk of the account tree, and keeps a table from each of
+ * them that has since been edited to the copy made when it was.  A
+ * second pair of lists, sorted by address, says what it holds.  The snapshots are kept in a
+ * list that gnc_book_snapshot_freeze() looks through on every first
+ * xaccAccountBeginEdit() and xaccTransBeginEdit().
+ *
+ * Locking: a writer freezing an object holds the book's write lock,
+ * then the list lock, then the snapshot's lock.  A reader holds only
+ * the snapshot's lock, and only while it runs one callback, so the
+ * writer waits for that callback and no longer.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "AccountP.h"
+#include "TransactionP.h"
+#include "SplitP.h"
+#include "gnc-book-snapshot.h"
+#include "gnc-book-snapshot-p.h"
+
+static QofLogModule log_module = GNC_MOD_ENGINE;
+
+struct _GncBookSnapshot
+{
+    QofBook *book;
+
+    /* The live objects, in the order the foreach functions call them. */
+    GPtrArray *accounts;
+    GPtrArray *transactions;
+
+    /* The same objects, sorted by address for bsearch(). */
+    GPtrArray *accounts_by_address;
+    GPtrArray *transactions_by_address;
+
+    /* Live object -> the copy made when it was first edited. */
+    GHashTable *frozen_accounts;
+    GHashTable *frozen_transactions;
+
+    /* Accounts found open for editing while collecting. */
+    guint open_accounts;
+
+#ifdef HAVE_GLIB_2_32
+    GRecMutex lock;
+#else
+    GStaticRecMutex lock;
+#endif
+};
+
+#ifdef HAVE_GLIB_2_32
+# define SNAPSHOT_LOCK(s)    g_rec_mutex_lock (&(s)->lock)
+# define SNAPSHOT_UNLOCK(s)  g_rec_mutex_unlock (&(s)->lock)
+#else
+# define SNAPSHOT_LOCK(s)    g_static_rec_mutex_lock (&(s)->lock)
+# define SNAPSHOT_UNLOCK(s)  g_static_rec_mutex_unlock (&(s)->lock)
+#endif
+
+G_LOCK_DEFINE_STATIC (snapshots);
+static GList *snapshots = NULL;
+static gint n_snapshots = 0;
+
+/* ================================================================= */
+
+static gint
+compare_pointers (gconstpointer a, gconstpointer b)
+{
+    gconstpointer pa = *(gconstpointer *) a;
+    gconstpointer pb = *(gconstpointer *) b;
+
+    return (pa < pb) ? -1 : (pa > pb) ? 1 : 0;
+}
+
+static gboolean
+array_contains (GPtrArray *array, gconstpointer ptr)
+{
+    return bsearch (&ptr, array->pdata, array->len, sizeof (gpointer),
+                    compare_pointers) != NULL;
+}
+
+static Transaction *
+freeze_transaction (const Transaction *from)
+{
+    Transaction *trans = xaccDupeTransaction (from);
+    GList *node;
+
+    /* The dupe has a null guid and its splits still point at the live
+     * transaction; a snapshot's copy has to stand in for the real one. */
+    qof_instance_copy_guid (trans, from);
+    for (node = trans->splits; node; node = node->next)
+        ((Split *) node->data)->parent = trans;
+    return trans;
+}
+
+static void
+collect_account (QofInstance *inst, gpointer data)
+{
+    GncBookSnapshot *snapshot = data;
+    Account *acc = GNC_ACCOUNT (inst);
+
+    g_ptr_array_add (snapshot->accounts_by_address, acc);
+    /* An account keeps no copy of itself from before an edit, so one
+     * that is open can't be shown as it was committed. */
+    if (qof_instance_get_editlevel (inst) > 0)
+        snapshot->open_accounts++;
+}
+
+static void
+collect_transaction (QofInstance *inst, gpointer data)
+{
+    GncBookSnapshot *snapshot = data;
+    Transaction *trans = GNC_TRANSACTION (inst);
+
+    g_ptr_array_add (snapshot->transactions_by_address, trans);
+    /* It is either open on the calling thread or left open with its
+     * lock released, and no change to it can be under way while we
+     * hold the read lock; show it as it was before the edit. */
+    if (qof_instance_get_editlevel (inst) > 0 && trans->orig)
+        g_hash_table_insert (snapshot->frozen_transactions, trans,
+                             freeze_transaction (trans->orig));
+}
+
+/* ----------------------------------------------------------------- */
+
+typedef struct
+{
+    GncBookSnapshot *snapshot;
+    GHashTable *placed;
+} OrderData;
+
+/* Accounts go in the order gnc_account_foreach_descendant() visits
+ * them, starting from the root. */
+static void
+order_account (Account *acc, gpointer data)
+{
+    OrderData *od = data;
+
+    if (g_hash_table_lookup (od->placed, acc)) return;
+    g_hash_table_insert (od->placed, acc, acc);
+    g_ptr_array_add (od->snapshot->accounts, acc);
+    gnc_account_foreach_child (acc, order_account, od);
+}
+
+/* Transactions go in the order xaccAccountTreeForEachTransaction()
+ * visits them, children's splits before the account's own, but with a
+ * table of those already placed instead of the transactions' markers,
+ * which can't be set under a read lock. */
+static void
+order_account_transactions (Account *acc, gpointer data)
+{
+    OrderData *od = data;
+    GList *node;
+
+    gnc_account_foreach_child (acc, order_account_transactions, od);
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        if (!trans || g_hash_table_lookup (od->placed, trans)) continue;
+        g_hash_table_insert (od->placed, trans, trans);
+        g_ptr_array_add (od->snapshot->transactions, trans);
+    }
+}
+
+static gint
+compare_account_guids (gconstpointer a, gconstpointer b)
+{
+    return guid_compare (qof_instance_get_guid (*(QofInstance **) a),
+                         qof_instance_get_guid (*(QofInstance **) b));
+}
+
+static gint
+compare_transactions (gconstpointer a, gconstpointer b)
+{
+    const Transaction *ta = *(const Transaction **) a;
+    const Transaction *tb = *(const Transaction **) b;
+    Timespec tsa, tsb;
+    gint retval;
+
+    xaccTransGetDatePostedTS (ta, &tsa);
+    xaccTransGetDatePostedTS (tb, &tsb);
+    retval = timespec_cmp (&tsa, &tsb);
+    if (retval) return retval;
+    return guid_compare (qof_instance_get_guid (ta),
+                         qof_instance_get_guid (tb));
+}
+
+/* Append whatever the walk didn't reach, such as the template accounts
+ * and transactions, sorted so that the order doesn't depend on where
+ * they were allocated. */
+static void
+order_rest (GPtrArray *ordered, GPtrArray *by_address, GHashTable *placed,
+            GCompareFunc compare)
+{
+    guint start = ordered->len;
+    guint i;
+
+    for (i = 0; i < by_address->len; i++)
+    {
+        gpointer obj = g_ptr_array_index (by_address, i);
+        if (!g_hash_table_lookup (placed, obj))
+            g_ptr_array_add (ordered, obj);
+    }
+    qsort (ordered->pdata + start, ordered->len - start, sizeof (gpointer),
+           compare);
+}
+
+static void
+order_snapshot (GncBookSnapshot *snapshot)
+{
+    OrderData od;
+    Account *root;
+
+    root = qof_collection_get_data (qof_book_get_collection
+                                    (snapshot->book, GNC_ID_ROOT_ACCOUNT));
+    od.snapshot = snapshot;
+
+    od.placed = g_hash_table_new (g_direct_hash, g_direct_equal);
+    if (root)
+        order_account (root, &od);
+    order_rest (snapshot->accounts, snapshot->accounts_by_address,
+                od.placed, compare_account_guids);
+    g_hash_table_destroy (od.placed);
+
+    od.placed = g_hash_table_new (g_direct_hash, g_direct_equal);
+    if (root)
+        order_account_transactions (root, &od);
+    order_rest (snapshot->transactions, snapshot->transactions_by_address,
+                od.placed, compare_transactions);
+    g_hash_table_destroy (od.placed);
+}
+
+/* ----------------------------------------------------------------- */
+
+static void
+snapshot_free (GncBookSnapshot *snapshot)
+{
+    g_hash_table_destroy (snapshot->frozen_accounts);
+    g_hash_table_destroy (snapshot->frozen_transactions);
+    g_ptr_array_free (snapshot->accounts, TRUE);
+    g_ptr_array_free (snapshot->transactions, TRUE);
+    g_ptr_array_free (snapshot->accounts_by_address, TRUE);
+    g_ptr_array_free (snapshot->transactions_by_address, TRUE);
+#ifdef HAVE_GLIB_2_32
+    g_rec_mutex_clear (&snapshot->lock);
+#else
+    g_static_rec_mutex_free (&snapshot->lock);
+#endif
+    g_free (snapshot);
+}
+
+GncBookSnapshot *
+gnc_book_snapshot_new (QofBook *book)
+{
+    GncBookSnapshot *snapshot;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), NULL);
+
+    ENTER ("book=%p", book);
+    snapshot = g_new0 (GncBookSnapshot, 1);
+    snapshot->book = book;
+    snapshot->accounts = g_ptr_array_new ();
+    snapshot->transactions = g_ptr_array_new ();
+    snapshot->accounts_by_address = g_ptr_array_new ();
+    snapshot->transactions_by_address = g_ptr_array_new ();
+    snapshot->frozen_accounts =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                               (GDestroyNotify) xaccFreeDupeAccount);
+    snapshot->frozen_transactions =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                               (GDestroyNotify) xaccFreeDupeTransaction);
+#ifdef HAVE_GLIB_2_32
+    g_rec_mutex_init (&snapshot->lock);
+#else
+    g_static_rec_mutex_init (&snapshot->lock);
+#endif
+
+    /* No one can begin an edit until the snapshot is on the list. */
+    qof_book_read_lock (book);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            collect_account, snapshot);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            collect_transaction, snapshot);
+    if (snapshot->open_accounts)
+    {
+        qof_book_read_unlock (book);
+        PWARN ("%u accounts are open for editing", snapshot->open_accounts);
+        snapshot_free (snapshot);
+        LEAVE ("no snapshot");
+        return NULL;
+    }
+    order_snapshot (snapshot);
+    g_ptr_array_sort (snapshot->accounts_by_address, compare_pointers);
+    g_ptr_array_sort (snapshot->transactions_by_address, compare_pointers);
+
+    G_LOCK (snapshots);
+    snapshots = g_list_prepend (snapshots, snapshot);
+    g_atomic_int_inc (&n_snapshots);
+    G_UNLOCK (snapshots);
+    qof_book_read_unlock (book);
+
+    LEAVE ("%u accounts, %u transactions", snapshot->accounts->len,
+           snapshot->transactions->len);
+    return snapshot;
+}
+
+void
+gnc_book_snapshot_destroy (GncBookSnapshot *snapshot)
+{
+    if (!snapshot) return;
+
+    ENTER ("snapshot=%p", snapshot);
+    G_LOCK (snapshots);
+    snapshots = g_list_remove (snapshots, snapshot);
+    g_atomic_int_add (&n_snapshots, -1);
+    G_UNLOCK (snapshots);
+
+    snapshot_free (snapshot);
+    LEAVE (" ");
+}
+
+QofBook *
+gnc_book_snapshot_get_book (const GncBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, NULL);
+    return snapshot->book;
+}
+
+guint
+gnc_book_snapshot_count_accounts (const GncBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, 0);
+    return snapshot->accounts->len;
+}
+
+guint
+gnc_book_snapshot_count_transactions (const GncBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, 0);
+    return snapshot->transactions->len;
+}
+
+/* ================================================================= */
+
+void
+gnc_book_snapshot_foreach_account (GncBookSnapshot *snapshot,
+                                   AccountCb cb, gpointer data)
+{
+    guint i;
+
+    g_return_if_fail (snapshot && cb);
+
+    for (i = 0; i < snapshot->accounts->len; i++)
+    {
+        Account *acc = g_ptr_array_index (snapshot->accounts, i);
+        Account *frozen;
+
+        SNAPSHOT_LOCK (snapshot);
+        frozen = g_hash_table_lookup (snapshot->frozen_accounts, acc);
+        cb (frozen ? frozen : acc, data);
+        SNAPSHOT_UNLOCK (snapshot);
+    }
+}
+
+gint
+gnc_book_snapshot_foreach_transaction (GncBookSnapshot *snapshot,
+                                       TransactionCallback cb,
+                                       gpointer data)
+{
+    gint retval = 0;
+    guint i;
+
+    g_return_val_if_fail (snapshot && cb, 0);
+
+    for (i = 0; i < snapshot->transactions->len && !retval; i++)
+    {
+        Transaction *trans = g_ptr_array_index (snapshot->transactions, i);
+        Transaction *frozen;
+
+        SNAPSHOT_LOCK (snapshot);
+        frozen = g_hash_table_lookup (snapshot->frozen_transactions, trans);
+        retval = cb (frozen ? frozen : trans, data);
+        SNAPSHOT_UNLOCK (snapshot);
+    }
+    return retval;
+}
+
+Account *
+gnc_book_snapshot_get_account (GncBookSnapshot *snapshot, Account *acc)
+{
+    Account *frozen;
+
+    g_return_val_if_fail (snapshot, NULL);
+    if (!acc) return NULL;
+
+    SNAPSHOT_LOCK (snapshot);
+    frozen = g_hash_table_lookup (snapshot->frozen_accounts, acc);
+    SNAPSHOT_UNLOCK (snapshot);
+    return frozen ? frozen : acc;
+}
+
+/* ================================================================= */
+
+void
+gnc_book_snapshot_freeze (QofInstance *inst)
+{
+    QofBook *book;
+    gboolean is_trans;
+    GList *node;
+
+    if (g_atomic_int_get (&n_snapshots) == 0) return;
+
+    if (GNC_IS_TRANSACTION (inst))
+        is_trans = TRUE;
+    else if (GNC_IS_ACCOUNT (inst))
+        is_trans = FALSE;
+    else
+        return;
+
+    book = qof_instance_get_book (inst);
+    G_LOCK (snapshots);
+    for (node = snapshots; node; node = node->next)
+    {
+        GncBookSnapshot *snapshot = node->data;
+        GHashTable *frozen;
+
+        if (snapshot->book != book) continue;
+        if (!array_contains (is_trans ? snapshot->transactions_by_address
+                             : snapshot->accounts_by_address, inst))
+            continue;
+
+        frozen = is_trans ? snapshot->frozen_transactions
+                 : snapshot->frozen_accounts;
+        SNAPSHOT_LOCK (snapshot);
+        if (!g_hash_table_lookup (frozen, inst))
+        {
+            gpointer copy = is_trans
+                            ? (gpointer) freeze_transaction (GNC_TRANSACTION (inst))
+                            : (gpointer) xaccDupeAccount (GNC_ACCOUNT (inst));
+            g_hash_table_insert (frozen, inst, copy);
+        }
+        SNAPSHOT_UNLOCK (snapshot);
+    }
+    G_UNLOCK (snapshots);
+}
@@ -0,0 +1,107 @@
+/********************************************************************\
+ * gnc-book-snapshot.h -- point-in-time views of a book             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @addtogroup Engine
+    @{ */
+/** @addtogroup BookSnapshot Book Snapshots
+ * A snapshot is a view of the accounts and transactions of a book as
+ * they were when it was taken, for work that runs in the background
+ * while the user carries on editing, such as saving or running a
+ * report.
+ *
+ * Taking a snapshot copies no objects; it only lists the accounts and
+ * transactions the book has.  The first time one of them is edited
+ * afterwards, xaccAccountBeginEdit() or xaccTransBeginEdit() makes a
+ * copy of it for the snapshot, which keeps showing the copy.  Objects
+ * that are never edited are shared by the book and the snapshot, so a
+ * snapshot costs a few pointers per object plus a copy of whatever is
+ * changed or deleted while it lives.  Objects created after the
+ * snapshot was taken don't appear in it.
+ *
+ * The snapshot is read with gnc_book_snapshot_foreach_account() and
+ * gnc_book_snapshot_foreach_transaction(), from any thread.  An edit
+ * of an object the snapshot still shares waits for the callback
+ * running at the time to return, so a callback sees each object whole.
+ * Within a callback:
+ *
+ * - Read only the fields that are changed by editing the object:
+ *   names, types, dates, amounts, kvp and so on.  Running balances,
+ *   the account split lists and lots are not part of the snapshot.
+ * - The accounts that splits and accounts point to are the live ones.
+ *   Pass them through gnc_book_snapshot_get_account() before using
+ *   them, since they may have been changed, or freed, since.
+ * - Don't edit anything, or take the book's read lock.
+ *
+ * The snapshot must be destroyed before its book is.
+ @{ */
+
+/** @file gnc-book-snapshot.h
+ *  @brief Point-in-time views of a book
+ */
+
+#ifndef GNC_BOOK_SNAPSHOT_H
+#define GNC_BOOK_SNAPSHOT_H
+
+#include "qof.h"
+#include "Account.h"
+#include "gnc-engine.h"
+
+typedef struct _GncBookSnapshot GncBookSnapshot;
+
+/** Take a snapshot of the accounts and transactions in the book.
+ *  Transactions that are open for editing, by the calling thread or
+ *  with their lock released (see qof_instance_release_edit_lock()),
+ *  appear as they were before the edit began.  Accounts don't keep a copy of
+ *  themselves from before an edit, so if any account is open for
+ *  editing there is no snapshot and this returns NULL. */
+GncBookSnapshot * gnc_book_snapshot_new (QofBook *book);
+
+/** Free the snapshot and the copies made for it. */
+void gnc_book_snapshot_destroy (GncBookSnapshot *snapshot);
+
+QofBook * gnc_book_snapshot_get_book (const GncBookSnapshot *snapshot);
+
+/** Call cb on each account in the snapshot, from the root down in the
+ *  order gnc_account_foreach_descendant() uses, then any accounts
+ *  outside the tree by GUID. */
+void gnc_book_snapshot_foreach_account (GncBookSnapshot *snapshot,
+                                        AccountCb cb, gpointer data);
+
+/** Call cb on each transaction in the snapshot until it returns
+ *  non-zero, in the order xaccAccountTreeForEachTransaction() uses,
+ *  then any transactions with no split in the tree by date posted and
+ *  GUID.  Returns the last value cb returned. */
+gint gnc_book_snapshot_foreach_transaction (GncBookSnapshot *snapshot,
+                                            TransactionCallback cb,
+                                            gpointer data);
+
+/** Return the account as the snapshot has it, which is either the
+ *  live account or the copy taken when it was first edited.  Only call
+ *  this from a foreach callback. */
+Account * gnc_book_snapshot_get_account (GncBookSnapshot *snapshot,
+                                         Account *acc);
+
+/** Return the number of accounts or transactions in the snapshot. */
+guint gnc_book_snapshot_count_accounts (const GncBookSnapshot *snapshot);
+guint gnc_book_snapshot_count_transactions (const GncBookSnapshot *snapshot);
+
+#endif /* GNC_BOOK_SNAPSHOT_H */
+/** @} */
+/** @} */
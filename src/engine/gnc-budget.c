@@ -468,8 +468,18 @@ gnc_budget_get_num_periods(const GncBudget* budget)
     return GET_PRIVATE(budget)->num_periods;
 }
 
-#define BUF_SIZE (10 + GUID_ENCODING_LENGTH + \
-   GNC_BUDGET_MAX_NUM_PERIODS_DIGITS)
+#define BUF_SIZE (10 + GNC_BUDGET_MAX_NUM_PERIODS_DIGITS)
+
+/* The values live at <account guid>/<period> in the budget's frame.
+ * Hand the two keys to the kvp routines as they are instead of
+ * building a path string for them to take apart again. */
+static void
+budget_value_keys(const Account *account, guint period_num,
+                  gchar *guidbuf, gchar *periodbuf)
+{
+    guid_to_string_buff(xaccAccountGetGUID(account), guidbuf);
+    g_snprintf(periodbuf, BUF_SIZE, "%u", period_num);
+}
 
 /* period_num is zero-based */
 /* What happens when account is deleted, after we have an entry for it? */
@@ -477,18 +487,15 @@ void
 gnc_budget_unset_account_period_value(GncBudget *budget, const Account *account,
                                       guint period_num)
 {
-    const GncGUID *guid;
     KvpFrame *frame;
-    gchar path[BUF_SIZE];
-    gchar *bufend;
+    gchar guidbuf[GUID_ENCODING_LENGTH + 1];
+    gchar periodbuf[BUF_SIZE];
 
     gnc_budget_begin_edit(budget);
     frame = qof_instance_get_slots(QOF_INSTANCE(budget));
-    guid = xaccAccountGetGUID(account);
-    bufend = guid_to_string_buff(guid, path);
-    g_sprintf(bufend, "/%d", period_num);
+    budget_value_keys(account, period_num, guidbuf, periodbuf);
 
-    kvp_frame_set_value(frame, path, NULL);
+    kvp_frame_set_slot_path(frame, NULL, guidbuf, periodbuf, NULL);
     qof_instance_set_dirty(&budget->inst);
     gnc_budget_commit_edit(budget);
 
@@ -502,10 +509,9 @@ void
 gnc_budget_set_account_period_value(GncBudget *budget, const Account *account,
                                     guint period_num, gnc_numeric val)
 {
-    const GncGUID *guid;
     KvpFrame *frame;
-    gchar path[BUF_SIZE];
-    gchar *bufend;
+    gchar guidbuf[GUID_ENCODING_LENGTH + 1];
+    gchar periodbuf[BUF_SIZE];
 
     /* Watch out for an off-by-one error here:
      * period_num starts from 0 while num_periods starts from 1 */
@@ -517,14 +523,16 @@ gnc_budget_set_account_period_value(GncBudget *budget, const Account *account,
 
     gnc_budget_begin_edit(budget);
     frame = qof_instance_get_slots(QOF_INSTANCE(budget));
-    guid = xaccAccountGetGUID(account);
-    bufend = guid_to_string_buff(guid, path);
-    g_sprintf(bufend, "/%d", period_num);
+    budget_value_keys(account, period_num, guidbuf, periodbuf);
 
     if (gnc_numeric_check(val))
-        kvp_frame_set_value(frame, path, NULL);
+        kvp_frame_set_slot_path(frame, NULL, guidbuf, periodbuf, NULL);
     else
-        kvp_frame_set_numeric(frame, path, val);
+    {
+        KvpValue *value = kvp_value_new_gnc_numeric(val);
+        kvp_frame_set_slot_path(frame, value, guidbuf, periodbuf, NULL);
+        kvp_value_delete(value);
+    }
     qof_instance_set_dirty(&budget->inst);
     gnc_budget_commit_edit(budget);
 
@@ -539,17 +547,16 @@ gboolean
 gnc_budget_is_account_period_value_set(const GncBudget *budget, const Account *account,
                                        guint period_num)
 {
-    gchar path[BUF_SIZE];
-    gchar *bufend;
+    gchar guidbuf[GUID_ENCODING_LENGTH + 1];
+    gchar periodbuf[BUF_SIZE];
     KvpFrame *frame;
 
     g_return_val_if_fail(GNC_IS_BUDGET(budget), FALSE);
     g_return_val_if_fail(account, FALSE);
 
     frame = qof_instance_get_slots(QOF_INSTANCE(budget));
-    bufend = guid_to_string_buff(xaccAccountGetGUID(account), path);
-    g_sprintf(bufend, "/%d", period_num);
-    return (kvp_frame_get_value(frame, path) != NULL);
+    budget_value_keys(account, period_num, guidbuf, periodbuf);
+    return (kvp_frame_get_slot_path(frame, guidbuf, periodbuf, NULL) != NULL);
 }
 
 gnc_numeric
@@ -557,8 +564,8 @@ gnc_budget_get_account_period_value(const GncBudget *budget, const Account *acco
                                     guint period_num)
 {
     gnc_numeric numeric;
-    gchar path[BUF_SIZE];
-    gchar *bufend;
+    gchar guidbuf[GUID_ENCODING_LENGTH + 1];
+    gchar periodbuf[BUF_SIZE];
     KvpFrame *frame;
 
     numeric = gnc_numeric_zero();
@@ -566,10 +573,10 @@ gnc_budget_get_account_period_value(const GncBudget *budget, const Account *acco
     g_return_val_if_fail(account, numeric);
 
     frame = qof_instance_get_slots(QOF_INSTANCE(budget));
-    bufend = guid_to_string_buff(xaccAccountGetGUID(account), path);
-    g_sprintf(bufend, "/%d", period_num);
+    budget_value_keys(account, period_num, guidbuf, periodbuf);
 
-    numeric = kvp_frame_get_numeric(frame, path);
+    numeric = kvp_value_get_numeric(
+                  kvp_frame_get_slot_path(frame, guidbuf, periodbuf, NULL));
     /* This still returns zero if unset, but callers can check for that. */
     return numeric;
 }
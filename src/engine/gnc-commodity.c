@@ -966,7 +966,8 @@ gnc_commodity_clone(const gnc_commodity *src, QofBook *dest_book)
     gnc_commodity_set_quote_source (dest, gnc_commodity_get_quote_source (src));
 
     kvp_frame_delete (dest->inst.kvp_data);
-    dest->inst.kvp_data = kvp_frame_copy (src->inst.kvp_data);
+    dest->inst.kvp_data = src->inst.kvp_data ?
+                          kvp_frame_copy (src->inst.kvp_data) : NULL;
 
     reset_printname(dest_priv);
     reset_unique_name(dest_priv);
@@ -1282,7 +1283,7 @@ gnc_commodity_set_auto_quote_control_flag(gnc_commodity *cm,
     }
 
     gnc_commodity_begin_edit(cm);
-    kvp_frame_set_string(cm->inst.kvp_data,
+    kvp_frame_set_string(gnc_commodity_get_kvp_frame (cm),
                          "auto_quote_control", flag ? NULL : "false");
     mark_commodity_dirty(cm);
     gnc_commodity_commit_edit(cm);
@@ -1400,7 +1401,7 @@ gnc_commodity_set_user_symbol(gnc_commodity * cm, const char * user_symbol)
     ENTER ("(cm=%p, symbol=%s)", cm, user_symbol ? user_symbol : "(null)");
 
     gnc_commodity_begin_edit(cm);
-    kvp_frame_set_string(cm->inst.kvp_data, "user_symbol", user_symbol);
+    kvp_frame_set_string(gnc_commodity_get_kvp_frame (cm), "user_symbol", user_symbol);
     mark_commodity_dirty(cm);
     gnc_commodity_commit_edit(cm);
 
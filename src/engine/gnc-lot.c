@@ -220,10 +220,14 @@ gnc_lot_free(GNCLot* lot)
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_DESTROY, NULL);
 
     priv = GET_PRIVATE(lot);
-    for (node = priv->splits; node; node = node->next)
+    /* When the book is closing the splits have been freed already. */
+    if (!qof_book_shutting_down (qof_instance_get_book (lot)))
     {
-        Split *s = node->data;
-        s->lot = NULL;
+        for (node = priv->splits; node; node = node->next)
+        {
+            Split *s = node->data;
+            s->lot = NULL;
+        }
     }
     g_list_free (priv->splits);
 
@@ -402,6 +406,8 @@ gnc_lot_get_balance (GNCLot *lot)
     GList *node;
     gnc_numeric zero = gnc_numeric_zero();
     gnc_numeric baln = zero;
+    gnc_numeric amounts[64];
+    guint n_amounts = 0;
     if (!lot) return zero;
 
     priv = GET_PRIVATE(lot);
@@ -417,9 +423,14 @@ gnc_lot_get_balance (GNCLot *lot)
     for (node = priv->splits; node; node = node->next)
     {
         Split *s = node->data;
-        gnc_numeric amt = xaccSplitGetAmount (s);
-        baln = gnc_numeric_add_fixed (baln, amt);
+        amounts[n_amounts++] = xaccSplitGetAmount (s);
+        if (n_amounts == G_N_ELEMENTS (amounts))
+        {
+            baln = gnc_numeric_sum_fixed (baln, amounts, n_amounts);
+            n_amounts = 0;
+        }
     }
+    baln = gnc_numeric_sum_fixed (baln, amounts, n_amounts);
 
     /* cache a zero balance as a closed lot */
     if (gnc_numeric_equal (baln, zero))
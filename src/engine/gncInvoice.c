@@ -339,7 +339,7 @@ GncInvoice *gncInvoiceCopy (const GncInvoice *from)
     invoice->active = from->active;
 
     is_cn = kvp_frame_get_gint64(from->inst.kvp_data, GNC_INVOICE_IS_CN);
-    kvp_frame_set_gint64(invoice->inst.kvp_data, GNC_INVOICE_IS_CN, is_cn);
+    kvp_frame_set_gint64(qof_instance_get_slots (QOF_INSTANCE (invoice)), GNC_INVOICE_IS_CN, is_cn);
 
     invoice->terms = from->terms;
     gncBillTermIncRef (invoice->terms);
@@ -531,7 +531,7 @@ void gncInvoiceSetIsCreditNote (GncInvoice *invoice, gboolean credit_note)
 {
     if (!invoice) return;
     gncInvoiceBeginEdit (invoice);
-    kvp_frame_set_gint64(invoice->inst.kvp_data, GNC_INVOICE_IS_CN,
+    kvp_frame_set_gint64(qof_instance_get_slots (QOF_INSTANCE (invoice)), GNC_INVOICE_IS_CN,
                          credit_note ? 1 : 0);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
@@ -850,6 +850,8 @@ gncInvoiceGetTotalInternal (GncInvoice *invoice, gboolean use_value,
 {
     GList *node;
     gnc_numeric total = gnc_numeric_zero();
+    gnc_numeric amounts[64];
+    guint n_amounts = 0;
     gboolean is_cust_doc, is_cn;
 
     g_return_val_if_fail (invoice, total);
@@ -872,7 +874,7 @@ gncInvoiceGetTotalInternal (GncInvoice *invoice, gboolean use_value,
         if (gnc_numeric_check (value) == GNC_ERROR_OK)
         {
             if (use_value)
-                total = gnc_numeric_add (total, value, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+                amounts[n_amounts++] = value;
         }
         else
             g_warning ("bad value in our entry");
@@ -881,12 +883,21 @@ gncInvoiceGetTotalInternal (GncInvoice *invoice, gboolean use_value,
         {
             tax = gncEntryGetDocTaxValue (entry, FALSE, is_cust_doc, is_cn);
             if (gnc_numeric_check (tax) == GNC_ERROR_OK)
-                total = gnc_numeric_add (total, tax, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+                amounts[n_amounts++] = tax;
             else
                 g_warning ("bad tax-value in our entry");
         }
+
+        /* Leave room for the next entry's value and tax */
+        if (n_amounts > G_N_ELEMENTS (amounts) - 2)
+        {
+            total = gnc_numeric_sum (total, amounts, n_amounts,
+                                     GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            n_amounts = 0;
+        }
     }
-    return total;
+    return gnc_numeric_sum (total, amounts, n_amounts,
+                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
 }
 
 gnc_numeric gncInvoiceGetTotal (GncInvoice *invoice)
@@ -1214,7 +1225,7 @@ gncInvoiceGetInvoiceFromTxn (const Transaction *txn)
     if (!txn) return NULL;
 
     book = xaccTransGetBook (txn);
-    kvp = xaccTransGetSlots (txn);
+    kvp = qof_instance_peek_slots (QOF_INSTANCE (txn));
     value = kvp_frame_get_slot_path (kvp, GNC_INVOICE_ID, GNC_INVOICE_GUID, NULL);
     if (!value) return NULL;
 
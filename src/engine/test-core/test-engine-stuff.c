@@ -2237,3 +2237,303 @@ remove_sx(SchedXaction *sx)
     SchedXactions *sxes = gnc_book_get_schedxactions(book);
     gnc_sxes_del_sx(sxes, sx);
 }
+
+/* ========================================================== */
+/* Benchmark books
+ *
+ * Unlike the random books above, which are meant to find bugs and so
+ * have odd commodities, bad data and random kvp, these are plain,
+ * consistent books that look like those of a household or a small
+ * business, only bigger.  They are made from a GRand, whose sequence is
+ * the same on every platform, so a seed always gives the same book,
+ * apart from the GUIDs.
+ */
+
+#define BENCH_FIRST_DAY  ((time64) 1104580800)  /* 2005-01-01 12:00 UTC */
+#define BENCH_DAY        (24 * 60 * 60)
+#define BENCH_N_DAYS     (10 * 365)
+#define BENCH_N_STOCKS   20
+
+static const char *bench_payees[] =
+{
+    "Grocery Store", "Electric Company", "Water Works", "Gas Station",
+    "Hardware Store", "Book Shop", "Restaurant", "Pharmacy",
+    "Insurance Company", "Phone Company", "Landlord", "Garage",
+    "Department Store", "Cinema", "Bakery", "Dentist",
+};
+#define BENCH_N_PAYEES (sizeof (bench_payees) / sizeof (bench_payees[0]))
+
+typedef struct
+{
+    QofBook *book;
+    GRand *rand;
+    gnc_commodity *currency;
+    gnc_commodity *stocks[BENCH_N_STOCKS];
+    GPtrArray *banks;
+    GPtrArray *expenses;
+    GPtrArray *incomes;
+    GPtrArray *holdings;
+    GList *edited;      /* accounts held open while the book is filled */
+} BenchBook;
+
+static Account *
+bench_account (BenchBook *bb, Account *parent, const char *name,
+               GNCAccountType type, gnc_commodity *commodity)
+{
+    Account *acc = xaccMallocAccount (bb->book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, commodity);
+    gnc_account_append_child (parent, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static void
+bench_accounts (BenchBook *bb, GPtrArray *accounts, Account *parent,
+                const char *prefix, GNCAccountType type, guint n)
+{
+    gchar name[64];
+    guint i;
+
+    for (i = 0; i < n; i++)
+    {
+        Account *acc;
+
+        g_snprintf (name, sizeof (name), "%s %u", prefix, i);
+        acc = bench_account (bb, parent, name, type, bb->currency);
+        g_ptr_array_add (accounts, acc);
+        xaccAccountBeginEdit (acc);
+        bb->edited = g_list_prepend (bb->edited, acc);
+    }
+}
+
+static void
+bench_account_tree (BenchBook *bb, guint n_splits)
+{
+    Account *root = gnc_book_get_root_account (bb->book);
+    Account *assets, *parent;
+    gchar name[64];
+    guint i;
+
+    assets = bench_account (bb, root, "Assets", ACCT_TYPE_ASSET, bb->currency);
+    bench_accounts (bb, bb->banks, assets, "Bank", ACCT_TYPE_BANK,
+                    CLAMP (n_splits / 100000, 2, 50));
+
+    parent = bench_account (bb, assets, "Investments", ACCT_TYPE_ASSET,
+                            bb->currency);
+    for (i = 0; i < BENCH_N_STOCKS; i++)
+    {
+        Account *acc;
+
+        g_snprintf (name, sizeof (name), "Stock %u", i);
+        acc = bench_account (bb, parent, name, ACCT_TYPE_STOCK,
+                             bb->stocks[i]);
+        g_ptr_array_add (bb->holdings, acc);
+        xaccAccountBeginEdit (acc);
+        bb->edited = g_list_prepend (bb->edited, acc);
+    }
+
+    parent = bench_account (bb, root, "Income", ACCT_TYPE_INCOME,
+                            bb->currency);
+    bench_accounts (bb, bb->incomes, parent, "Income", ACCT_TYPE_INCOME,
+                    CLAMP (n_splits / 200000, 2, 20));
+
+    parent = bench_account (bb, root, "Expenses", ACCT_TYPE_EXPENSE,
+                            bb->currency);
+    bench_accounts (bb, bb->expenses, parent, "Expense", ACCT_TYPE_EXPENSE,
+                    CLAMP (n_splits / 20000, 10, 500));
+}
+
+static gpointer
+bench_pick (BenchBook *bb, GPtrArray *array)
+{
+    return g_ptr_array_index (array, g_rand_int_range (bb->rand, 0,
+                              array->len));
+}
+
+static void
+bench_split (BenchBook *bb, Transaction *trans, Account *acc,
+             gnc_numeric amount, gnc_numeric value, char reconciled)
+{
+    Split *split = xaccMallocSplit (bb->book);
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, value);
+    xaccSplitSetReconcile (split, reconciled);
+}
+
+/* Add one transaction, dated at random in the book's ten years, and
+ * return the number of splits it has. */
+static guint
+bench_transaction (BenchBook *bb, guint n)
+{
+    Transaction *trans = xaccMallocTransaction (bb->book);
+    gint day = g_rand_int_range (bb->rand, 0, BENCH_N_DAYS);
+    gint kind = g_rand_int_range (bb->rand, 0, 100);
+    Account *bank = bench_pick (bb, bb->banks);
+    gnc_numeric amount, total;
+    char reconciled;
+    gchar num[16];
+    guint n_splits = 2;
+
+    /* Everything but the last year has been reconciled. */
+    if (day < BENCH_N_DAYS - 365)
+        reconciled = YREC;
+    else
+        reconciled = g_rand_boolean (bb->rand) ? CREC : NREC;
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, bb->currency);
+    xaccTransSetDatePostedSecs (trans, BENCH_FIRST_DAY + day * BENCH_DAY);
+    xaccTransSetDateEnteredSecs (trans, BENCH_FIRST_DAY + day * BENCH_DAY);
+    g_snprintf (num, sizeof (num), "%u", n);
+    xaccTransSetNum (trans, num);
+
+    amount = gnc_numeric_create (g_rand_int_range (bb->rand, 100, 100000),
+                                 100);
+    if (kind < 10)
+    {
+        /* A trade of whole shares at a price in cents. */
+        gint64 shares = g_rand_int_range (bb->rand, 1, 1000);
+        gint64 price = g_rand_int_range (bb->rand, 1000, 50000);
+
+        if (g_rand_boolean (bb->rand))
+            shares = -shares;
+        amount = gnc_numeric_create (shares * price, 100);
+        xaccTransSetDescription (trans, "Broker");
+        bench_split (bb, trans, bench_pick (bb, bb->holdings),
+                     gnc_numeric_create (shares, 1), amount, reconciled);
+        bench_split (bb, trans, bank, gnc_numeric_neg (amount),
+                     gnc_numeric_neg (amount), reconciled);
+    }
+    else if (kind < 20)
+    {
+        xaccTransSetDescription (trans, "Employer");
+        bench_split (bb, trans, bench_pick (bb, bb->incomes),
+                     gnc_numeric_neg (amount), gnc_numeric_neg (amount),
+                     NREC);
+        bench_split (bb, trans, bank, amount, amount, reconciled);
+    }
+    else if (kind < 35)
+    {
+        /* A receipt spread over a few expenses. */
+        guint i;
+
+        n_splits = g_rand_int_range (bb->rand, 3, 6);
+        total = gnc_numeric_zero ();
+        xaccTransSetDescription (trans, "Department Store");
+        for (i = 1; i < n_splits; i++)
+        {
+            amount = gnc_numeric_create (g_rand_int_range (bb->rand, 100,
+                                         20000), 100);
+            total = gnc_numeric_add (total, amount, 100, GNC_HOW_RND_NEVER);
+            bench_split (bb, trans, bench_pick (bb, bb->expenses), amount,
+                         amount, NREC);
+        }
+        bench_split (bb, trans, bank, gnc_numeric_neg (total),
+                     gnc_numeric_neg (total), reconciled);
+    }
+    else
+    {
+        xaccTransSetDescription (trans, bench_payees[g_rand_int_range
+                                 (bb->rand, 0, BENCH_N_PAYEES)]);
+        bench_split (bb, trans, bench_pick (bb, bb->expenses), amount,
+                     amount, NREC);
+        bench_split (bb, trans, bank, gnc_numeric_neg (amount),
+                     gnc_numeric_neg (amount), reconciled);
+    }
+    xaccTransCommitEdit (trans);
+    return n_splits;
+}
+
+/* A price a week for each stock, wandering a little from week to week. */
+static void
+bench_prices (BenchBook *bb)
+{
+    GNCPriceDB *db = gnc_pricedb_get_db (bb->book);
+    guint i, week;
+
+    gnc_pricedb_set_bulk_update (db, TRUE);
+    for (i = 0; i < BENCH_N_STOCKS; i++)
+    {
+        gint64 price = g_rand_int_range (bb->rand, 1000, 50000);
+
+        for (week = 0; week < BENCH_N_DAYS / 7; week++)
+        {
+            GNCPrice *p = gnc_price_create (bb->book);
+            Timespec ts = { BENCH_FIRST_DAY + week * 7 * BENCH_DAY, 0 };
+
+            price += price * g_rand_int_range (bb->rand, -50, 51) / 1000;
+            price = MAX (price, 100);
+            gnc_price_begin_edit (p);
+            gnc_price_set_commodity (p, bb->stocks[i]);
+            gnc_price_set_currency (p, bb->currency);
+            gnc_price_set_time (p, ts);
+            gnc_price_set_source (p, "user:price");
+            gnc_price_set_typestr (p, "last");
+            gnc_price_set_value (p, gnc_numeric_create (price, 100));
+            gnc_price_commit_edit (p);
+            gnc_pricedb_add_price (db, p);
+            gnc_price_unref (p);
+        }
+    }
+    gnc_pricedb_set_bulk_update (db, FALSE);
+}
+
+void
+make_benchmark_book (QofBook *book, guint32 seed, gint n_splits)
+{
+    gnc_commodity_table *table;
+    BenchBook bb;
+    gchar name[32];
+    GList *node;
+    guint i, n = 0;
+
+    g_return_if_fail (book);
+
+    memset (&bb, 0, sizeof (bb));
+    bb.book = book;
+    bb.rand = g_rand_new_with_seed (seed);
+    bb.banks = g_ptr_array_new ();
+    bb.expenses = g_ptr_array_new ();
+    bb.incomes = g_ptr_array_new ();
+    bb.holdings = g_ptr_array_new ();
+
+    table = gnc_commodity_table_get_table (book);
+    bb.currency = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                              "USD");
+    if (!bb.currency)
+        bb.currency = gnc_commodity_table_insert (table,
+                      gnc_commodity_new (book, "US Dollar",
+                                         GNC_COMMODITY_NS_CURRENCY, "USD",
+                                         "840", 100));
+    for (i = 0; i < BENCH_N_STOCKS; i++)
+    {
+        g_snprintf (name, sizeof (name), "STK%02u", i);
+        bb.stocks[i] = gnc_commodity_table_insert (table,
+                       gnc_commodity_new (book, name, GNC_COMMODITY_NS_NASDAQ,
+                                          name, NULL, 1));
+    }
+
+    /* The accounts are held open while the transactions go in, so that
+     * they sort their splits and add up their balances once, at the end. */
+    bench_account_tree (&bb, MAX (n_splits, 0));
+    while (n < (guint) MAX (n_splits, 0))
+        n += bench_transaction (&bb, n);
+    for (node = bb.edited; node; node = node->next)
+        xaccAccountCommitEdit (node->data);
+
+    bench_prices (&bb);
+
+    g_list_free (bb.edited);
+    g_ptr_array_free (bb.banks, TRUE);
+    g_ptr_array_free (bb.expenses, TRUE);
+    g_ptr_array_free (bb.incomes, TRUE);
+    g_ptr_array_free (bb.holdings, TRUE);
+    g_rand_free (bb.rand);
+}
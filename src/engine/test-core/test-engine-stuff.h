@@ -74,6 +74,12 @@ QofSession * get_random_session (void);
 
 void add_random_transactions_to_book (QofBook *book, gint num_transactions);
 
+/** Fill an empty book with a plain, consistent book of about n_splits
+ *  splits for benchmarks: a tree of bank, stock, income and expense
+ *  accounts, ten years of transactions and a weekly price for each
+ *  stock.  The same seed always makes the same book. */
+void make_benchmark_book (QofBook *book, guint32 seed, gint n_splits);
+
 void make_random_changes_to_commodity (gnc_commodity *com);
 void make_random_changes_to_commodity_table (gnc_commodity_table *table);
 void make_random_changes_to_price (QofBook *book, GNCPrice *price);
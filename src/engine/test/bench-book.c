@@ -0,0 +1,371 @@
+/***************************************************************************
+ *            bench-book.c
+ *
+ *  Time the common operations on a big book.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+/* Not run by "make check": run it by hand as
+ *
+ *   bench-book [--seed=N] [--splits=N] [--stats] [--output=FILE]
+ *
+ * It makes a book of about the given number of splits with
+ * make_benchmark_book() -- the sizes we keep an eye on are 10000,
+ * 1000000 and 10000000 -- and times balances, queries, price lookups,
+ * scrubbing and saving and loading it with the XML and SQLite backends.
+ * The same seed always gives the same book, so runs on different
+ * builds can be compared.
+ *
+ * The results are written as a JSON object, with one entry for each
+ * operation giving how many times it was done and how long that took in
+ * all.  With --stats the engine statistics gathered during the run are
+ * added to it.
+ *
+ * The backends are loaded from the build tree; use --xml-dir and
+ * --dbi-dir to load them from somewhere else.  A backend that can't be
+ * loaded is skipped.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Query.h"
+#include "Scrub.h"
+#include "TransLog.h"
+#include "gnc-commodity.h"
+#include "gnc-pricedb.h"
+#include "test-engine-stuff.h"
+
+#define FIRST_YEAR        2005
+#define N_YEARS           10
+#define N_PRICE_LOOKUPS   100000
+#define N_SCANS           5
+
+static gint         seed          = 1;
+static gint         n_splits      = 10000;
+static gboolean     gather_stats  = FALSE;
+static const gchar *output        = NULL;
+static const gchar *xml_dir       = "../../backend/xml/.libs";
+static const gchar *dbi_dir       = "../../backend/dbi/.libs";
+
+static GOptionEntry options[] =
+{
+    { "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed for the book", "N" },
+    { "splits", 0, 0, G_OPTION_ARG_INT, &n_splits, "Splits in the book", "N" },
+    { "stats", 0, 0, G_OPTION_ARG_NONE, &gather_stats,
+      "Add the engine statistics to the results", NULL },
+    { "output", 0, 0, G_OPTION_ARG_STRING, &output,
+      "Write the results to FILE instead of the standard output", "FILE" },
+    { "xml-dir", 0, 0, G_OPTION_ARG_STRING, &xml_dir,
+      "Load the XML backend from DIR", "DIR" },
+    { "dbi-dir", 0, 0, G_OPTION_ARG_STRING, &dbi_dir,
+      "Load the SQL backend from DIR", "DIR" },
+    { NULL }
+};
+
+typedef struct
+{
+    GString *json;
+    GTimer *timer;
+    gboolean first;
+} Results;
+
+static void
+start (Results *results)
+{
+    g_timer_start (results->timer);
+}
+
+static void
+report (Results *results, const char *name, guint count)
+{
+    gdouble seconds = g_timer_elapsed (results->timer, NULL);
+
+    g_string_append_printf (results->json,
+                            "%s\n    {\"name\": \"%s\", \"count\": %u, "
+                            "\"seconds\": %.6f}",
+                            results->first ? "" : ",", name, count, seconds);
+    results->first = FALSE;
+}
+
+static time64
+month_start (int month, int year)
+{
+    return gnc_dmy2timespec (1, month, year).tv_sec;
+}
+
+static time64
+year_start (int year)
+{
+    return month_start (1, year);
+}
+
+static void
+bench_balances (Results *results, QofBook *book)
+{
+    GList *accounts, *node;
+    guint n = 0;
+    int year, month;
+
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    for (node = accounts; node; node = node->next)
+    {
+        gnc_account_set_sort_dirty (node->data);
+        gnc_account_set_balance_dirty (node->data);
+    }
+    start (results);
+    for (node = accounts; node; node = node->next)
+        xaccAccountGetBalance (node->data);
+    report (results, "balance-recompute", g_list_length (accounts));
+
+    start (results);
+    for (node = accounts; node; node = node->next)
+        for (year = FIRST_YEAR; year < FIRST_YEAR + N_YEARS; year++)
+            for (month = 1; month <= 12; month++, n++)
+                xaccAccountGetBalanceAsOfDate (node->data,
+                                               month_start (month, year));
+    report (results, "balance-as-of", n);
+    g_list_free (accounts);
+}
+
+static void
+bench_queries (Results *results, QofBook *book)
+{
+    GList *accounts, *node;
+    QofQuery *q;
+    guint n = 0, i;
+    int year;
+
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    start (results);
+    for (node = accounts; node; node = node->next)
+    {
+        if (xaccAccountGetType (node->data) != ACCT_TYPE_BANK)
+            continue;
+        for (year = FIRST_YEAR; year < FIRST_YEAR + N_YEARS; year++, n++)
+        {
+            q = qof_query_create_for (GNC_ID_SPLIT);
+            qof_query_set_book (q, book);
+            xaccQueryAddSingleAccountMatch (q, node->data, QOF_QUERY_AND);
+            xaccQueryAddDateMatchTT (q, TRUE, year_start (year),
+                                     TRUE, year_start (year + 1) - 1,
+                                     QOF_QUERY_AND);
+            qof_query_run (q);
+            qof_query_destroy (q);
+        }
+    }
+    report (results, "query-account-dates", n);
+    g_list_free (accounts);
+
+    /* This one can't use an index, so it scans all the splits. */
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDescriptionMatch (q, "Grocery", TRUE, FALSE, QOF_QUERY_AND);
+    start (results);
+    for (i = 0; i < N_SCANS; i++)
+        qof_query_run (q);
+    report (results, "query-description", N_SCANS);
+    qof_query_destroy (q);
+}
+
+static void
+bench_prices (Results *results, QofBook *book)
+{
+    gnc_commodity_table *table = gnc_commodity_table_get_table (book);
+    GNCPriceDB *db = gnc_pricedb_get_db (book);
+    gnc_commodity *currency;
+    GList *stocks;
+    GRand *rand = g_rand_new_with_seed (seed);
+    guint i, n_stocks;
+
+    currency = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                           "USD");
+    stocks = gnc_commodity_table_get_commodities (table,
+                                                  GNC_COMMODITY_NS_NASDAQ);
+    n_stocks = g_list_length (stocks);
+    if (n_stocks)
+    {
+        start (results);
+        for (i = 0; i < N_PRICE_LOOKUPS; i++)
+        {
+            gnc_commodity *stock = g_list_nth_data (stocks,
+                                                    g_rand_int_range (rand, 0, n_stocks));
+            Timespec ts = { g_rand_int_range (rand, year_start (FIRST_YEAR),
+                                              year_start (FIRST_YEAR + N_YEARS)), 0 };
+            GNCPrice *price = gnc_pricedb_lookup_nearest_in_time (db, stock,
+                              currency, ts);
+            gnc_price_unref (price);
+        }
+        report (results, "price-lookup", N_PRICE_LOOKUPS);
+    }
+    g_list_free (stocks);
+    g_rand_free (rand);
+}
+
+static void
+bench_scrub (Results *results, QofBook *book)
+{
+    Account *root = gnc_book_get_root_account (book);
+
+    start (results);
+    xaccAccountTreeScrubOrphans (root);
+    xaccAccountTreeScrubImbalance (root);
+    report (results, "scrub", 1);
+}
+
+/* Save the book with the backend for url, and load it back. */
+static void
+bench_backend (Results *results, QofSession *session, const char *name,
+               const char *scheme, const char *path)
+{
+    gchar *url = g_strdup_printf ("%s://%s", scheme, path);
+    gchar *what;
+    QofSession *other;
+
+    other = qof_session_new ();
+    qof_session_begin (other, url, FALSE, TRUE, TRUE);
+    if (qof_session_get_error (other) != ERR_BACKEND_NO_ERR)
+    {
+        g_printerr ("can't open %s: %s\n", url,
+                    qof_session_get_error_message (other));
+        qof_session_destroy (other);
+        g_free (url);
+        return;
+    }
+    qof_session_swap_data (session, other);
+    start (results);
+    qof_session_save (other, NULL);
+    what = g_strdup_printf ("%s-save", name);
+    report (results, what, 1);
+    g_free (what);
+    qof_session_swap_data (other, session);
+    qof_session_end (other);
+    qof_session_destroy (other);
+
+    other = qof_session_new ();
+    qof_session_begin (other, url, TRUE, FALSE, FALSE);
+    start (results);
+    qof_session_load (other, NULL);
+    what = g_strdup_printf ("%s-load", name);
+    report (results, what, 1);
+    g_free (what);
+    if (qof_session_get_error (other) != ERR_BACKEND_NO_ERR)
+        g_printerr ("can't load %s: %s\n", url,
+                    qof_session_get_error_message (other));
+    qof_session_end (other);
+    qof_session_destroy (other);
+
+    g_unlink (path);
+    g_free (url);
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    Results results;
+    QofSession *session;
+    QofBook *book;
+    gchar *path;
+    FILE *out = stdout;
+
+    context = g_option_context_new ("- time the common operations on a big book");
+    g_option_context_add_main_entries (context, options, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        return 1;
+    }
+    g_option_context_free (context);
+    if (output && !(out = g_fopen (output, "w")))
+    {
+        g_printerr ("can't write %s\n", output);
+        return 1;
+    }
+
+    qof_init ();
+    if (!cashobjects_register ())
+    {
+        g_printerr ("can't register the engine objects\n");
+        return 1;
+    }
+    xaccLogDisable ();
+    qof_stats_set_enabled (gather_stats);
+
+    results.json = g_string_new (NULL);
+    results.timer = g_timer_new ();
+    results.first = TRUE;
+
+    session = qof_session_new ();
+    book = qof_session_get_book (session);
+    start (&results);
+    make_benchmark_book (book, seed, n_splits);
+    report (&results, "generate", n_splits);
+
+    bench_balances (&results, book);
+    bench_queries (&results, book);
+    bench_prices (&results, book);
+    bench_scrub (&results, book);
+
+    path = g_strdup_printf ("%s/bench-book-%d.gnucash", g_get_tmp_dir (),
+                            getpid ());
+    if (qof_load_backend_library (xml_dir, "gncmod-backend-xml"))
+        bench_backend (&results, session, "xml", "xml", path);
+    else
+        g_printerr ("no XML backend in %s\n", xml_dir);
+    g_free (path);
+
+    path = g_strdup_printf ("%s/bench-book-%d.sqlite", g_get_tmp_dir (),
+                            getpid ());
+    if (qof_load_backend_library (dbi_dir, "gncmod-backend-dbi"))
+        bench_backend (&results, session, "sqlite", "sqlite3", path);
+    else
+        g_printerr ("no SQL backend in %s\n", dbi_dir);
+    g_free (path);
+
+    fprintf (out, "{\n  \"seed\": %d,\n  \"splits\": %u,\n"
+             "  \"transactions\": %u,\n  \"results\": [%s\n  ]",
+             seed,
+             qof_collection_count (qof_book_get_collection (book,
+                                   GNC_ID_SPLIT)),
+             qof_collection_count (qof_book_get_collection (book,
+                                   GNC_ID_TRANS)),
+             results.json->str);
+    if (gather_stats)
+    {
+        gchar *stats = qof_stats_to_json ();
+        fprintf (out, ",\n  \"stats\": %s", stats);
+        g_free (stats);
+    }
+    fprintf (out, "\n}\n");
+    if (out != stdout)
+        fclose (out);
+
+    g_string_free (results.json, TRUE);
+    g_timer_destroy (results.timer);
+    qof_session_destroy (session);
+    qof_close ();
+    return 0;
+}
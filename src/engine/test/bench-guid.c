@@ -0,0 +1,131 @@
+/***************************************************************************
+ *            bench-guid.c
+ *
+ *  Measure how fast GUIDs can be made.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+/* Not run by "make check": run it by hand as
+ *
+ *   bench-guid [number of guids] [number of transactions]
+ *
+ * It times guid_new() and guid_new_batch() against the way guid_new()
+ * used to make each id, by finishing a copy of an md5 context and
+ * feeding the time and the new id back into it, and then times adding
+ * transactions to a random book, which makes a guid for each
+ * transaction and split.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef HAVE_SYS_TIMES_H
+# include <sys/times.h>
+#endif
+#include <glib.h>
+#include "qof.h"
+#include "md5.h"
+#include "cashobjects.h"
+#include "TransLog.h"
+#include "test-engine-stuff.h"
+#include "test-stuff.h"
+
+#define BATCH_SIZE 256
+
+static void
+md5_guid_new (struct md5_ctx *context, GncGUID *guid)
+{
+    static int counter = 0;
+    struct md5_ctx ctx = *context;
+    time64 now = gnc_time (NULL);
+    int salt = 433781 * counter++;
+#ifdef HAVE_SYS_TIMES_H
+    struct tms tms_buf;
+    clock_t clocks;
+#endif
+
+    md5_finish_ctx (&ctx, guid->data);
+    md5_process_bytes (&now, sizeof (now), context);
+#ifdef HAVE_SYS_TIMES_H
+    clocks = times (&tms_buf);
+    md5_process_bytes (&clocks, sizeof (clocks), context);
+    md5_process_bytes (&tms_buf, sizeof (tms_buf), context);
+#endif
+    md5_process_bytes (&salt, sizeof (salt), context);
+    md5_process_bytes (guid->data, GUID_DATA_SIZE, context);
+}
+
+static void
+report (const char *what, guint n, gdouble seconds)
+{
+    printf ("%-28s %8.3f s  %10.0f per second\n", what, seconds,
+            seconds > 0 ? n / seconds : 0);
+}
+
+int
+main (int argc, char **argv)
+{
+    guint n_guids = argc > 1 ? atoi (argv[1]) : 1000000;
+    gint n_trans = argc > 2 ? atoi (argv[2]) : 100000;
+    GncGUID guids[BATCH_SIZE];
+    struct md5_ctx context;
+    GTimer *timer;
+    QofBook *book;
+    guint i;
+
+    qof_init ();
+    xaccLogDisable ();
+    srand (0);
+    if (!cashobjects_register ())
+    {
+        failure ("can't register cashobjects");
+        return get_rv ();
+    }
+    guid_init ();
+    timer = g_timer_new ();
+
+    md5_init_ctx (&context);
+    md5_process_bytes (&n_guids, sizeof (n_guids), &context);
+    g_timer_start (timer);
+    for (i = 0; i < n_guids; i++)
+        md5_guid_new (&context, &guids[i % BATCH_SIZE]);
+    report ("md5 per guid", n_guids, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n_guids; i++)
+        guid_new (&guids[i % BATCH_SIZE]);
+    report ("guid_new", n_guids, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n_guids; i += BATCH_SIZE)
+        guid_new_batch (guids, MIN (BATCH_SIZE, n_guids - i));
+    report ("guid_new_batch", n_guids, g_timer_elapsed (timer, NULL));
+
+    book = get_random_book ();
+    g_timer_start (timer);
+    add_random_transactions_to_book (book, n_trans);
+    report ("adding transactions", n_trans, g_timer_elapsed (timer, NULL));
+    printf ("splits: %u\n",
+            qof_collection_count (qof_book_get_collection (book,
+                                  GNC_ID_SPLIT)));
+
+    g_timer_destroy (timer);
+    qof_book_destroy (book);
+    qof_close ();
+    return 0;
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *            bench-kvp-memory.c
+ *
+ *  Measure how much memory the KvpFrames of a large book take.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+/* Not run by "make check": run it by hand as
+ *
+ *   bench-kvp-memory [number of transactions]
+ *
+ * It builds a random book, then converts every KvpFrame in it to the
+ * hash table representation all frames used to have, and reports the
+ * resident size of the process before and after.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "TransLog.h"
+#include "test-engine-stuff.h"
+#include "test-stuff.h"
+
+static glong
+resident_kib (void)
+{
+    glong size = 0, resident = 0;
+    FILE *statm = fopen ("/proc/self/statm", "r");
+
+    if (!statm) return -1;
+    if (fscanf (statm, "%ld %ld", &size, &resident) != 2)
+        resident = -1;
+    fclose (statm);
+    return resident < 0 ? -1 : resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+static void make_hash (KvpFrame *frame, guint *n_frames);
+
+static void
+make_hash_slot (const char *key, KvpValue *value, gpointer data)
+{
+    if (kvp_value_get_type (value) == KVP_TYPE_FRAME)
+        make_hash (kvp_value_get_frame (value), data);
+}
+
+static void
+make_hash (KvpFrame *frame, guint *n_frames)
+{
+    if (!frame) return;
+    (*n_frames)++;
+    kvp_frame_for_each_slot (frame, make_hash_slot, n_frames);
+    kvp_frame_convert_to_hash (frame);
+}
+
+static void
+make_hash_instance (QofInstance *inst, gpointer data)
+{
+    make_hash (qof_instance_get_slots (inst), data);
+}
+
+int
+main (int argc, char **argv)
+{
+    QofBook *book;
+    gint n_trans = argc > 1 ? atoi (argv[1]) : 100000;
+    guint n_frames = 0;
+    glong before, after;
+
+    qof_init ();
+    xaccLogDisable ();
+    srand (0);
+    if (!cashobjects_register ())
+    {
+        failure ("can't register cashobjects");
+        return get_rv ();
+    }
+
+    book = get_random_book ();
+    add_random_transactions_to_book (book, n_trans);
+    before = resident_kib ();
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_SPLIT),
+                            make_hash_instance, &n_frames);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            make_hash_instance, &n_frames);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            make_hash_instance, &n_frames);
+    after = resident_kib ();
+
+    printf ("transactions: %d\nframes: %u\n", n_trans, n_frames);
+    printf ("resident with small frames: %ld KiB\n", before);
+    printf ("resident with hash frames:  %ld KiB\n", after);
+    if (before > 0 && n_frames)
+        printf ("saved per frame: %.1f bytes\n",
+                (after - before) * 1024.0 / n_frames);
+
+    qof_book_destroy (book);
+    qof_close ();
+    return 0;
+}
@@ -0,0 +1,329 @@
+/***************************************************************************
+ *            test-book-readers.c
+ *
+ *  Several threads querying and taking balances from one book while
+ *  another one keeps adding transactions to it, and a transaction is
+ *  left open.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Query.h"
+#include "Split.h"
+#include "TransLog.h"
+#include "Transaction.h"
+#include "gnc-commodity.h"
+#include "gnc-engine.h"
+#include "test-stuff.h"
+
+#define N_ACCOUNTS 4
+#define N_TRANS    400
+#define N_DATES    8
+#define N_READERS  4
+#define N_ROUNDS   20
+#define N_WRITES   50
+#define DAY        (24 * 60 * 60)
+#define FIRST_DAY  ((time64) 1262304000)  /* 2010-01-01 */
+
+typedef struct
+{
+    QofBook *book;
+    Account *accounts[N_ACCOUNTS];
+    time64 dates[N_DATES];
+    gnc_numeric balances[N_ACCOUNTS][N_DATES];
+    guint n_splits[N_ACCOUNTS];
+    Account *scratch[2];
+    gnc_commodity *currency;
+} Ledger;
+
+typedef struct
+{
+    Ledger *ledger;
+    guint bad_balances;
+    guint bad_queries;
+    guint unsorted;
+} Reader;
+
+static Account *
+make_account (Ledger *ledger, Account *root, const char *name)
+{
+    Account *acc = xaccMallocAccount (ledger->book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (acc, ledger->currency);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static void
+make_transaction (Ledger *ledger, Account *from, Account *to, int i)
+{
+    Transaction *trans = xaccMallocTransaction (ledger->book);
+    gnc_numeric amount = gnc_numeric_create (100 + (i * 37) % 10000, 100);
+    Split *split;
+    gchar buf[32];
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, ledger->currency);
+    /* Post out of order, so that the accounts have sorting to do. */
+    xaccTransSetDatePostedSecs (trans, FIRST_DAY + ((i * 7919) % 1000) * DAY);
+    g_snprintf (buf, sizeof (buf), "%d", i % 97);
+    xaccTransSetNum (trans, buf);
+    g_snprintf (buf, sizeof (buf), "Transaction %d", i % 13);
+    xaccTransSetDescription (trans, buf);
+
+    split = xaccMallocSplit (ledger->book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, from);
+    xaccSplitSetAmount (split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (split, gnc_numeric_neg (amount));
+
+    split = xaccMallocSplit (ledger->book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, to);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+    xaccTransCommitEdit (trans);
+}
+
+static void
+make_ledger (Ledger *ledger)
+{
+    Account *root;
+    gchar name[32];
+    int i, j;
+
+    ledger->book = qof_book_new ();
+    ledger->currency = gnc_commodity_new (ledger->book, "US Dollar",
+                                          GNC_COMMODITY_NS_CURRENCY, "USD",
+                                          "840", 100);
+    root = gnc_account_create_root (ledger->book);
+    for (i = 0; i < N_ACCOUNTS; i++)
+    {
+        g_snprintf (name, sizeof (name), "Account %d", i);
+        ledger->accounts[i] = make_account (ledger, root, name);
+    }
+    ledger->scratch[0] = make_account (ledger, root, "Scratch 0");
+    ledger->scratch[1] = make_account (ledger, root, "Scratch 1");
+
+    for (i = 0; i < N_TRANS; i++)
+        make_transaction (ledger, ledger->accounts[i % N_ACCOUNTS],
+                          ledger->accounts[(i * 3 + 1) % N_ACCOUNTS], i);
+
+    /* The answers, worked out before anyone else is about. */
+    for (j = 0; j < N_DATES; j++)
+        ledger->dates[j] = FIRST_DAY + (j * 1000 / N_DATES) * DAY;
+    for (i = 0; i < N_ACCOUNTS; i++)
+    {
+        Account *acc = ledger->accounts[i];
+
+        for (j = 0; j < N_DATES; j++)
+            ledger->balances[i][j] =
+                xaccAccountGetBalanceAsOfDate (acc, ledger->dates[j]);
+        ledger->n_splits[i] = g_list_length (xaccAccountGetSplitList (acc));
+
+        /* Make the readers fill the caches in again. */
+        gnc_account_set_sort_dirty (acc);
+        gnc_account_set_balance_dirty (acc);
+    }
+}
+
+static void
+check_query (Reader *reader, Account *acc, guint n_splits)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *node;
+    Split *prev = NULL;
+
+    qof_query_set_book (q, reader->ledger->book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    qof_query_set_sort_order (q, g_slist_prepend (NULL, QUERY_DEFAULT_SORT),
+                              NULL, NULL);
+    node = qof_query_run (q);
+    if (g_list_length (node) != n_splits)
+        reader->bad_queries++;
+    for (; node; node = node->next)
+    {
+        Split *split = node->data;
+
+        if (xaccSplitGetAccount (split) != acc)
+            reader->bad_queries++;
+        if (prev && xaccSplitOrder (prev, split) > 0)
+            reader->unsorted++;
+        prev = split;
+    }
+    qof_query_destroy (q);
+}
+
+static gpointer
+reader_thread (gpointer data)
+{
+    Reader *reader = data;
+    Ledger *ledger = reader->ledger;
+    int round, i, j;
+
+    for (round = 0; round < N_ROUNDS; round++)
+    {
+        qof_book_read_lock (ledger->book);
+        for (i = 0; i < N_ACCOUNTS; i++)
+        {
+            Account *acc = ledger->accounts[(i + round) % N_ACCOUNTS];
+            int n = (i + round) % N_ACCOUNTS;
+
+            for (j = 0; j < N_DATES; j++)
+            {
+                gnc_numeric balance =
+                    xaccAccountGetBalanceAsOfDate (acc, ledger->dates[j]);
+                if (!gnc_numeric_equal (balance, ledger->balances[n][j]))
+                    reader->bad_balances++;
+            }
+            check_query (reader, acc, ledger->n_splits[n]);
+        }
+        qof_book_read_unlock (ledger->book);
+    }
+    return NULL;
+}
+
+static gpointer
+writer_thread (gpointer data)
+{
+    Ledger *ledger = data;
+    int i;
+
+    /* Only the scratch accounts change, so the readers' answers don't. */
+    for (i = 0; i < N_WRITES; i++)
+    {
+        make_transaction (ledger, ledger->scratch[0], ledger->scratch[1], i);
+        g_thread_yield ();
+    }
+    return NULL;
+}
+
+/* A thread reading the book mustn't change it under the other readers,
+ * nor wait for them to finish. */
+static void
+check_write_while_reading (Ledger *ledger)
+{
+    Transaction *trans;
+
+    qof_book_read_lock (ledger->book);
+    trans = xaccSplitGetParent (xaccAccountGetSplitList (ledger->accounts[0])->data);
+    do_test (!qof_book_write_lock (ledger->book),
+             "no write lock for a reading thread");
+    do_test (!qof_begin_edit (QOF_INSTANCE (trans)),
+             "no edit begun by a reading thread");
+    do_test (!xaccTransIsOpen (trans), "transaction left closed");
+    do_test (!qof_commit_edit (QOF_INSTANCE (trans)),
+             "no edit committed by a reading thread");
+    do_test (!qof_commit_edit_part2 (QOF_INSTANCE (trans), NULL, NULL, NULL),
+             "no commit by a reading thread");
+    do_test (qof_instance_get_editlevel (trans) == 0, "editlevel unchanged");
+    do_test (!qof_book_is_writing (ledger->book), "book not written");
+    qof_book_read_unlock (ledger->book);
+}
+
+static GThread *
+start_thread (GThreadFunc func, gpointer data)
+{
+#ifdef HAVE_GLIB_2_32
+    return g_thread_new ("book-readers", func, data);
+#else
+    return g_thread_create (func, data, TRUE, NULL);
+#endif
+}
+
+static void
+run_test (void)
+{
+    Ledger ledger;
+    Reader readers[N_READERS];
+    GThread *threads[N_READERS + 1];
+    Transaction *pending;
+    int i;
+
+#ifndef HAVE_GLIB_2_32
+    if (!g_thread_supported ())
+    {
+        success ("no threads, nothing to test");
+        return;
+    }
+#endif
+    make_ledger (&ledger);
+
+    /* Keep a transaction open the whole time, as a register keeps the
+     * one being entered; the readers would wait for it forever if it
+     * held on to the write lock. */
+    pending = xaccMallocTransaction (ledger.book);
+    xaccTransBeginEdit (pending);
+    qof_instance_release_edit_lock (QOF_INSTANCE (pending));
+    xaccTransSetCurrency (pending, ledger.currency);
+    do_test (!qof_book_is_writing (ledger.book),
+             "open transaction lets others read");
+
+    for (i = 0; i < N_READERS; i++)
+    {
+        readers[i].ledger = &ledger;
+        readers[i].bad_balances = 0;
+        readers[i].bad_queries = 0;
+        readers[i].unsorted = 0;
+        threads[i] = start_thread (reader_thread, &readers[i]);
+    }
+    threads[N_READERS] = start_thread (writer_thread, &ledger);
+    check_write_while_reading (&ledger);
+    for (i = 0; i <= N_READERS; i++)
+        g_thread_join (threads[i]);
+    xaccTransSetDescription (pending, "Entered while others read");
+    xaccTransDestroy (pending);
+    xaccTransCommitEdit (pending);
+
+    for (i = 0; i < N_READERS; i++)
+    {
+        do_test (readers[i].bad_balances == 0,
+                 "balances read from several threads");
+        do_test (readers[i].bad_queries == 0,
+                 "queries run from several threads");
+        do_test (readers[i].unsorted == 0,
+                 "query results sorted on several threads");
+    }
+    do_test (g_list_length (xaccAccountGetSplitList (ledger.scratch[0]))
+             == N_WRITES, "writes made while the book was read");
+    do_test (!qof_book_has_readers (ledger.book), "all readers finished");
+
+    qof_book_destroy (ledger.book);
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init ();
+    if (cashobjects_register ())
+    {
+        xaccLogDisable ();
+        run_test ();
+        print_test_results ();
+    }
+    qof_close ();
+    return get_rv ();
+}
@@ -0,0 +1,404 @@
+/***************************************************************************
+ *            test-book-snapshot.c
+ *
+ *  Book snapshots keep showing the accounts and transactions as they
+ *  were when taken, while the book is edited, from this thread and
+ *  from another one.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Split.h"
+#include "TransLog.h"
+#include "Transaction.h"
+#include "gnc-book-snapshot.h"
+#include "gnc-commodity.h"
+#include "gnc-engine.h"
+#include "test-stuff.h"
+
+#define N_TRANS   100
+#define N_ROUNDS  20
+
+typedef struct
+{
+    QofBook *book;
+    Account *from;
+    Account *to;
+    Transaction *trans[N_TRANS];
+    gnc_commodity *currency;
+} Ledger;
+
+typedef struct
+{
+    GncBookSnapshot *snapshot;
+    Ledger *ledger;
+    guint n_trans;
+    guint bad_descriptions;
+    guint bad_accounts;
+    gnc_numeric total;
+    gboolean saw_new;
+    guint bad_rounds;
+} Census;
+
+static Account *
+make_account (Ledger *ledger, Account *root, const char *name)
+{
+    Account *acc = xaccMallocAccount (ledger->book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (acc, ledger->currency);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static Transaction *
+make_transaction (Ledger *ledger, const char *description, gint64 cents)
+{
+    Transaction *trans = xaccMallocTransaction (ledger->book);
+    gnc_numeric amount = gnc_numeric_create (cents, 100);
+    Split *split;
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, ledger->currency);
+    xaccTransSetDatePostedSecs (trans, 1262304000);
+    xaccTransSetDescription (trans, description);
+
+    split = xaccMallocSplit (ledger->book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, ledger->from);
+    xaccSplitSetAmount (split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (split, gnc_numeric_neg (amount));
+
+    split = xaccMallocSplit (ledger->book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, ledger->to);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+    xaccTransCommitEdit (trans);
+    return trans;
+}
+
+static void
+set_amount (Transaction *trans, gint64 cents)
+{
+    gnc_numeric amount = gnc_numeric_create (cents, 100);
+    GList *node;
+
+    xaccTransBeginEdit (trans);
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        gnc_numeric value = gnc_numeric_negative_p (xaccSplitGetValue (split))
+                            ? gnc_numeric_neg (amount) : amount;
+        xaccSplitSetAmount (split, value);
+        xaccSplitSetValue (split, value);
+    }
+    xaccTransCommitEdit (trans);
+}
+
+static void
+make_ledger (Ledger *ledger)
+{
+    Account *root;
+    int i;
+
+    ledger->book = qof_book_new ();
+    ledger->currency = gnc_commodity_new (ledger->book, "US Dollar",
+                                          GNC_COMMODITY_NS_CURRENCY, "USD",
+                                          "840", 100);
+    root = gnc_account_create_root (ledger->book);
+    ledger->from = make_account (ledger, root, "From");
+    ledger->to = make_account (ledger, root, "To");
+    for (i = 0; i < N_TRANS; i++)
+        ledger->trans[i] = make_transaction (ledger, "Old", 100);
+}
+
+/* Tally what the snapshot holds; every transaction was made as "Old",
+ * moving a dollar from "From" to "To". */
+static gint
+census_transaction (Transaction *trans, gpointer data)
+{
+    Census *census = data;
+    GList *node;
+
+    census->n_trans++;
+    if (g_strcmp0 (xaccTransGetDescription (trans), "New") == 0)
+        census->saw_new = TRUE;
+    else if (g_strcmp0 (xaccTransGetDescription (trans), "Old") != 0)
+        census->bad_descriptions++;
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *acc = gnc_book_snapshot_get_account (census->snapshot,
+                       xaccSplitGetAccount (split));
+        gnc_numeric value = xaccSplitGetValue (split);
+        const char *name = gnc_numeric_negative_p (value) ? "From" : "To";
+
+        if (xaccSplitGetParent (split) != trans ||
+                g_strcmp0 (xaccAccountGetName (acc), name) != 0)
+            census->bad_accounts++;
+        if (!gnc_numeric_negative_p (value))
+            census->total = gnc_numeric_add (census->total, value,
+                                             100, GNC_HOW_RND_NEVER);
+    }
+    return 0;
+}
+
+static void
+take_census (Census *census, GncBookSnapshot *snapshot, Ledger *ledger)
+{
+    census->snapshot = snapshot;
+    census->ledger = ledger;
+    census->n_trans = 0;
+    census->bad_descriptions = 0;
+    census->bad_accounts = 0;
+    census->total = gnc_numeric_zero ();
+    census->saw_new = FALSE;
+    gnc_book_snapshot_foreach_transaction (snapshot, census_transaction,
+                                           census);
+}
+
+static void
+test_edits (void)
+{
+    Ledger ledger;
+    GncBookSnapshot *snapshot;
+    Census census;
+    GncGUID guid;
+
+    make_ledger (&ledger);
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    do_test (gnc_book_snapshot_get_book (snapshot) == ledger.book,
+             "snapshot of the book");
+    do_test (gnc_book_snapshot_count_transactions (snapshot) == N_TRANS,
+             "snapshot has every transaction");
+    do_test (gnc_book_snapshot_count_accounts (snapshot) == 3,
+             "snapshot has every account");
+
+    xaccTransBeginEdit (ledger.trans[0]);
+    xaccTransSetDescription (ledger.trans[0], "Changed");
+    xaccTransCommitEdit (ledger.trans[0]);
+    set_amount (ledger.trans[1], 500);
+    guid = *qof_instance_get_guid (ledger.trans[2]);
+    xaccTransDestroy (ledger.trans[2]);
+    make_transaction (&ledger, "New", 100);
+    xaccAccountBeginEdit (ledger.from);
+    xaccAccountSetName (ledger.from, "Renamed");
+    xaccAccountCommitEdit (ledger.from);
+
+    do_test (xaccTransLookup (&guid, ledger.book) == NULL,
+             "transaction destroyed in the book");
+    do_test (g_strcmp0 (xaccAccountGetName (ledger.from), "Renamed") == 0,
+             "account renamed in the book");
+
+    take_census (&census, snapshot, &ledger);
+    do_test (census.n_trans == N_TRANS,
+             "snapshot keeps deleted and hides new transactions");
+    do_test (!census.saw_new, "snapshot hides new transactions");
+    do_test (census.bad_descriptions == 0, "snapshot keeps old descriptions");
+    do_test (census.bad_accounts == 0, "snapshot keeps old account names");
+    do_test (gnc_numeric_equal (census.total,
+                                gnc_numeric_create (N_TRANS * 100, 100)),
+             "snapshot keeps old amounts");
+    gnc_book_snapshot_destroy (snapshot);
+
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    take_census (&census, snapshot, &ledger);
+    do_test (census.saw_new && census.n_trans == N_TRANS,
+             "new snapshot sees the edits");
+    gnc_book_snapshot_destroy (snapshot);
+
+    qof_book_destroy (ledger.book);
+}
+
+/* A snapshot taken in the middle of an edit shows the transaction as it
+ * was before the edit began. */
+static void
+test_open_edit (void)
+{
+    Ledger ledger;
+    GncBookSnapshot *snapshot;
+    Census census;
+
+    make_ledger (&ledger);
+    xaccTransBeginEdit (ledger.trans[0]);
+    xaccTransSetDescription (ledger.trans[0], "Changed");
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    xaccTransCommitEdit (ledger.trans[0]);
+
+    take_census (&census, snapshot, &ledger);
+    do_test (census.bad_descriptions == 0,
+             "snapshot taken during an edit shows the old transaction");
+    gnc_book_snapshot_destroy (snapshot);
+    qof_book_destroy (ledger.book);
+}
+
+/* An open account has no committed copy to show, so there's no
+ * snapshot until it is committed. */
+static void
+test_open_account (void)
+{
+    Ledger ledger;
+    GncBookSnapshot *snapshot;
+
+    make_ledger (&ledger);
+    xaccAccountBeginEdit (ledger.from);
+    xaccAccountSetName (ledger.from, "Changed");
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    do_test (snapshot == NULL, "no snapshot while an account is open");
+    xaccAccountCommitEdit (ledger.from);
+
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    do_test (snapshot != NULL, "snapshot once the account is committed");
+    gnc_book_snapshot_destroy (snapshot);
+    qof_book_destroy (ledger.book);
+}
+
+static gint
+list_transaction (Transaction *trans, gpointer data)
+{
+    GList **list = data;
+
+    *list = g_list_prepend (*list, trans);
+    return 0;
+}
+
+static gboolean
+same_order (GList *a, GList *b)
+{
+    for (; a && b; a = a->next, b = b->next)
+        if (a->data != b->data)
+            return FALSE;
+    return !a && !b;
+}
+
+/* The snapshot goes through the transactions as the account tree walk
+ * does, not in the order they were allocated, so two snapshots of the
+ * same book go through them in the same order. */
+static void
+test_order (void)
+{
+    Ledger ledger;
+    GncBookSnapshot *snapshot;
+    GList *walked = NULL, *first = NULL, *second = NULL;
+
+    make_ledger (&ledger);
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (ledger.book),
+                                       list_transaction, &walked);
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    gnc_book_snapshot_foreach_transaction (snapshot, list_transaction, &first);
+    gnc_book_snapshot_destroy (snapshot);
+    snapshot = gnc_book_snapshot_new (ledger.book);
+    gnc_book_snapshot_foreach_transaction (snapshot, list_transaction, &second);
+    gnc_book_snapshot_destroy (snapshot);
+
+    do_test (g_list_length (first) == N_TRANS, "snapshot has every transaction");
+    do_test (same_order (first, walked), "snapshot order is the account tree's");
+    do_test (same_order (first, second), "two snapshots give the same order");
+    g_list_free (first);
+    g_list_free (second);
+    g_list_free (walked);
+    qof_book_destroy (ledger.book);
+}
+
+static gpointer
+reader_thread (gpointer data)
+{
+    Census *census = data;
+    GncBookSnapshot *snapshot = census->snapshot;
+    gnc_numeric want = gnc_numeric_create (N_TRANS * 100, 100);
+    int round;
+
+    for (round = 0; round < N_ROUNDS; round++)
+    {
+        take_census (census, snapshot, census->ledger);
+        if (!gnc_numeric_equal (census->total, want) ||
+                census->n_trans != N_TRANS || census->bad_descriptions ||
+                census->bad_accounts)
+            census->bad_rounds++;
+        g_thread_yield ();
+    }
+    return NULL;
+}
+
+static void
+test_threads (void)
+{
+    Ledger ledger;
+    Census census;
+    GThread *thread;
+    int i;
+
+#ifndef HAVE_GLIB_2_32
+    if (!g_thread_supported ())
+    {
+        success ("no threads, nothing to test");
+        return;
+    }
+#endif
+    make_ledger (&ledger);
+    census.snapshot = gnc_book_snapshot_new (ledger.book);
+    census.ledger = &ledger;
+    census.bad_rounds = 0;
+#ifdef HAVE_GLIB_2_32
+    thread = g_thread_new ("book-snapshot", reader_thread, &census);
+#else
+    thread = g_thread_create (reader_thread, &census, TRUE, NULL);
+#endif
+    for (i = 0; i < N_TRANS; i++)
+    {
+        set_amount (ledger.trans[i], 100 + i);
+        if (i % 10 == 0)
+            xaccTransDestroy (ledger.trans[i]);
+        g_thread_yield ();
+    }
+    g_thread_join (thread);
+
+    do_test (census.bad_rounds == 0,
+             "snapshot read while another thread edits");
+    gnc_book_snapshot_destroy (census.snapshot);
+    qof_book_destroy (ledger.book);
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init ();
+    /* A snapshot freeing its copies twice only shows as a critical. */
+    g_log_set_always_fatal (G_LOG_FATAL_MASK | G_LOG_LEVEL_CRITICAL);
+    if (cashobjects_register ())
+    {
+        xaccLogDisable ();
+        test_edits ();
+        test_open_edit ();
+        test_open_account ();
+        test_order ();
+        test_threads ();
+        print_test_results ();
+    }
+    qof_close ();
+    return get_rv ();
+}
@@ -49,6 +49,23 @@ static void test_null_guid(void)
     do_test(!guid_equal(&g, gp), "two guids equal");
 }
 
+static void test_batch_guid(void)
+{
+    GncGUID guids[100];
+    GHashTable *seen = g_hash_table_new (guid_hash_to_guint,
+                                         guid_g_hash_table_equal);
+    int i;
+
+    guid_new_batch (guids, 100);
+    for (i = 0; i < 100; i++)
+    {
+        do_test (!guid_equal (&guids[i], guid_null ()), "batch guid is null");
+        do_test (!g_hash_table_lookup (seen, &guids[i]), "duplicate batch guid");
+        g_hash_table_insert (seen, &guids[i], &guids[i]);
+    }
+    g_hash_table_destroy (seen);
+}
+
 static void
 run_test (void)
 {
@@ -91,6 +108,7 @@ main (int argc, char **argv)
     if (cashobjects_register())
     {
         test_null_guid();
+        test_batch_guid();
         run_test ();
         print_test_results();
     }
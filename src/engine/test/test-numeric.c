@@ -30,6 +30,7 @@
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
 #include "gnc-numeric.h"
+#include "qofmath128-p.h"
 
 #define NREPS 2000
 
@@ -964,9 +965,168 @@ check_reciprocal(void)
 
 /* ======================================================= */
 
+static gboolean
+same128 (qofint128 a, qofint128 b)
+{
+    return a.hi == b.hi && a.lo == b.lo &&
+           a.isneg == b.isneg && a.isbig == b.isbig;
+}
+
+static void
+check_math128 (void)
+{
+    static const gint64 edges[] = { 0, 1, -1, 2, -2, 3037000499LL,
+                                    -3037000499LL, G_MAXINT64, -G_MAXINT64,
+                                    G_MININT64
+                                  };
+    guint i, j;
+
+    /* mult128 and div128 are done with a native 128-bit integer where
+     * there is one, and have to agree with the portable versions. */
+    for (i = 0; i < G_N_ELEMENTS (edges); i++)
+        for (j = 0; j < G_N_ELEMENTS (edges); j++)
+        {
+            qofint128 prod = mult128_portable (edges[i], edges[j]);
+            do_test (same128 (mult128 (edges[i], edges[j]), prod),
+                     "mult128 of edge values");
+            if (edges[j] != 0)
+                do_test (same128 (div128 (prod, edges[j]),
+                                  div128_portable (prod, edges[j])),
+                         "div128 of edge values");
+        }
+
+    for (i = 0; i < NREPS; i++)
+    {
+        gint64 a = get_random_gint64 () >> (rand () % 64);
+        gint64 b = get_random_gint64 () >> (rand () % 64);
+        gint64 d = get_random_gint64 () >> (rand () % 64);
+        qofint128 prod = mult128_portable (a, b);
+
+        do_test (same128 (mult128 (a, b), prod), "mult128");
+        if (d == 0) continue;
+        do_test (same128 (div128 (prod, d), div128_portable (prod, d)),
+                 "div128");
+    }
+}
+
+/* ======================================================= */
+
+static void
+check_same_denom (void)
+{
+    static const gint hows[] =
+    {
+        GNC_HOW_RND_FLOOR, GNC_HOW_RND_CEIL, GNC_HOW_RND_TRUNC,
+        GNC_HOW_RND_PROMOTE, GNC_HOW_RND_ROUND_HALF_DOWN,
+        GNC_HOW_RND_ROUND_HALF_UP, GNC_HOW_RND_ROUND, GNC_HOW_RND_NEVER
+    };
+    static const gint64 denoms[] = { 1, 3, 100, 1000, 1000000 };
+    gint i;
+
+    /* add, sub, mul and div take a short cut when both operands are in
+     * the wanted denominator.  Scaling one of them up takes the long
+     * way, which has to give the same answer. */
+    for (i = 0; i < NREPS; i++)
+    {
+        gint how = hows[i % G_N_ELEMENTS (hows)];
+        gint64 denom = denoms[rand () % G_N_ELEMENTS (denoms)];
+        gnc_numeric a = gnc_numeric_create (get_random_gint64 () % (1 << 30),
+                                            denom);
+        gnc_numeric b = gnc_numeric_create (get_random_gint64 () % (1 << 30),
+                                            denom);
+        gnc_numeric b2 = gnc_numeric_create (b.num * 2, denom * 2);
+
+        do_test (gnc_numeric_eq (gnc_numeric_add (a, b, denom, how),
+                                 gnc_numeric_add (a, b2, denom, how)),
+                 "add in one denominator");
+        do_test (gnc_numeric_eq (gnc_numeric_sub (a, b, denom, how),
+                                 gnc_numeric_sub (a, b2, denom, how)),
+                 "sub in one denominator");
+        do_test (gnc_numeric_eq (gnc_numeric_mul (a, b, denom, how),
+                                 gnc_numeric_mul (a, b2, denom, how)),
+                 "mul in one denominator");
+        if (b.num == 0) continue;
+        do_test (gnc_numeric_eq (gnc_numeric_div (a, b, denom, how),
+                                 gnc_numeric_div (a, b2, denom, how)),
+                 "div in one denominator");
+    }
+}
+
+/* ======================================================= */
+
+static gnc_numeric
+add_one_at_a_time (gnc_numeric start, const gnc_numeric *values, guint n,
+                   gint64 denom, gint how)
+{
+    guint i;
+    for (i = 0; i < n; i++)
+        start = gnc_numeric_add (start, values[i], denom, how);
+    return start;
+}
+
+static void
+check_sum (void)
+{
+    static const gint hows[] =
+    {
+        GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER,
+        GNC_HOW_DENOM_LCD,
+        GNC_HOW_DENOM_EXACT,
+        GNC_HOW_DENOM_REDUCE | GNC_HOW_RND_NEVER,
+    };
+    gnc_numeric values[300];
+    gnc_numeric sum, expected;
+    guint i, j, n;
+
+    for (i = 0; i < NREPS; i++)
+    {
+        gint how = hows[i % G_N_ELEMENTS (hows)];
+        gint64 denom = (i % 7) ? 100 : 1000;
+        gnc_numeric start = (i % 3) ? gnc_numeric_zero () :
+                            gnc_numeric_create (rand () % 10000, denom);
+
+        n = rand () % G_N_ELEMENTS (values);
+        for (j = 0; j < n; j++)
+        {
+            values[j] = gnc_numeric_create ((i % 5) ? rand () % 2000001 - 1000000 : 0,
+                                            denom);
+            /* An odd one out now and then */
+            if (i % 11 == 0 && j == n / 2)
+                values[j].denom = 10;
+        }
+
+        sum = gnc_numeric_sum (start, values, n, GNC_DENOM_AUTO, how);
+        expected = add_one_at_a_time (start, values, n, GNC_DENOM_AUTO, how);
+        do_test (gnc_numeric_eq (sum, expected), "sum same as adding one at a time");
+
+        sum = gnc_numeric_sum (start, values, n, denom, GNC_HOW_RND_ROUND_HALF_UP);
+        expected = add_one_at_a_time (start, values, n, denom,
+                                      GNC_HOW_RND_ROUND_HALF_UP);
+        do_test (gnc_numeric_eq (sum, expected), "sum to a denominator");
+    }
+
+    /* Going over the top on the way doesn't matter, ending there does */
+    values[0] = gnc_numeric_create (G_MAXINT64, 100);
+    values[1] = gnc_numeric_create (1, 100);
+    values[2] = gnc_numeric_create (-2, 100);
+    sum = gnc_numeric_sum_fixed (gnc_numeric_zero (), values, 3);
+    do_test (gnc_numeric_eq (sum, gnc_numeric_create (G_MAXINT64 - 1, 100)),
+             "sum overflowing on the way");
+    sum = gnc_numeric_sum_fixed (gnc_numeric_zero (), values, 2);
+    do_test (gnc_numeric_check (sum) == GNC_ERROR_OVERFLOW, "sum overflowing");
+
+    sum = gnc_numeric_sum_fixed (gnc_numeric_create (5, 100), values, 0);
+    do_test (gnc_numeric_eq (sum, gnc_numeric_create (5, 100)), "empty sum");
+}
+
+/* ======================================================= */
+
 static void
 run_test (void)
 {
+    check_math128 ();
+    check_same_denom ();
+    check_sum ();
     check_eq_operator ();
     check_reduce ();
     check_equality_operator ();
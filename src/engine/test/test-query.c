@@ -24,8 +24,10 @@
 #include "config.h"
 #include <glib.h>
 #include "qof.h"
+#include "qofquery-p.h"
 #include "cashobjects.h"
 #include "Transaction.h"
+#include "Query.h"
 #include "TransLog.h"
 #include "gnc-engine.h"
 #include "test-engine-stuff.h"
@@ -65,6 +67,283 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* The splits of an account within a date range are looked up through the
+ * account's split index; make sure that finds what a scan would. */
+static void
+test_account_query (Account *acc, gpointer data)
+{
+    QofBook *book = data;
+    GList *node, *list;
+    QofQuery *q;
+    Timespec start = {0, 0}, end = {0, 0};
+    guint expected = 0, i = 0;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next, i++)
+    {
+        Timespec posted =
+            xaccTransRetDatePostedTS (xaccSplitGetParent (node->data));
+        if (i == 0 || timespec_cmp (&posted, &start) < 0) start = posted;
+        if (i == 0 || timespec_cmp (&posted, &end) > 0) end = posted;
+    }
+    /* Cut the range to somewhere in the middle. */
+    start.tv_sec += (end.tv_sec - start.tv_sec) / 4;
+    end.tv_sec -= (end.tv_sec - start.tv_sec) / 4;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
+    {
+        Timespec posted =
+            xaccTransRetDatePostedTS (xaccSplitGetParent (node->data));
+        if (timespec_cmp (&posted, &start) >= 0 &&
+                timespec_cmp (&posted, &end) <= 0)
+            expected++;
+    }
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTS (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+
+    list = qof_query_run (q);
+    if (g_list_length (list) != expected)
+    {
+        failure_args ("account query", __FILE__, __LINE__,
+                      "number of matching splits %d not %d",
+                      g_list_length (list), expected);
+        qof_query_destroy (q);
+        return;
+    }
+    for (node = list; node; node = node->next)
+    {
+        if (xaccSplitGetAccount (node->data) != acc)
+        {
+            failure ("split from the wrong account");
+            qof_query_destroy (q);
+            return;
+        }
+    }
+    success ("found the account's splits");
+    qof_query_destroy (q);
+}
+
+/* Asking for only the last few of the sorted splits must give the same
+ * splits, in the same order, as cutting down the whole sorted list. */
+static void
+test_max_results (QofBook *book)
+{
+    QofQuery *q;
+    GList *all, *top, *node, *tail;
+    gint n;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    qof_query_set_sort_order (q, g_slist_prepend (NULL, QUERY_DEFAULT_SORT),
+                              NULL, NULL);
+    all = g_list_copy (qof_query_run (q));
+
+    for (n = 0; n <= 3; n++)
+    {
+        qof_query_set_max_results (q, n);
+        top = qof_query_run (q);
+        tail = g_list_nth (all, MAX ((gint) g_list_length (all) - n, 0));
+        if (g_list_length (top) != MIN (n, (gint) g_list_length (all)))
+        {
+            failure_args ("max results", __FILE__, __LINE__,
+                          "got %d splits, not %d", g_list_length (top), n);
+            break;
+        }
+        for (node = top; node; node = node->next, tail = tail->next)
+        {
+            if (node->data != tail->data)
+                break;
+        }
+        if (node)
+        {
+            failure ("wrong splits for max results");
+            break;
+        }
+        success ("found the last sorted splits");
+    }
+
+    g_list_free (all);
+    qof_query_destroy (q);
+}
+
+/* Compare a live query against running a copy of its query. */
+static gboolean
+live_query_ok (QofQueryLive *live, QofQuery *q)
+{
+    QofQuery *copy = qof_query_copy (q);
+    GList *expected, *got, *node;
+    gboolean ok;
+
+    got = g_list_copy (qof_query_live_run (live, NULL, NULL));
+    expected = qof_query_run (copy);
+    ok = g_list_length (got) == g_list_length (expected);
+    for (node = expected; ok && node; node = node->next)
+        ok = g_list_find (got, node->data) != NULL;
+
+    g_list_free (got);
+    qof_query_destroy (copy);
+    return ok;
+}
+
+/* A live query has to follow the edits of the splits it looks at, as
+ * well as of the transactions that hold them. */
+static void
+test_live_query (Account *acc, gpointer data)
+{
+    QofBook *book = data;
+    QofQueryLive *live;
+    QofQuery *q;
+    GList *added, *removed;
+    Split *split;
+    Transaction *trans;
+    Timespec posted, later;
+
+    split = xaccAccountGetSplitList (acc) ?
+            xaccAccountGetSplitList (acc)->data : NULL;
+    if (!split) return;
+    trans = xaccSplitGetParent (split);
+    posted = xaccTransRetDatePostedTS (trans);
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTS (q, FALSE, posted, TRUE, posted, QOF_QUERY_AND);
+    live = qof_query_live_new (q);
+
+    if (!live_query_ok (live, q))
+    {
+        failure ("live query differs at the start");
+        goto done;
+    }
+
+    /* Moving the transaction out of the range drops the split. */
+    later = posted;
+    later.tv_sec += 24 * 3600;
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedTS (trans, &later);
+    xaccTransCommitEdit (trans);
+
+    qof_query_live_run (live, &added, &removed);
+    if (added || !g_list_find (removed, split) || !live_query_ok (live, q))
+        failure ("live query missed the date change");
+    else
+        success ("live query follows the transaction");
+    g_list_free (added);
+    g_list_free (removed);
+
+    /* And moving it back brings it back. */
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedTS (trans, &posted);
+    xaccTransCommitEdit (trans);
+
+    qof_query_live_run (live, &added, &removed);
+    if (removed || !g_list_find (added, split) || !live_query_ok (live, q))
+        failure ("live query missed the date change back");
+    else
+        success ("live query follows the transaction back");
+    g_list_free (added);
+    g_list_free (removed);
+
+done:
+    qof_query_live_destroy (live);
+    qof_query_destroy (q);
+}
+
+/* A live query sorted on the transactions' dates has to resort when
+ * a date changes, though the splits that match stay the same. */
+static void
+test_live_sort (Account *acc, gpointer data)
+{
+    QofBook *book = data;
+    QofQueryLive *live;
+    QofQuery *q;
+    GList *results, *added, *removed;
+    Transaction *trans;
+    Timespec posted, later;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    qof_query_set_sort_order (q, qof_query_build_param_list (SPLIT_TRANS,
+                              TRANS_DATE_POSTED, NULL), NULL, NULL);
+    live = qof_query_live_new (q);
+
+    results = qof_query_live_run (live, NULL, NULL);
+    if (g_list_length (results) < 2)
+        goto done;
+
+    /* Move the first split's transaction after all the others. */
+    trans = xaccSplitGetParent (results->data);
+    posted = xaccTransRetDatePostedTS (trans);
+    later = xaccTransRetDatePostedTS (xaccSplitGetParent
+                                      (g_list_last (results)->data));
+    later.tv_sec += 24 * 3600;
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedTS (trans, &later);
+    xaccTransCommitEdit (trans);
+
+    results = qof_query_live_run (live, &added, &removed);
+    if (added || removed ||
+            xaccSplitGetParent (g_list_last (results)->data) != trans)
+        failure ("live query missed the new order");
+    else
+        success ("live query resorts on a date change");
+    g_list_free (added);
+    g_list_free (removed);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedTS (trans, &posted);
+    xaccTransCommitEdit (trans);
+
+done:
+    qof_query_live_destroy (live);
+    qof_query_destroy (q);
+}
+
+/* Checking the splits on several threads must give the same splits in
+ * the same order as checking them on one. */
+static void
+test_parallel_query (QofBook *book)
+{
+    QofQuery *q;
+    GList *serial, *parallel, *a, *b;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddClearedMatch (q, CLEARED_NO | CLEARED_CLEARED, QOF_QUERY_AND);
+    serial = g_list_copy (qof_query_run (q));
+
+    qof_query_set_parallel_threshold (0);
+    qof_query_set_parallel (q, TRUE);
+    parallel = qof_query_run (q);
+
+    for (a = serial, b = parallel; a && b; a = a->next, b = b->next)
+        if (a->data != b->data) break;
+    if (a || b)
+        failure ("parallel query differs");
+    else
+        success ("parallel query matches");
+
+    /* The workers can't take the read lock while this thread writes,
+     * so the query has to check the splits itself. */
+    qof_book_write_lock (book);
+    parallel = qof_query_run (q);
+    qof_book_write_unlock (book);
+    qof_query_set_parallel_threshold (10000);
+
+    for (a = serial, b = parallel; a && b; a = a->next, b = b->next)
+        if (a->data != b->data) break;
+    if (a || b)
+        failure ("query while writing differs");
+    else
+        success ("query while writing matches");
+
+    g_list_free (serial);
+    qof_query_destroy (q);
+}
+
 static void
 run_test (void)
 {
@@ -79,6 +358,12 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    gnc_account_foreach_descendant (root, test_account_query,
+                                    book);
+    test_max_results (book);
+    test_parallel_query (book);
+    gnc_account_foreach_descendant (root, test_live_query, book);
+    gnc_account_foreach_descendant (root, test_live_sort, book);
 
     qof_session_end (session);
 }
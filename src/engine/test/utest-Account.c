@@ -29,6 +29,7 @@
 #include "../Account.h"
 #include "../AccountP.h"
 #include "../Split.h"
+#include "../SplitP.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
 
@@ -887,7 +888,7 @@ test_xaccFreeAccount (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (p_priv->n_splits > 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1.hits, ==, 0);
@@ -1002,7 +1003,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (p_priv->n_splits > 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1.hits, ==, 0);
@@ -1018,7 +1019,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     test_signal_assert_hits (sig2, 0);
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (p_priv->n_splits > 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1.hits, ==, 0);
@@ -1108,19 +1109,19 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that the call fails with invalid account and split (throws) */
     g_assert (!gnc_account_insert_split (NULL, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->n_splits, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     g_assert (!gnc_account_insert_split (fixture->acct, NULL));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->n_splits, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     /* g_assert (!gnc_account_insert_split (fixture->acct, (Split*)priv)); */
-    /* g_assert_cmpuint (g_list_length (priv->splits), == , 0); */
+    /* g_assert_cmpuint (priv->n_splits, == , 0); */
     /* g_assert (!priv->sort_dirty); */
     /* g_assert (!priv->balance_dirty); */
     /* test_signal_assert_hits (sig1, 0); */
@@ -1133,7 +1134,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that it works the first time */
     g_assert (gnc_account_insert_split (fixture->acct, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 1);
+    g_assert_cmpuint (priv->n_splits, == , 1);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 1);
@@ -1145,7 +1146,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split2);
     /* Now add a second split to the account and check that sort_dirty isn't set. We have to bump the editlevel to force this. */
     g_assert (gnc_account_insert_split (fixture->acct, split2));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->n_splits, == , 2);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 2);
@@ -1156,7 +1157,8 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     qof_instance_increase_editlevel (fixture->acct);
     g_assert (gnc_account_insert_split (fixture->acct, split3));
     qof_instance_decrease_editlevel (fixture->acct);
-    g_assert_cmpuint (g_list_length (priv->splits), == , 3);
+    g_assert_cmpuint (priv->n_splits, == , 3);
+    g_assert_cmpuint (g_list_length (priv->split_list), == , 3);
     g_assert (priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 3);
@@ -1167,7 +1169,9 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_REMOVED,
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->n_splits, == , 2);
+    g_assert (g_list_find (priv->split_list, split3) == NULL);
+    g_assert (split3->acc_chunk == NULL);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1175,7 +1179,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     /* And do it again to make sure that it fails when the split has
      * already been removed */
     g_assert (!gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->n_splits, == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1185,6 +1189,85 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     test_signal_free (sig3);
     test_signal_free (sig1);
 }
+/* gnc_account_bulk_load_end
+static void
+gnc_account_bulk_load_end (QofBook *book)
+
+Also tests gnc_account_insert_split () during a bulk load.
+*/
+static void
+test_gnc_account_bulk_load (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    Transaction *txn = xaccMallocTransaction (book);
+    Split *split = xaccMallocSplit (book);
+    gnc_numeric amount = gnc_numeric_create (1234, 100);
+    gnc_numeric bal;
+    TestSignal sig1, sig2;
+    guint len;
+
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    xaccAccountRecomputeBalance (fixture->acct);
+    bal = priv->balance;
+    len = priv->n_splits;
+    sig1 = test_signal_new (&fixture->acct->inst, QOF_EVENT_MODIFY, NULL);
+    sig2 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split);
+
+    qof_book_begin_bulk_load (book);
+    qof_book_begin_bulk_load (book);
+    g_assert (qof_book_is_bulk_loading (book));
+
+    /* The oldest split of all goes on the end, unsorted and unbalanced,
+     * and nobody hears about it. */
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, 0);
+    xaccSplitSetParent (split, txn);
+    g_object_set (split,
+                  "account", fixture->acct,
+                  "amount", &amount,
+                  "value", &amount,
+                  NULL);
+    g_assert (gnc_account_insert_split (fixture->acct, split));
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert_cmpuint (priv->n_splits, == , len + 1);
+    g_assert (xaccAccountGetSplitAt (fixture->acct, len) == split);
+    g_assert (priv->sort_dirty);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (xaccAccountGetSplitAt (fixture->acct, len) == split);
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    test_signal_assert_hits (sig1, 0);
+    test_signal_assert_hits (sig2, 0);
+
+    /* Only the outermost end does the work. */
+    qof_book_end_bulk_load (book);
+    g_assert (qof_book_is_bulk_loading (book));
+    g_assert (priv->sort_dirty);
+
+    /* A forced sort brings the one account up to date at once. */
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    g_assert (!priv->sort_dirty);
+    g_assert (!priv->balance_dirty);
+    g_assert (xaccAccountGetSplitAt (fixture->acct, 0) == split);
+    g_assert (gnc_numeric_eq (priv->balance,
+                              gnc_numeric_add_fixed (bal, amount)));
+    test_signal_assert_hits (sig1, 0);
+    qof_book_end_bulk_load (book);
+    g_assert (!qof_book_is_bulk_loading (book));
+    g_assert (!priv->sort_dirty);
+    g_assert (!priv->balance_dirty);
+    g_assert (xaccAccountGetSplitAt (fixture->acct, 0) == split);
+    g_assert (g_list_first (priv->split_list)->data == split);
+    g_assert (gnc_numeric_eq (xaccSplitGetBalance (split), amount));
+    g_assert (gnc_numeric_eq (priv->balance,
+                              gnc_numeric_add_fixed (bal, amount)));
+    test_signal_assert_hits (sig1, 1);
+    test_signal_assert_hits (sig2, 0);
+
+    test_signal_free (sig2);
+    test_signal_free (sig1);
+}
 /* xaccAccountSortSplits
 void
 xaccAccountSortSplits (Account *acc, gboolean force)// C: 4 in 2
@@ -1340,6 +1423,44 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
 }
 
+/* gnc_account_set_split_balance_dirty
+void
+gnc_account_set_split_balance_dirty (Account *acc, const Split *split)*/
+static void
+test_gnc_account_set_split_balance_dirty (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    gnc_numeric bal, sentinel = gnc_numeric_create (42, 1);
+    Split *first, *last;
+    guint len;
+
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (!priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, == , G_MAXUINT);
+    len = priv->n_splits;
+    g_assert_cmpuint (len, > , 1);
+    first = xaccAccountGetSplitAt (fixture->acct, 0);
+    last = xaccAccountGetSplitAt (fixture->acct, len - 1);
+    bal = priv->balance;
+    /* Only the running balances from the dirty split onwards get
+     * recomputed, so the poisoned first one survives. */
+    first->balance = sentinel;
+    gnc_account_set_split_balance_dirty (fixture->acct, last);
+    g_assert (priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, == , len - 1);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (gnc_numeric_eq (xaccSplitGetBalance (first), sentinel));
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    g_assert (gnc_numeric_eq (xaccSplitGetBalance (last), bal));
+    /* Marking the whole account dirty recomputes everything. */
+    gnc_account_set_balance_dirty (fixture->acct);
+    g_assert_cmpuint (priv->balance_dirty_from, == , 0);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (!gnc_numeric_eq (xaccSplitGetBalance (first), sentinel));
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -1934,6 +2055,50 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* xaccAccountGetClearedBalanceAsOfDate
+gnc_numeric
+xaccAccountGetClearedBalanceAsOfDate (Account *acc, time64 date)
+xaccAccountGetReconciledBalanceAsOfDate
+gnc_numeric
+xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)*/
+static void
+test_xaccAccountGetXxxBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
+{
+    gnc_numeric cleared = gnc_numeric_zero (), reconciled = gnc_numeric_zero ();
+    SetupData *sdata = (SetupData*)pData;
+    TxnParms* t_arr;
+    int ind;
+    gint min_ind = 3;
+    gint offset = 24 * 3600 * 10; /* 10 days in seconds */
+    time64 asof = gnc_time (NULL);
+    g_assert (sdata != NULL);
+    t_arr = (TxnParms*)sdata->txns;
+    for (ind = 0; ind < min_ind; ind++)
+    {
+        SplitParms p = t_arr[ind].splits[1];
+        if (p.reconciled != NREC)
+            cleared = gnc_numeric_add_fixed (cleared, p.amount);
+        if (p.reconciled == YREC || p.reconciled == FREC)
+            reconciled = gnc_numeric_add_fixed (reconciled, p.amount);
+    }
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (gnc_numeric_equal (cleared,
+                                 xaccAccountGetClearedBalanceAsOfDate (fixture->acct, asof)));
+    g_assert (gnc_numeric_equal (reconciled,
+                                 xaccAccountGetReconciledBalanceAsOfDate (fixture->acct, asof)));
+    /* Before the first split everything is zero */
+    g_assert (gnc_numeric_zero_p (xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                  asof - offset)));
+    g_assert (gnc_numeric_zero_p (xaccAccountGetClearedBalanceAsOfDate (fixture->acct,
+                                  asof - offset)));
+    /* After the last split the as-of balances are the account balances */
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acct),
+                                 xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                         asof + offset)));
+    g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (fixture->acct),
+                                 xaccAccountGetReconciledBalanceAsOfDate (fixture->acct,
+                                         asof + offset)));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -1985,11 +2150,165 @@ test_xaccAccountGetPresentBalance (Fixture *fixture, gconstpointer pData)
  * xaccAccountGetBalanceAsOfDateInCurrency
  * xaccAccountGetBalanceChangeForPeriod
  */
+/* The recursion does use the subtree balances, though, which have to be
+ * thrown away at the right times. */
+static void
+set_commodity (Account *acct, gpointer data)
+{
+    xaccAccountSetCommodity (acct, data);
+    xaccAccountRecomputeBalance (acct);
+}
+
+static void
+sum_balances (Account *acct, gpointer data)
+{
+    gnc_numeric *sum = data;
+    *sum = gnc_numeric_add (*sum, xaccAccountGetBalance (acct),
+                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+}
+
+static void
+test_xaccAccountGetBalanceInCurrency_subtree (Fixture *fixture,
+        gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Account *root = gnc_account_get_root (fixture->acct);
+    Account *leaf = gnc_account_lookup_by_name (root, "qdiv");
+    Account *parent = gnc_account_get_parent (leaf);
+    AccountPrivate *rpriv = fixture->func->get_private (root);
+    AccountPrivate *lpriv = fixture->func->get_private (leaf);
+    gnc_commodity *commodity = gnc_commodity_new (book, "US Dollar",
+                               "CURRENCY", "USD", "0", 100);
+    gnc_numeric total = gnc_numeric_zero (), leaf_bal;
+    gnc_numeric ten = gnc_numeric_create (1000, 100);
+
+    set_commodity (root, commodity);
+    gnc_account_foreach_descendant (root, set_commodity, commodity);
+    sum_balances (root, &total);
+    gnc_account_foreach_descendant (root, sum_balances, &total);
+
+    g_assert (gnc_numeric_eq (xaccAccountGetBalanceInCurrency (root, NULL, TRUE),
+                              total));
+    g_assert (!rpriv->subtree_dirty);
+    g_assert (!lpriv->subtree_dirty);
+
+    /* A change to the leaf's balance dirties the way up to the root. */
+    leaf_bal = xaccAccountGetBalance (leaf);
+    gnc_account_set_start_balance (leaf, ten);
+    xaccAccountRecomputeBalance (leaf);
+    g_assert (lpriv->subtree_dirty);
+    g_assert (rpriv->subtree_dirty);
+    total = gnc_numeric_add (total, ten, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    g_assert (gnc_numeric_eq (xaccAccountGetBalanceInCurrency (root, NULL, TRUE),
+                              total));
+    g_assert (gnc_numeric_eq (xaccAccountGetBalanceInCurrency (parent, NULL, FALSE),
+                              xaccAccountGetBalance (parent)));
+
+    /* So does moving it out of the tree and back in. */
+    gnc_account_remove_child (parent, leaf);
+    g_assert (rpriv->subtree_dirty);
+    g_assert (gnc_numeric_eq (xaccAccountGetBalanceInCurrency (root, NULL, TRUE),
+                              gnc_numeric_sub (total,
+                                      gnc_numeric_add (leaf_bal, ten,
+                                              GNC_DENOM_AUTO,
+                                              GNC_HOW_DENOM_LCD),
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD)));
+    gnc_account_append_child (parent, leaf);
+    g_assert (rpriv->subtree_dirty);
+    g_assert (gnc_numeric_eq (xaccAccountGetBalanceInCurrency (root, NULL, TRUE),
+                              total));
+}
 /*
  * Yet more getters & setters:
  * xaccAccountGetSplitList
  * xaccAccountGetLotList
  */
+/* xaccAccountGetSplitsSize
+guint
+xaccAccountGetSplitsSize (const Account *acc)
+xaccAccountGetSplitAt
+Split*
+xaccAccountGetSplitAt (const Account *acc, guint n)*/
+static void
+test_xaccAccountGetSplitAt (Fixture *fixture, gconstpointer pData)
+{
+    SplitList *list = xaccAccountGetSplitList (fixture->acct);
+    guint n, size = xaccAccountGetSplitsSize (fixture->acct);
+
+    g_assert_cmpuint (size, == , 5);
+    g_assert_cmpuint (g_list_length (list), == , size);
+    for (n = 0; n < size; n++, list = g_list_next (list))
+        g_assert (xaccAccountGetSplitAt (fixture->acct, n) == list->data);
+    g_assert (xaccAccountGetSplitAt (fixture->acct, size) == NULL);
+}
+
+static void
+check_split_chunks (Account *acct, AccountPrivate *priv)
+{
+    GList *node = priv->split_list;
+    guint n, i, pos = 0;
+
+    for (n = 0; n < priv->split_chunks->len; n++)
+    {
+        SplitChunk *chunk = g_ptr_array_index (priv->split_chunks, n);
+        g_assert (chunk->owner == priv);
+        g_assert_cmpuint (chunk->index, == , n);
+        g_assert_cmpuint (chunk->len, >, 0);
+        g_assert_cmpuint (chunk->len, <=, SPLIT_CHUNK_SIZE);
+        for (i = 0; i < chunk->len; i++, pos++, node = node->next)
+        {
+            Split *split = node->data;
+            g_assert (chunk->nodes[i] == node);
+            g_assert (split->acc_chunk == chunk);
+            g_assert (xaccAccountGetSplitAt (acct, pos) == split);
+            if (node->next)
+                g_assert_cmpint (xaccSplitOrder (split, node->next->data),
+                                 <, 0);
+        }
+    }
+    g_assert (node == NULL);
+    g_assert_cmpuint (pos, == , priv->n_splits);
+    g_assert_cmpuint (xaccAccountGetSplitsSize (acct), == , pos);
+}
+
+/* Insert enough splits in a scrambled order to fill several chunks,
+ * then take most of them out again. */
+static void
+test_gnc_account_split_chunks (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    const guint count = 8 * SPLIT_CHUNK_SIZE + 3;
+    Split **splits = g_new (Split*, count);
+    guint n, chunks;
+
+    for (n = 0; n < count; n++)
+    {
+        /* 7919 is prime, so this visits every memo once */
+        gchar *memo = g_strdup_printf ("%05u", (n * 7919) % count);
+        splits[n] = xaccMallocSplit (book);
+        xaccSplitSetMemo (splits[n], memo);
+        g_free (memo);
+        g_assert (gnc_account_insert_split (fixture->acct, splits[n]));
+    }
+    g_assert_cmpuint (priv->n_splits, == , count);
+    g_assert (!priv->sort_dirty);
+    chunks = priv->split_chunks->len;
+    g_assert_cmpuint (chunks, >, count / SPLIT_CHUNK_SIZE);
+    g_assert_cmpuint (chunks, <=, 2 * count / SPLIT_CHUNK_SIZE + 1);
+    check_split_chunks (fixture->acct, priv);
+
+    for (n = 0; n < count; n++)
+        if (n % 8)
+        {
+            g_assert (gnc_account_remove_split (fixture->acct, splits[n]));
+            g_assert (splits[n]->acc_chunk == NULL);
+        }
+    g_assert_cmpuint (priv->n_splits, == , (count + 7) / 8);
+    g_assert_cmpuint (priv->split_chunks->len, <, chunks);
+    check_split_chunks (fixture->acct, priv);
+    g_free (splits);
+}
 /* xaccAccountFindOpenLots
 LotList *
 xaccAccountFindOpenLots (const Account *acc,// C: 24 in 13 */
@@ -2518,8 +2837,11 @@ test_suite_account (void)
 // GNC_TEST_ADD (suitename, "xaccAcctChildrenEqual", Fixture, NULL, setup, test_xaccAcctChildrenEqual,  teardown );
 // GNC_TEST_ADD (suitename, "xaccAccountEqual", Fixture, NULL, setup, test_xaccAccountEqual,  teardown );
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account bulk load", Fixture, &some_data, setup, test_gnc_account_bulk_load,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceInCurrency subtree", Fixture, &complex_data, setup, test_xaccAccountGetBalanceInCurrency_subtree,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account set split balance dirty", Fixture, &some_data, setup, test_gnc_account_set_split_balance_dirty,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2538,7 +2860,10 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetXxxBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetXxxBalanceAsOfDate,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetSplitAt", Fixture, &some_data, setup, test_xaccAccountGetSplitAt,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account split chunks", Fixture, NULL, setup, test_gnc_account_split_chunks,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
 
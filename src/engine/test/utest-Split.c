@@ -138,7 +138,8 @@ test_gnc_split_init ()
     g_assert_cmpint (split->gains, ==, GAINS_STATUS_UNKNOWN);
     g_assert (split->gains_split == NULL);
     /* Make sure that the parent's init has been run */
-    g_assert (split->inst.kvp_data != NULL);
+    g_assert (qof_instance_get_infant (QOF_INSTANCE (split)));
+    g_assert (split->inst.kvp_data == NULL);
 
     g_object_unref (split);
 }
@@ -730,7 +731,7 @@ test_xaccSplitDetermineGainStatus (Fixture *fixture, gconstpointer pData)
     g_assert (fixture->split->gains_split == NULL);
     g_assert_cmpint (fixture->split->gains, ==, GAINS_STATUS_A_VDIRTY | GAINS_STATUS_DATE_DIRTY);
 
-    kvp_frame_set_guid (fixture->split->inst.kvp_data, "gains-source", g_guid);
+    kvp_frame_set_guid (xaccSplitGetSlots (fixture->split), "gains-source", g_guid);
     g_assert (fixture->split->gains_split == NULL);
     fixture->split->gains = GAINS_STATUS_UNKNOWN;
     xaccSplitDetermineGainStatus (fixture->split);
@@ -1212,6 +1213,50 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     test_destroy (o_split);
     test_destroy (o_txn);
 }
+/* The sort keys behind xaccSplitOrder must follow the split's and
+ * the transaction's strings as they are replaced.
+ */
+static void
+test_xaccSplitOrder_sort_keys (Fixture *fixture, gconstpointer pData)
+{
+    Split *split = fixture->split;
+    Split *o_split = xaccMallocSplit (xaccSplitGetBook (split));
+    Transaction *o_txn = xaccMallocTransaction (xaccSplitGetBook (split));
+    Transaction *txn = split->parent;
+
+    o_split->parent = o_txn;
+    txn->date_posted = timespec_now ();
+    o_txn->date_posted = txn->date_posted;
+    o_txn->date_entered = txn->date_entered;
+    CACHE_REPLACE (txn->num, "12");
+    CACHE_REPLACE (o_txn->num, "12");
+    CACHE_REPLACE (txn->description, "Alpha");
+    CACHE_REPLACE (o_txn->description, "Beta");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+    g_assert_cmpint (xaccTransOrder (txn, o_txn), <, 0);
+
+    CACHE_REPLACE (txn->description, "Gamma");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), >, 0);
+    g_assert_cmpint (xaccTransOrder (txn, o_txn), >, 0);
+    CACHE_REPLACE (txn->num, "9");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+
+    /* Splits of the same transaction sort on memo, then action */
+    o_split->parent = txn;
+    CACHE_REPLACE (split->memo, "one");
+    CACHE_REPLACE (o_split->memo, "two");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+    CACHE_REPLACE (split->memo, "zero");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), >, 0);
+    CACHE_REPLACE (o_split->memo, "zero");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), >, 0);
+    CACHE_REPLACE (o_split->action, "goo");
+    g_assert_cmpint (xaccSplitOrder (split, o_split), <, 0);
+
+    o_split->parent = NULL;
+    test_destroy (o_split);
+    test_destroy (o_txn);
+}
 /* xaccSplitOrderDateOnly
 gint
 xaccSplitOrderDateOnly (const Split *sa, const Split *sb)// C: 2 in 1
@@ -1434,6 +1479,11 @@ test_xaccSplitCompareAccountFullNames (Fixture *fixture, gconstpointer pData)
     g_assert_cmpint (xaccSplitCompareAccountFullNames (split, NULL), ==, 1);
     g_assert_cmpint (xaccSplitCompareAccountFullNames (NULL, split), ==, -1);
     g_assert_cmpint (xaccSplitCompareAccountFullNames (split, split1), <, 0);
+    /* The accounts keep their names for sorting; renaming must show. */
+    xaccAccountSetName (fixture->split->acc, "zebra");
+    g_assert_cmpint (xaccSplitCompareAccountFullNames (split, split1), >, 0);
+    xaccAccountSetName (acc2, "zulu");
+    g_assert_cmpint (xaccSplitCompareAccountFullNames (split, split1), <, 0);
 
     xaccTransBeginEdit (txn);
     xaccSplitSetParent (split1, txn);
@@ -1779,17 +1829,17 @@ test_xaccSplitGetOtherSplit (Fixture *fixture, gconstpointer pData)
     xaccSplitSetParent (split2, txn);
     g_assert (xaccSplitGetOtherSplit (split) == NULL);
 
-    kvp_frame_set_slot (split->inst.kvp_data, "lot-split", kvptrue);
+    kvp_frame_set_slot (xaccSplitGetSlots (split), "lot-split", kvptrue);
     g_assert (kvp_frame_get_slot (split->inst.kvp_data, "lot-split"));
     g_assert (xaccSplitGetOtherSplit (split) == NULL);
 
-    kvp_frame_set_slot (split1->inst.kvp_data, "lot-split", kvptrue);
+    kvp_frame_set_slot (xaccSplitGetSlots (split1), "lot-split", kvptrue);
     g_assert (kvp_frame_get_slot (split1->inst.kvp_data, "lot-split"));
     g_assert (xaccSplitGetOtherSplit (split) == split2);
 
-    kvp_frame_set_slot (split->inst.kvp_data, "lot-split", NULL);
+    kvp_frame_set_slot (xaccSplitGetSlots (split), "lot-split", NULL);
     g_assert (kvp_frame_get_slot (split->inst.kvp_data, "lot-split") == NULL);
-    kvp_frame_set_slot (split1->inst.kvp_data, "lot-split", NULL);
+    kvp_frame_set_slot (xaccSplitGetSlots (split1), "lot-split", NULL);
     g_assert (kvp_frame_get_slot (split1->inst.kvp_data, "lot-split") == NULL);
     kvp_frame_set_slot_path (book_slots, kvptrue, KVP_OPTION_PATH,
                              OPTION_SECTION_ACCOUNTS,
@@ -1890,6 +1940,7 @@ test_suite_split (void)
     GNC_TEST_ADD_FUNC (suitename, "xaccSplitConvertAmount", test_xaccSplitConvertAmount);
     GNC_TEST_ADD_FUNC (suitename, "xaccSplitDestroy", test_xaccSplitDestroy);
     GNC_TEST_ADD (suitename, "xaccSplitOrder", Fixture, NULL, setup, test_xaccSplitOrder, teardown);
+    GNC_TEST_ADD (suitename, "xaccSplitOrder sort keys", Fixture, NULL, setup, test_xaccSplitOrder_sort_keys, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitOrderDateOnly", Fixture, NULL, setup, test_xaccSplitOrderDateOnly, teardown);
     GNC_TEST_ADD (suitename, "get corr account split", Fixture, NULL, setup, test_get_corr_account_split, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitGetCorrAccountFullName", Fixture, NULL, setup, test_xaccSplitGetCorrAccountFullName, teardown);
@@ -584,7 +584,7 @@ test_xaccDupeTransaction (Fixture *fixture, gconstpointer pData)
 
     old->date_posted = posted;
     old->date_entered = entered;
-    kvp_frame_set_string (old->inst.kvp_data, "/foo/bar/baz",
+    kvp_frame_set_string (xaccTransGetSlots (old), "/foo/bar/baz",
                           "The Great Waldo Pepper");
 
     new = xaccDupeTransaction (old);
@@ -2022,11 +2022,57 @@ test_xaccTransScrubGainsDate_gains_dirty (GainsFixture *fixture,
  * program.
  */
 /* xaccTransFindSplitByAccount C: 7 in 5  Local: 0:0:0
- * destroy_tx_on_book_close Local: 0:1:0
- * gnc_transaction_book_end Local: 0:1:0
  * trans_is_balanced_p Local: 0:1:0
  * Trivial pass-through.
  */
+/* destroy_tx_on_book_close
+static void
+destroy_tx_on_book_close(QofInstance *ent, gpointer data)// Local: 0:1:0
+ * gnc_transaction_book_end
+static void
+gnc_transaction_book_end(QofBook* book)// Local: 0:1:0
+*/
+static void
+test_gnc_transaction_book_end ()
+{
+    QofBook *book = qof_book_new ();
+    Account *acc = xaccMallocAccount (book);
+    GNCLot *lot = gnc_lot_new (book);
+    Transaction *txn = xaccMallocTransaction (book);
+    Split *split1 = xaccMallocSplit (book);
+    Split *split2 = xaccMallocSplit (book);
+    gnc_commodity *curr = gnc_commodity_new (book, "Gnu Rand", "CURRENCY",
+                                             "GNR", "", 240);
+    TestSignal sig_txn, sig_split;
+
+    xaccAccountSetCommodity (acc, curr);
+    gnc_account_append_child (gnc_book_get_root_account (book), acc);
+    xaccTransBeginEdit (txn);
+    xaccTransSetCurrency (txn, curr);
+    xaccSplitSetParent (split1, txn);
+    xaccSplitSetParent (split2, txn);
+    xaccSplitSetAccount (split1, acc);
+    xaccSplitSetAccount (split2, acc);
+    xaccTransCommitEdit (txn);
+    xaccAccountInsertLot (acc, lot);
+    gnc_lot_add_split (lot, split1);
+
+    g_object_add_weak_pointer (G_OBJECT (txn), (gpointer)&txn);
+    g_object_add_weak_pointer (G_OBJECT (split1), (gpointer)&split1);
+    g_object_add_weak_pointer (G_OBJECT (split2), (gpointer)&split2);
+    sig_txn = test_signal_new (QOF_INSTANCE (txn), QOF_EVENT_DESTROY, NULL);
+    sig_split = test_signal_new (NULL, QOF_EVENT_REMOVE, NULL);
+
+    qof_book_destroy (book);
+    g_assert_cmpint (test_signal_return_hits (sig_txn), ==, 1);
+    g_assert_cmpint (test_signal_return_hits (sig_split), ==, 0);
+    g_assert (txn == NULL);
+    g_assert (split1 == NULL);
+    g_assert (split2 == NULL);
+
+    test_signal_free (sig_txn);
+    test_signal_free (sig_split);
+}
 
 
 void
@@ -2078,5 +2124,6 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_no_dirty, teardown_with_gains);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_base_dirty, teardown_with_gains);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_gains_dirty, teardown_with_gains);
+    GNC_TEST_ADD_FUNC (suitename, "gnc transaction book end", test_gnc_transaction_book_end);
 
 }
@@ -684,6 +684,87 @@ gnc_tree_model_split_reg_load (GncTreeModelSplitReg *model, GList *slist, Accoun
 }
 
 
+/* Take in the splits that started or stopped matching the query
+ * without loading everything again */
+gboolean
+gnc_tree_model_split_reg_apply_query_changes (GncTreeModelSplitReg *model, GList *slist,
+                                              GList *added, GList *removed)
+{
+    GncTreeModelSplitRegPrivate *priv;
+    GList *tlist, *node, *next;
+
+    priv = model->priv;
+
+    if (!added && !removed)
+        return TRUE;
+
+    /* Only a model holding all its transactions can change in place, a
+     * window onto a longer list has to be loaded again. */
+    if (g_list_length (priv->full_tlist) >= NUM_OF_TRANS*3)
+        return FALSE;
+
+    ENTER("model %p, %d splits added and %d removed", model,
+          g_list_length (added), g_list_length (removed));
+
+    /* The removed splits may be gone, so look instead for the shown
+     * transactions that no longer have a split in the list. */
+    if (removed)
+    {
+        GHashTable *matching = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+        for (node = slist; node; node = node->next)
+            g_hash_table_insert (matching, node->data, node->data);
+
+        for (node = priv->tlist; node; node = next)
+        {
+            Transaction *trans = node->data;
+            GList *snode;
+
+            next = node->next;
+            if (trans == priv->btrans)
+                continue;
+
+            for (snode = xaccTransGetSplitList (trans); snode; snode = snode->next)
+            {
+                if (g_hash_table_lookup (matching, snode->data))
+                    break;
+            }
+            if (snode)
+                continue;
+
+            DEBUG("remove trans %p", trans);
+            g_signal_emit_by_name (model, "selection_move_delete", trans);
+            gtm_sr_delete_trans (model, trans);
+        }
+        g_hash_table_destroy (matching);
+    }
+
+    tlist = xaccSplitListGetUniqueTransactions (added);
+    for (node = tlist; node; node = node->next)
+    {
+        Transaction *trans = node->data;
+
+        if (trans == priv->btrans || g_list_find (priv->tlist, trans))
+            continue;
+
+        DEBUG("insert trans %p", trans);
+        gtm_sr_insert_trans (model, trans, model->sort_direction == GTK_SORT_ASCENDING);
+    }
+    g_list_free (tlist);
+
+    /* The whole list is shown, so the full list is the shown one; the
+     * event handler may already have taken out destroyed transactions. */
+    g_list_free (priv->full_tlist);
+    priv->full_tlist = g_list_copy (priv->tlist);
+    model->number_of_trans_in_full_tlist = g_list_length (priv->full_tlist);
+
+    g_signal_emit_by_name (model, "refresh_status_bar", NULL);
+
+    LEAVE(" ");
+    return TRUE;
+}
+
+
 void
 gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update)
 {
@@ -201,6 +201,12 @@ gnc_tree_model_split_reg_new (SplitRegisterType2 reg_type, SplitRegisterStyle2 s
 /** Load the model from a slist and set default account for register. */
 void gnc_tree_model_split_reg_load (GncTreeModelSplitReg *model, GList * slist, Account *default_account);
 
+/** Take the splits that started or stopped matching the query into
+ *  the model, slist being all the splits that match now.  Returns
+ *  FALSE if the model has to be loaded again instead. */
+gboolean gnc_tree_model_split_reg_apply_query_changes (GncTreeModelSplitReg *model, GList *slist,
+                                                       GList *added, GList *removed);
+
 /** Sets the template account. */
 void gnc_tree_model_split_reg_set_template_account (GncTreeModelSplitReg *model, Account *template_account);
 
@@ -2542,6 +2542,9 @@ gtv_sr_begin_edit (GncTreeViewSplitReg *view, Transaction *trans)
 
         if (!xaccTransIsOpen (trans))
             xaccTransBeginEdit (trans);
+        /* It stays open while the user edits it, so don't keep the
+         * other threads from reading the book meanwhile. */
+        qof_instance_release_edit_lock (QOF_INSTANCE (trans));
         view->priv->dirty_trans = trans;
 
         if (ts.tv_sec == 0)
@@ -6035,6 +6038,8 @@ gnc_tree_view_split_reg_set_dirty_trans (GncTreeViewSplitReg *view, Transaction
     {
         g_object_set_data (G_OBJECT (view), "data-edited", GINT_TO_POINTER (TRUE));
         view->priv->dirty_trans = trans;
+        if (xaccTransIsOpen (trans))
+            qof_instance_release_edit_lock (QOF_INSTANCE (trans));
     }
 }
 
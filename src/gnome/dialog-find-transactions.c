@@ -53,6 +53,11 @@ do_find_cb (QofQuery *query, gpointer user_data, gpointer *result)
     gboolean new_ledger = FALSE;
     GncPluginPage *page;
 
+    /* Searches on memos and the like can't use an index, and the split
+     * getters keep to the rule of qof_query_set_parallel, so let big
+     * books be searched on all processors. */
+    qof_query_set_parallel (query, TRUE);
+
     ledger = gnc_ledger_display_find_by_query (ftd->ledger_q);
     if (!ledger)
     {
@@ -70,6 +70,11 @@ const char *qof_win32_get_time_format(QofWin32Picture picture);
 typedef struct
 {
     void (*timespec_normalize) (Timespec *t);
+    /* Turn the local time zone offset cache used by gnc_localtime_r
+     * and gnc_mktime on or off, to compare them with GDateTime. */
+    void (*set_tz_cache_enabled) (gboolean enabled);
+    /* Drop the cached local zone and offsets after TZ changes. */
+    void (*reset_tz_cache) (void);
 } Testfuncs;
 
 Testfuncs *gnc_date_load_funcs (void);
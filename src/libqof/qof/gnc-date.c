@@ -100,15 +100,16 @@ static QofLogModule log_module = QOF_MOD_ENGINE;
  * g_date_time_new_from_timeval_local, and gnc_g_date_time_to_local. The
  * following functions provide a work-around.
  */
+static GTimeZone *local_tz = NULL;
+
 static GTimeZone*
 gnc_g_time_zone_new_local (void)
 {
-    static GTimeZone* tz = NULL;
-    if (tz)
-        return tz;
+    if (local_tz)
+        return local_tz;
 #ifndef G_OS_WIN32
-    tz = g_time_zone_new_local();
-    return tz;
+    local_tz = g_time_zone_new_local();
+    return local_tz;
 #else
     {
         TIME_ZONE_INFORMATION tzinfo;
@@ -117,10 +118,10 @@ gnc_g_time_zone_new_local (void)
         gint hours = -bias / 60; // 60 minutes per hour
         gint minutes = (bias < 0 ? -bias : bias) % 60;
         gchar *tzstr = g_strdup_printf ("%+03d:%02d", hours, minutes);
-        tz = g_time_zone_new(tzstr);
+        local_tz = g_time_zone_new(tzstr);
         g_free (tzstr);
     }
-    return tz;
+    return local_tz;
 #endif
 }
 
@@ -312,6 +313,235 @@ _gnc_date_time_init (_GncDateTime *gncdt)
     gncdt->to_local = gnc_g_date_time_to_local;
 }
 
+/****************** Local Time Zone Offset Cache ***************************/
+/* Converting between time64 and struct tm with GDateTime costs a couple
+ * of GDateTimes and time zone lookups each time, which adds up when
+ * formatting the dates of a whole register or report.  So the local
+ * zone's offset from UTC and DST flag are cached a year at a time, as
+ * years are used, as the offset at the start of the year followed by
+ * the changes during it.  Dates outside the years covered, or in years
+ * with too many changes, are left to GDateTime.  MSWindows works out
+ * DST itself (see above) and so doesn't use the cache.
+ */
+#define TZ_CACHE_FIRST_YEAR 1900
+#define TZ_CACHE_LAST_YEAR 2199
+#define TZ_CACHE_MAX_CHANGES 6
+#define SECS_PER_DAY 86400
+
+typedef struct
+{
+    time64 from;        /* UTC */
+    gint32 offset;      /* seconds east of UTC */
+    gboolean isdst;
+} TzOffset;
+
+typedef struct
+{
+    gint built;         /* 1 if built, -1 if it can't be cached */
+    guint n_changes;
+    TzOffset offsets[TZ_CACHE_MAX_CHANGES + 1];
+} TzYear;
+
+static TzYear tz_years[TZ_CACHE_LAST_YEAR - TZ_CACHE_FIRST_YEAR + 1];
+#ifdef G_OS_WIN32
+static gboolean tz_cache_enabled = FALSE;
+#else
+static gboolean tz_cache_enabled = TRUE;
+#endif
+G_LOCK_DEFINE_STATIC (tz_years);
+
+static inline gint64
+floor_div (gint64 a, gint64 b)
+{
+    return a / b - (a % b < 0);
+}
+
+/* Days from 1970-01-01 to a date in the proleptic Gregorian calendar,
+ * and back again. */
+static gint64
+days_from_civil (gint64 year, gint month, gint day)
+{
+    gint64 era;
+    guint yoe, doy, doe;
+
+    year -= month <= 2;
+    era = floor_div (year, 400);
+    yoe = (guint) (year - era * 400);
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void
+civil_from_days (gint64 days, gint *year, gint *month, gint *day)
+{
+    gint64 era;
+    guint doe, yoe, doy, mp;
+
+    days += 719468;
+    era = floor_div (days, 146097);
+    doe = (guint) (days - era * 146097);
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (gint) (era * 400 + yoe + (*month <= 2));
+}
+
+static void
+tz_year_build (TzYear *ty, gint year)
+{
+    GTimeZone *tz = gnc_g_time_zone_new_local ();
+    time64 start = days_from_civil (year, 1, 1) * SECS_PER_DAY;
+    time64 last = days_from_civil (year + 1, 1, 1) * SECS_PER_DAY - 1;
+    time64 prev = start, t;
+    gint interval = g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, start);
+    gint built = 1;
+
+    ty->n_changes = 0;
+    if (interval < 0)
+    {
+        g_atomic_int_set (&ty->built, -1);
+        return;
+    }
+    ty->offsets[0].from = start;
+    ty->offsets[0].offset = g_time_zone_get_offset (tz, interval);
+    ty->offsets[0].isdst = g_time_zone_is_dst (tz, interval);
+
+    /* Go through the year a day at a time looking for the interval to
+     * change, and find the second it changes by bisection. */
+    for (t = start + SECS_PER_DAY; prev < last; prev = t, t += SECS_PER_DAY)
+    {
+        time64 lo = prev, hi = MIN (t, last);
+        gint next = g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, hi);
+        TzOffset *cur = &ty->offsets[ty->n_changes];
+        gint32 offset;
+        gboolean isdst;
+
+        if (next == interval)
+            continue;
+        if (next < 0)
+        {
+            built = -1;
+            break;
+        }
+        while (hi - lo > 1)
+        {
+            time64 mid = lo + (hi - lo) / 2;
+            if (g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, mid) == interval)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        interval = next;
+        offset = g_time_zone_get_offset (tz, interval);
+        isdst = g_time_zone_is_dst (tz, interval);
+        if (offset == cur->offset && isdst == cur->isdst)
+            continue;
+        if (ty->n_changes == TZ_CACHE_MAX_CHANGES)
+        {
+            built = -1;
+            break;
+        }
+        cur++;
+        ty->n_changes++;
+        cur->from = hi;
+        cur->offset = offset;
+        cur->isdst = isdst;
+    }
+    g_atomic_int_set (&ty->built, built);
+}
+
+/* Look up the local zone's offset from UTC and DST flag at a time;
+ * FALSE if the time's year isn't cached. */
+static gboolean
+tz_cache_lookup (time64 t, gint32 *offset, gboolean *isdst)
+{
+    gint year, month, day;
+    TzYear *ty;
+    guint i;
+
+    if (!tz_cache_enabled)
+        return FALSE;
+    civil_from_days (floor_div (t, SECS_PER_DAY), &year, &month, &day);
+    if (year < TZ_CACHE_FIRST_YEAR || year > TZ_CACHE_LAST_YEAR)
+        return FALSE;
+
+    ty = &tz_years[year - TZ_CACHE_FIRST_YEAR];
+    if (g_atomic_int_get (&ty->built) == 0)
+    {
+        G_LOCK (tz_years);
+        if (ty->built == 0)
+            tz_year_build (ty, year);
+        G_UNLOCK (tz_years);
+    }
+    if (g_atomic_int_get (&ty->built) < 0)
+        return FALSE;
+
+    for (i = ty->n_changes; i > 0 && t < ty->offsets[i].from; i--);
+    *offset = ty->offsets[i].offset;
+    *isdst = ty->offsets[i].isdst;
+    return TRUE;
+}
+
+/* Find the UTC time of a local time (in seconds since the epoch as if
+ * it were UTC), so long as there's just the one: a local time skipped
+ * or repeated by a change of offset is left to GDateTime, which knows
+ * how it wants to resolve them. */
+static gboolean
+tz_cache_local_to_utc (time64 local, time64 *utc, gint32 *offset,
+                       gboolean *isdst)
+{
+    gint32 before, after, off;
+    gboolean dst;
+    guint found = 0;
+
+    /* Offsets are less than a day, so these are the offsets that
+     * could apply. */
+    if (!tz_cache_lookup (local - SECS_PER_DAY, &before, &dst) ||
+            !tz_cache_lookup (local + SECS_PER_DAY, &after, &dst))
+        return FALSE;
+
+    if (tz_cache_lookup (local - before, &off, &dst) && off == before)
+    {
+        *utc = local - off;
+        *offset = off;
+        *isdst = dst;
+        found++;
+    }
+    if (after != before &&
+            tz_cache_lookup (local - after, &off, &dst) && off == after)
+    {
+        *utc = local - off;
+        *offset = off;
+        *isdst = dst;
+        found++;
+    }
+    return found == 1;
+}
+
+static void
+tz_cache_set_enabled (gboolean enabled)
+{
+#ifndef G_OS_WIN32
+    tz_cache_enabled = enabled;
+#endif
+}
+
+/* Forget the local zone and every cached year, so that a change to TZ
+ * takes effect; for tests. */
+static void
+tz_cache_reset (void)
+{
+    G_LOCK (tz_years);
+    if (local_tz)
+        g_time_zone_unref (local_tz);
+    local_tz = NULL;
+    memset (tz_years, 0, sizeof (tz_years));
+    G_UNLOCK (tz_years);
+}
+
 /****************** Posix Replacement Functions ***************************/
 void
 gnc_tm_free (struct tm* time)
@@ -336,6 +566,29 @@ gnc_g_date_time_fill_struct_tm (GDateTime *gdt, struct tm* time)
      --time->tm_mon;
 }
 
+/* Fill in a struct tm like gnc_g_date_time_fill_struct_tm, given the
+ * seconds since the epoch in the time's own zone; tm_yday counts from
+ * 1 as GDateTime's day of the year does. */
+static void
+gnc_tm_fill_from_secs (time64 secs, struct tm* time)
+{
+     gint64 days = floor_div (secs, SECS_PER_DAY);
+     gint secs_of_day = (gint) (secs - days * SECS_PER_DAY);
+     gint year, month, day;
+
+     memset (time, 0, sizeof (struct tm));
+     civil_from_days (days, &year, &month, &day);
+     time->tm_year = year - 1900;
+     time->tm_mon = month - 1;
+     time->tm_mday = day;
+     time->tm_hour = secs_of_day / 3600;
+     time->tm_min = secs_of_day / 60 % 60;
+     time->tm_sec = secs_of_day % 60;
+     /* 1970-01-01 was a Thursday */
+     time->tm_wday = (gint) ((days % 7 + 11) % 7);
+     time->tm_yday = (gint) (days - days_from_civil (year, 1, 1)) + 1;
+}
+
 struct tm*
 gnc_localtime (const time64 *secs)
 {
@@ -357,7 +610,21 @@ struct tm*
 gnc_localtime_r (const time64 *secs, struct tm* time)
 {
      guint index = 0;
-     GDateTime *gdt = gnc_g_date_time_new_from_unix_local (*secs);
+     GDateTime *gdt;
+     gint32 offset;
+     gboolean isdst;
+
+     if (tz_cache_lookup (*secs, &offset, &isdst))
+     {
+          gnc_tm_fill_from_secs (*secs + offset, time);
+          time->tm_isdst = isdst;
+#ifdef HAVE_STRUCT_TM_GMTOFF
+          time->tm_gmtoff = offset;
+#endif
+          return time;
+     }
+
+     gdt = gnc_g_date_time_new_from_unix_local (*secs);
      g_return_val_if_fail (gdt != NULL, NULL);
 
      gnc_g_date_time_fill_struct_tm (gdt, time);
@@ -444,12 +711,56 @@ normalize_struct_tm (struct tm* time)
      time->tm_year = year - 1900;
 }
 
+/* A normalized struct tm's time as seconds since the epoch as if it
+ * were UTC, if it's a time GDateTime would take. */
+static gboolean
+normalized_struct_tm_to_secs (const struct tm* time, time64 *secs)
+{
+     gint year = time->tm_year + 1900;
+     gint64 days;
+
+     /* tm_mon counts from 1 here */
+     if (time->tm_mon < 1 || time->tm_mon > 12 || time->tm_mday < 1 ||
+         time->tm_hour < 0 || time->tm_hour > 23 ||
+         time->tm_min < 0 || time->tm_min > 59 ||
+         time->tm_sec < 0 || time->tm_sec > 59 ||
+         year < TZ_CACHE_FIRST_YEAR || year > TZ_CACHE_LAST_YEAR)
+          return FALSE;
+     days = days_from_civil (year, time->tm_mon, time->tm_mday);
+     /* Make sure it's a real day: gnc_date_get_last_mday() doesn't
+      * know that 1900 and 2100 aren't leap years. */
+     if (time->tm_mday > 28 &&
+         days >= days_from_civil (year + (time->tm_mon == 12),
+                                  time->tm_mon % 12 + 1, 1))
+          return FALSE;
+     *secs = days * SECS_PER_DAY + time->tm_hour * 3600 +
+             time->tm_min * 60 + time->tm_sec;
+     return TRUE;
+}
+
 time64
 gnc_mktime (struct tm* time)
 {
      GDateTime *gdt;
-     time64 secs;
+     time64 secs, local;
+     gint32 offset;
+     gboolean isdst;
+
      normalize_struct_tm (time);
+     if (normalized_struct_tm_to_secs (time, &local) &&
+         tz_cache_local_to_utc (local, &secs, &offset, &isdst))
+     {
+          gint64 days = floor_div (local, SECS_PER_DAY);
+          time->tm_mon--;
+          time->tm_wday = (gint) ((days % 7 + 11) % 7);
+          time->tm_yday = (gint) (days - days_from_civil (time->tm_year + 1900, 1, 1)) + 1;
+          time->tm_isdst = isdst;
+#ifdef HAVE_STRUCT_TM_GMTOFF
+          time->tm_gmtoff = offset;
+#endif
+          return secs;
+     }
+
      gdt = gnc_g_date_time_new_local (time->tm_year + 1900, time->tm_mon,
 				      time->tm_mday, time->tm_hour,
 				      time->tm_min, (gdouble)(time->tm_sec));
@@ -1840,5 +2151,7 @@ gnc_date_load_funcs (void)
 {
     Testfuncs *tf = g_slice_new (Testfuncs);
     tf->timespec_normalize = timespec_normalize;
+    tf->set_tz_cache_enabled = tz_cache_set_enabled;
+    tf->reset_tz_cache = tz_cache_reset;
     return tf;
 }
@@ -160,6 +160,130 @@ reduce128(qofint128 n, gint64 d)
     return out;
 }
 
+/* Round the magnitude of a quotient, *quot, given the non-zero
+ * remainder of the division by divisor and the sign of the dividend.
+ * denom_neg is set when converting to a reciprocal denominator, which
+ * rounds without the checks for 2*remainder overflowing. */
+static inline GNCNumericErrorCode
+round_quotient(gint64 *quot, gint64 remainder, gint64 divisor, gint64 sign,
+               gint denom_neg, gint how)
+{
+    switch (how & GNC_NUMERIC_RND_MASK)
+    {
+    case GNC_HOW_RND_FLOOR:
+        if (sign < 0)
+        {
+            *quot = *quot + 1;
+        }
+        break;
+
+    case GNC_HOW_RND_CEIL:
+        if (sign > 0)
+        {
+            *quot = *quot + 1;
+        }
+        break;
+
+    case GNC_HOW_RND_TRUNC:
+        break;
+
+    case GNC_HOW_RND_PROMOTE:
+        *quot = *quot + 1;
+        break;
+
+    case GNC_HOW_RND_ROUND_HALF_DOWN:
+        if (denom_neg)
+        {
+            if ((2 * remainder) > divisor)
+            {
+                *quot = *quot + 1;
+            }
+        }
+        else if ((2 * remainder) > divisor)
+        {
+            *quot = *quot + 1;
+        }
+        /* check that 2*remainder didn't over-flow */
+        else if (((2 * remainder) < remainder) &&
+                 (remainder > (divisor / 2)))
+        {
+            *quot = *quot + 1;
+        }
+        break;
+
+    case GNC_HOW_RND_ROUND_HALF_UP:
+        if (denom_neg)
+        {
+            if ((2 * remainder) >= divisor)
+            {
+                *quot = *quot + 1;
+            }
+        }
+        else if ((2 * remainder ) >= divisor)
+        {
+            *quot = *quot + 1;
+        }
+        /* check that 2*remainder didn't over-flow */
+        else if (((2 * remainder) < remainder) &&
+                 (remainder >= (divisor / 2)))
+        {
+            *quot = *quot + 1;
+        }
+        break;
+
+    case GNC_HOW_RND_ROUND:
+        if (denom_neg)
+        {
+            if ((2 * remainder) > divisor)
+            {
+                *quot = *quot + 1;
+            }
+            else if ((2 * remainder) == divisor)
+            {
+                if (*quot % 2)
+                {
+                    *quot = *quot + 1;
+                }
+            }
+        }
+        else
+        {
+            if ((2 * remainder ) > divisor)
+            {
+                *quot = *quot + 1;
+            }
+            /* check that 2*remainder didn't over-flow */
+            else if (((2 * remainder) < remainder) &&
+                     (remainder > (divisor / 2)))
+            {
+                *quot = *quot + 1;
+            }
+            else if ((2 * remainder) == divisor)
+            {
+                if (*quot % 2)
+                {
+                    *quot = *quot + 1;
+                }
+            }
+            /* check that 2*remainder didn't over-flow */
+            else if (((2 * remainder) < remainder) &&
+                     (remainder ==  (divisor / 2)))
+            {
+                if (*quot % 2)
+                {
+                    *quot = *quot + 1;
+                }
+            }
+        }
+        break;
+
+    case GNC_HOW_RND_NEVER:
+        return GNC_ERROR_REMAINDER;
+        break;
+    }
+    return GNC_ERROR_OK;
+}
+
 /* *******************************************************************
  *  gnc_numeric_zero_p
  ********************************************************************/
@@ -380,6 +504,19 @@ gnc_numeric_add(gnc_numeric a, gnc_numeric b,
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
 
+    /* Adding up amounts of one commodity: the sum already has the
+     * denominator wanted, so there's nothing to convert. */
+    if ((a.denom == b.denom) && (a.denom > 0) &&
+            ((denom == a.denom) ||
+             ((denom == GNC_DENOM_AUTO) &&
+              (how & GNC_NUMERIC_DENOM_MASK) != GNC_HOW_DENOM_REDUCE &&
+              (how & GNC_NUMERIC_DENOM_MASK) != GNC_HOW_DENOM_SIGFIG)))
+    {
+        sum.num = a.num + b.num;  /* BUG: overflow not handled.  */
+        sum.denom = a.denom;
+        return sum;
+    }
+
     if ((denom == GNC_DENOM_AUTO) &&
             (how & GNC_NUMERIC_DENOM_MASK) == GNC_HOW_DENOM_FIXED)
     {
@@ -460,6 +597,112 @@ gnc_numeric_add(gnc_numeric a, gnc_numeric b,
     return gnc_numeric_convert(sum, denom, how);
 }
 
+/* *******************************************************************
+ *  gnc_numeric_sum
+ ********************************************************************/
+
+/* Values are added up a block at a time as plain gint64s: SUM_BLOCK
+ * values each less than SUM_BLOCK_LIMIT in magnitude can't overflow. */
+#define SUM_BLOCK       (1 << 15)
+#define SUM_BLOCK_LIMIT (G_GINT64_CONSTANT(1) << 47)
+
+static inline qofint128
+int128_from_gint64 (gint64 x)
+{
+    qofint128 r;
+
+    r.hi = 0;
+    r.isneg = (0 > x);
+    r.lo = r.isneg ? - (guint64) x : (guint64) x;
+    r.isbig = (r.lo >> 63);
+    return r;
+}
+
+gnc_numeric
+gnc_numeric_sum(gnc_numeric start, const gnc_numeric *values,
+                guint n_values, gint64 denom, gint how)
+{
+    qofint128 total;
+    guint64 nonzero = 0;
+    gint64 d;
+    guint i, j;
+
+    if (n_values == 0)
+    {
+        return start;
+    }
+    g_return_val_if_fail (values, gnc_numeric_error(GNC_ERROR_ARG));
+
+    /* The fast way works when adding each value would take the same
+     * denominator fast path as gnc_numeric_add.  Starting from zero
+     * (gnc_numeric_zero()) comes to the same thing. */
+    d = values[0].denom;
+    if ((d <= 0) || gnc_numeric_check(start) ||
+            ((start.denom != d) && ((start.num != 0) || (start.denom != 1))) ||
+            ((denom != d) &&
+             ((denom != GNC_DENOM_AUTO) ||
+              (how & GNC_NUMERIC_DENOM_MASK) == GNC_HOW_DENOM_REDUCE ||
+              (how & GNC_NUMERIC_DENOM_MASK) == GNC_HOW_DENOM_SIGFIG)))
+    {
+        goto add_one_at_a_time;
+    }
+
+    total = int128_from_gint64 (start.num);
+    for (i = 0; i < n_values; i += SUM_BLOCK)
+    {
+        guint n = MIN (SUM_BLOCK, n_values - i);
+        guint64 sum = 0, big = 0, diff = 0;
+
+        /* No branches in here, so that it can be vectorized. */
+        for (j = i; j < i + n; j++)
+        {
+            gint64 num = values[j].num;
+            sum += num;
+            big |= num ^ (num >> 63);
+            nonzero |= num;
+            diff |= values[j].denom ^ d;
+        }
+        if (diff)
+        {
+            goto add_one_at_a_time;
+        }
+
+        if (big < SUM_BLOCK_LIMIT)
+        {
+            total = add128 (total, int128_from_gint64 ((gint64) sum));
+        }
+        else
+        {
+            for (j = i; j < i + n; j++)
+                total = add128 (total, int128_from_gint64 (values[j].num));
+        }
+    }
+
+    if (total.isbig)
+    {
+        return gnc_numeric_error(GNC_ERROR_OVERFLOW);
+    }
+
+    /* Adding zeroes to zero with GNC_HOW_DENOM_FIXED keeps the
+     * denominator of the zero. */
+    if ((start.denom != d) && !nonzero && (denom == GNC_DENOM_AUTO) &&
+            (how & GNC_NUMERIC_DENOM_MASK) == GNC_HOW_DENOM_FIXED)
+    {
+        return start;
+    }
+
+    start.num = total.isneg ? - (gint64) total.lo : (gint64) total.lo;
+    start.denom = d;
+    return start;
+
+add_one_at_a_time:
+    for (i = 0; i < n_values; i++)
+    {
+        start = gnc_numeric_add (start, values[i], denom, how);
+    }
+    return start;
+}
+
 /* *******************************************************************
  *  gnc_numeric_sub
  ********************************************************************/
@@ -523,6 +766,30 @@ gnc_numeric_mul(gnc_numeric a, gnc_numeric b,
         how   = how & GNC_NUMERIC_RND_MASK;
     }
 
+    /* Everything in one denominator: the product is over denom*denom,
+     * so just divide it by denom, as gnc_numeric_convert would. */
+    if ((a.denom == denom) && (b.denom == denom) && (denom > 0))
+    {
+        bignume = mult128 (a.num, b.num);
+        bigdeno = mult128 (denom, denom);
+        if (!bignume.isbig && !bigdeno.isbig)
+        {
+            gint64 sign = (a.num * b.num < 0) ? -1 : 1;
+            gint64 remainder = bignume.lo % denom;
+
+            result.num = bignume.lo / denom;
+            result.denom = denom;
+            if (remainder &&
+                    round_quotient(&result.num, remainder, denom, sign,
+                                   0, how))
+            {
+                return gnc_numeric_error(GNC_ERROR_REMAINDER);
+            }
+            result.num = (sign > 0) ? result.num : (-result.num);
+            return result;
+        }
+    }
+
     if (a.denom < 0)
     {
         a.num *= -a.denom;  /* BUG: overflow not handled.  */
@@ -632,6 +899,30 @@ gnc_numeric_div(gnc_numeric a, gnc_numeric b,
         }
     }
 
+    /* Everything in one denominator: (a/d)/(b/d) is a/b, which only has
+     * to be put over d, as gnc_numeric_convert would. */
+    if ((a.denom == denom) && (b.denom == denom) && (denom > 0) &&
+            (b.num != 0) && (b.num != G_MININT64))
+    {
+        nume = mult128 (a.num, denom);
+        if (!nume.isbig)
+        {
+            gint64 divisor = (b.num < 0) ? -b.num : b.num;
+            gint64 sign = ((a.num < 0) == (b.num < 0)) ? 1 : -1;
+            gint64 remainder = nume.lo % divisor;
+
+            quotient.num = nume.lo / divisor;
+            quotient.denom = denom;
+            if (remainder &&
+                    round_quotient(&quotient.num, remainder, divisor, sign,
+                                   0, how))
+            {
+                return gnc_numeric_error(GNC_ERROR_REMAINDER);
+            }
+            quotient.num = (sign > 0) ? quotient.num : (-quotient.num);
+            return quotient;
+        }
+    }
 
     if (a.denom < 0)
     {
@@ -770,7 +1061,7 @@ gnc_numeric_convert(gnc_numeric in, gint64 denom, gint how)
 {
     gnc_numeric out;
     gnc_numeric temp;
-    gint64      temp_bc;
+    gint64      temp_bc = 0;
     gint64      temp_a;
     gint64      remainder;
     gint64      sign;
@@ -901,118 +1192,11 @@ gnc_numeric_convert(gnc_numeric in, gint64 denom, gint how)
 
     if (remainder)
     {
-        switch (how & GNC_NUMERIC_RND_MASK)
+        if (round_quotient(&out.num, remainder,
+                           denom_neg ? temp_bc : temp.denom,
+                           sign, denom_neg, how))
         {
-        case GNC_HOW_RND_FLOOR:
-            if (sign < 0)
-            {
-                out.num = out.num + 1;
-            }
-            break;
-
-        case GNC_HOW_RND_CEIL:
-            if (sign > 0)
-            {
-                out.num = out.num + 1;
-            }
-            break;
-
-        case GNC_HOW_RND_TRUNC:
-            break;
-
-        case GNC_HOW_RND_PROMOTE:
-            out.num = out.num + 1;
-            break;
-
-        case GNC_HOW_RND_ROUND_HALF_DOWN:
-            if (denom_neg)
-            {
-                if ((2 * remainder) > in.denom * denom)
-                {
-                    out.num = out.num + 1;
-                }
-            }
-            else if ((2 * remainder) > temp.denom)
-            {
-                out.num = out.num + 1;
-            }
-            /* check that 2*remainder didn't over-flow */
-            else if (((2 * remainder) < remainder) &&
-                     (remainder > (temp.denom / 2)))
-            {
-                out.num = out.num + 1;
-            }
-            break;
-
-        case GNC_HOW_RND_ROUND_HALF_UP:
-            if (denom_neg)
-            {
-                if ((2 * remainder) >= in.denom * denom)
-                {
-                    out.num = out.num + 1;
-                }
-            }
-            else if ((2 * remainder ) >= temp.denom)
-            {
-                out.num = out.num + 1;
-            }
-            /* check that 2*remainder didn't over-flow */
-            else if (((2 * remainder) < remainder) &&
-                     (remainder >= (temp.denom / 2)))
-            {
-                out.num = out.num + 1;
-            }
-            break;
-
-        case GNC_HOW_RND_ROUND:
-            if (denom_neg)
-            {
-                if ((2 * remainder) > in.denom * denom)
-                {
-                    out.num = out.num + 1;
-                }
-                else if ((2 * remainder) == in.denom * denom)
-                {
-                    if (out.num % 2)
-                    {
-                        out.num = out.num + 1;
-                    }
-                }
-            }
-            else
-            {
-                if ((2 * remainder ) > temp.denom)
-                {
-                    out.num = out.num + 1;
-                }
-                /* check that 2*remainder didn't over-flow */
-                else if (((2 * remainder) < remainder) &&
-                         (remainder > (temp.denom / 2)))
-                {
-                    out.num = out.num + 1;
-                }
-                else if ((2 * remainder) == temp.denom)
-                {
-                    if (out.num % 2)
-                    {
-                        out.num = out.num + 1;
-                    }
-                }
-                /* check that 2*remainder didn't over-flow */
-                else if (((2 * remainder) < remainder) &&
-                         (remainder ==  (temp.denom / 2)))
-                {
-                    if (out.num % 2)
-                    {
-                        out.num = out.num + 1;
-                    }
-                }
-            }
-            break;
-
-        case GNC_HOW_RND_NEVER:
             return gnc_numeric_error(GNC_ERROR_REMAINDER);
-            break;
         }
     }
 
@@ -396,6 +396,18 @@ gnc_numeric gnc_numeric_add(gnc_numeric a, gnc_numeric b,
 gnc_numeric gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
                             gint64 denom, gint how);
 
+/** Return start plus the n_values values, the same as adding them to
+ *  start one at a time with gnc_numeric_add(sum, value, denom, how).
+ *
+ *  When the values share a denominator that the sum keeps, as the
+ *  amounts of one commodity do, their numerators are simply added up,
+ *  a block at a time in a loop the compiler can vectorize.  A total
+ *  that doesn't fit in 64 bits is then a GNC_ERROR_OVERFLOW instead of
+ *  wrapping round.  Otherwise the values are added one at a time.
+ */
+gnc_numeric gnc_numeric_sum(gnc_numeric start, const gnc_numeric *values,
+                            guint n_values, gint64 denom, gint how);
+
 /** Multiply a times b, returning the product.  An overflow
  *  may occur if the result of the multiplication can't
  *  be represented as a ratio of 64-bit int's after removing
@@ -444,6 +456,18 @@ gnc_numeric gnc_numeric_sub_fixed(gnc_numeric a, gnc_numeric b)
     return gnc_numeric_sub(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
+
+/**
+ * Shortcut for most common case: gnc_numeric_sum(start, values, n_values,
+ *                        GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+ */
+static inline
+gnc_numeric gnc_numeric_sum_fixed(gnc_numeric start, const gnc_numeric *values,
+                                  guint n_values)
+{
+    return gnc_numeric_sum(start, values, n_values, GNC_DENOM_AUTO,
+                           GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+}
 /** @} */
 
 /** @name Arithmetic Functions with Exact Error Returns
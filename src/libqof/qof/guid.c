@@ -68,6 +68,20 @@
 static gboolean guid_initialized = FALSE;
 static struct md5_ctx guid_context;
 
+/* The ids themselves come from a ChaCha20 key stream.  guid_init()
+ * gathers the entropy into guid_context as it always has, and the
+ * digest of that is the key; after that making an id is a quarter of
+ * a ChaCha20 block. */
+typedef struct
+{
+    guint32 input[16];
+    guchar  block[64];
+    guint   used;
+} GuidGenerator;
+
+static GuidGenerator guid_generator;
+G_LOCK_DEFINE_STATIC (guid_generator);
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -347,22 +361,99 @@ init_from_time(void)
     return total;
 }
 
-static size_t
-init_from_int(int val)
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTERROUND(x, a, b, c, d) \
+    x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 16); \
+    x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 12); \
+    x[a] += x[b]; x[d] = ROTL32(x[d] ^ x[a], 8);  \
+    x[c] += x[d]; x[b] = ROTL32(x[b] ^ x[c], 7)
+
+static guint32
+load_le32 (const guchar *p)
 {
-    ENTER("");
-    md5_process_bytes(&val, sizeof(val), &guid_context);
-    LEAVE("");
-    return sizeof(int);
+    return (guint32) p[0] | ((guint32) p[1] << 8) |
+           ((guint32) p[2] << 16) | ((guint32) p[3] << 24);
 }
 
-static size_t
-init_from_buff(unsigned char * buf, size_t buflen)
+/* Compute the next block of the key stream; the caller holds the lock. */
+static void
+guid_generator_next_block (GuidGenerator *gen)
 {
-    ENTER("");
-    md5_process_bytes(buf, buflen, &guid_context);
-    LEAVE("");
-    return buflen;
+    guint32 x[16];
+    int i;
+
+    memcpy (x, gen->input, sizeof (x));
+    for (i = 0; i < 20; i += 2)
+    {
+        QUARTERROUND (x, 0, 4,  8, 12);
+        QUARTERROUND (x, 1, 5,  9, 13);
+        QUARTERROUND (x, 2, 6, 10, 14);
+        QUARTERROUND (x, 3, 7, 11, 15);
+        QUARTERROUND (x, 0, 5, 10, 15);
+        QUARTERROUND (x, 1, 6, 11, 12);
+        QUARTERROUND (x, 2, 7,  8, 13);
+        QUARTERROUND (x, 3, 4,  9, 14);
+    }
+    for (i = 0; i < 16; i++)
+    {
+        guint32 v = x[i] + gen->input[i];
+        gen->block[4 * i]     = v & 0xff;
+        gen->block[4 * i + 1] = (v >> 8) & 0xff;
+        gen->block[4 * i + 2] = (v >> 16) & 0xff;
+        gen->block[4 * i + 3] = (v >> 24) & 0xff;
+    }
+
+    /* 64-bit block counter */
+    if (++gen->input[12] == 0)
+        ++gen->input[13];
+    gen->used = 0;
+}
+
+/* Key the generator from the entropy pool. */
+static void
+guid_generator_seed (void)
+{
+    static const guchar sigma[] = "expand 32-byte k";
+    guchar key[32], nonce[8];
+    struct md5_ctx ctx;
+    time64 now = gnc_time (NULL);
+    FILE *fp;
+    int i;
+
+    /* Two digests of the pool make up the key... */
+    ctx = guid_context;
+    md5_finish_ctx (&ctx, key);
+    ctx = guid_context;
+    md5_process_bytes (key, 16, &ctx);
+    md5_finish_ctx (&ctx, key + 16);
+
+    /* ...with fresh system randomness folded in where there is some. */
+    fp = g_fopen ("/dev/urandom", "rb");
+    if (fp != NULL)
+    {
+        guchar extra[32];
+        if (fread (extra, 1, sizeof (extra), fp) == sizeof (extra))
+            for (i = 0; i < 32; i++)
+                key[i] ^= extra[i];
+        fclose (fp);
+    }
+
+    memset (nonce, 0, sizeof (nonce));
+    memcpy (nonce, &now, MIN (sizeof (now), sizeof (nonce)));
+
+    G_LOCK (guid_generator);
+    for (i = 0; i < 4; i++)
+        guid_generator.input[i] = load_le32 (sigma + 4 * i);
+    for (i = 0; i < 8; i++)
+        guid_generator.input[4 + i] = load_le32 (key + 4 * i);
+    guid_generator.input[12] = 0;
+    guid_generator.input[13] = 0;
+    guid_generator.input[14] = load_le32 (nonce);
+    guid_generator.input[15] = load_le32 (nonce + 4);
+    guid_generator_next_block (&guid_generator);
+    G_UNLOCK (guid_generator);
+
+    memset (key, 0, sizeof (key));
 }
 
 void
@@ -529,6 +620,8 @@ guid_init(void)
               (unsigned long int)bytes);
 #endif
 
+    guid_generator_seed ();
+
     guid_initialized = TRUE;
     LEAVE();
 }
@@ -536,59 +629,42 @@ guid_init(void)
 void
 guid_shutdown (void)
 {
+    G_LOCK (guid_generator);
+    memset (&guid_generator, 0, sizeof (guid_generator));
+    G_UNLOCK (guid_generator);
+    guid_initialized = FALSE;
 }
 
-#define GUID_PERIOD 5000
-
 void
 guid_new(GncGUID *guid)
 {
-    static int counter = 0;
-    struct md5_ctx ctx;
-
     if (guid == NULL)
         return;
 
-    if (!guid_initialized)
-        guid_init();
-
-    /* make the id */
-    ctx = guid_context;
-    md5_finish_ctx(&ctx, guid->data);
-
-    /* update the global context */
-    init_from_time();
-
-    /* Make it a little extra salty.  I think init_from_time was buggy,
-    * or something, since duplicate id's actually happened. Or something
-    * like that.  I think this is because init_from_time kept returning
-    * the same values too many times in a row.  So we'll do some 'block
-    * chaining', and feed in the old guid as new random data.
-    *
-    * Anyway, I think the whole fact that I saw a bunch of duplicate
-    * id's at one point, but can't reproduce the bug is rather alarming.
-    * Something must be broken somewhere, and merely adding more salt
-    * is just hiding the problem, not fixing it.
-    */
-    init_from_int (433781 * counter);
-    init_from_buff (guid->data, GUID_DATA_SIZE);
-
-    if (counter == 0)
-    {
-        FILE *fp;
+    guid_new_batch (guid, 1);
+}
 
-        fp = g_fopen ("/dev/urandom", "r");
-        if (fp == NULL)
-            return;
+void
+guid_new_batch (GncGUID *guids, guint n_guids)
+{
+    guint i;
 
-        init_from_stream(fp, 32);
+    if (guids == NULL || n_guids == 0)
+        return;
 
-        fclose(fp);
+    if (!guid_initialized)
+        guid_init();
 
-        counter = GUID_PERIOD;
+    G_LOCK (guid_generator);
+    for (i = 0; i < n_guids; i++)
+    {
+        if (guid_generator.used == sizeof (guid_generator.block))
+            guid_generator_next_block (&guid_generator);
+        memcpy (guids[i].data, guid_generator.block + guid_generator.used,
+                GUID_DATA_SIZE);
+        guid_generator.used += GUID_DATA_SIZE;
     }
-
-    counter--;
+    G_UNLOCK (guid_generator);
 }
 
 GncGUID
@@ -92,7 +92,9 @@ void guid_shutdown (void);
  *  @param guid A pointer to an existing guid data structure.  The
  *  existing value will be replaced with a new value.
  *
- * This routine uses the md5 algorithm to build strong random guids.
+ * The ids are taken from a ChaCha20 key stream, keyed from the
+ * entropy guid_init() gathers, so they are strong random guids.  This
+ * routine is thread-safe.
  * Note that while guid's are generated randomly, the odds of this
  * routine returning a non-unique id are astronomically small.
  * (Literally astronomically: If you had Cray's on every solar
@@ -102,6 +104,12 @@ void guid_shutdown (void);
  */
 void guid_new(GncGUID *guid);
 
+/** Generate n_guids new ids into the array guids, as guid_new() would
+ *  one at a time, but taking the generator's lock only once.  Meant
+ *  for code that creates many objects at a time, like importers.
+ */
+void guid_new_batch(GncGUID *guids, guint n_guids);
+
 /** Generate a new id. If no initialization function has been called,
  *  guid_init() will be called before the id is created.
  *
@@ -32,16 +32,28 @@
 
 #include "qof.h"
 
-/* Note that we keep the keys for this hash table in the
- * qof_string_cache, as it is very likely we will see the
- * same keys over and over again  */
+/* Most frames hold only a few slots, so a frame keeps them in a short
+ * array sorted by key and only switches to a hash table once it has
+ * more than KVP_FRAME_MAX_SLOTS.  Either way the keys are kept in the
+ * qof_string_cache, as it is very likely we will see the same keys
+ * over and over again.  A frame without either holds no slots and
+ * hasn't been used yet. */
+#define KVP_FRAME_MAX_SLOTS 8
+
+typedef struct
+{
+    const char  * key;
+    KvpValue    * value;
+} KvpFrameSlot;
 
 struct _KvpFrame
 {
+    KvpFrameSlot * slots;
+    guint16       n_slots;
+    guint16       n_alloc;
     GHashTable  * hash;
 };
 
-
 typedef struct
 {
     void        *data;
@@ -88,21 +100,61 @@ kvp_comp_func(gconstpointer v, gconstpointer v2)
 static gboolean
 init_frame_body_if_needed(KvpFrame *f)
 {
-    if (!f->hash)
+    if (!f->slots && !f->hash)
+    {
+        f->n_alloc = 1;
+        f->slots = g_new (KvpFrameSlot, f->n_alloc);
+    }
+    return TRUE;
+}
+
+/* Find the position of the key in the slot array, or where it would
+ * have to be inserted. */
+static gboolean
+kvp_frame_find_slot (const KvpFrame *f, const char *key, guint *pos)
+{
+    guint lo = 0, hi = f->n_slots;
+
+    while (lo < hi)
     {
-        f->hash = g_hash_table_new(&kvp_hash_func, &kvp_comp_func);
+        guint mid = (lo + hi) / 2;
+        int cmp = strcmp (f->slots[mid].key, key);
+
+        if (cmp == 0)
+        {
+            *pos = mid;
+            return TRUE;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    return(f->hash != NULL);
+    *pos = lo;
+    return FALSE;
+}
+
+/* Move the slots of a frame that has outgrown its array into a hash
+ * table.  The cached keys move along. */
+static void
+kvp_frame_make_hash (KvpFrame *f)
+{
+    guint i;
+
+    f->hash = g_hash_table_new(&kvp_hash_func, &kvp_comp_func);
+    for (i = 0; i < f->n_slots; i++)
+        g_hash_table_insert (f->hash, (gpointer) f->slots[i].key,
+                             f->slots[i].value);
+    g_free (f->slots);
+    f->slots = NULL;
+    f->n_slots = f->n_alloc = 0;
 }
 
 KvpFrame *
 kvp_frame_new(void)
 {
-    KvpFrame * retval = g_new0(KvpFrame, 1);
-
     /* Save space until the frame is actually used */
-    retval->hash = NULL;
-    return retval;
+    return g_new0(KvpFrame, 1);
 }
 
 static void
@@ -115,11 +167,13 @@ kvp_frame_delete_worker(gpointer key, gpointer value, gpointer user_data)
 void
 kvp_frame_delete(KvpFrame * frame)
 {
+    guint i;
+
     if (!frame) return;
 
+    /* free any allocated resource for frame or its children */
     if (frame->hash)
     {
-        /* free any allocated resource for frame or its children */
         g_hash_table_foreach(frame->hash, & kvp_frame_delete_worker,
                              (gpointer)frame);
 
@@ -127,6 +181,10 @@ kvp_frame_delete(KvpFrame * frame)
         g_hash_table_destroy(frame->hash);
         frame->hash = NULL;
     }
+    for (i = 0; i < frame->n_slots; i++)
+        kvp_frame_delete_worker ((gpointer) frame->slots[i].key,
+                                 frame->slots[i].value, frame);
+    g_free (frame->slots);
     g_free(frame);
 }
 
@@ -134,7 +192,7 @@ gboolean
 kvp_frame_is_empty(const KvpFrame * frame)
 {
     if (!frame) return TRUE;
-    if (!frame->hash) return TRUE;
+    if (!frame->slots && !frame->hash) return TRUE;
     return FALSE;
 }
 
@@ -151,16 +209,29 @@ KvpFrame *
 kvp_frame_copy(const KvpFrame * frame)
 {
     KvpFrame * retval = kvp_frame_new();
+    guint i;
 
     if (!frame) return retval;
 
     if (frame->hash)
     {
-        if (!init_frame_body_if_needed(retval)) return(NULL);
+        retval->hash = g_hash_table_new(&kvp_hash_func, &kvp_comp_func);
         g_hash_table_foreach(frame->hash,
                              & kvp_frame_copy_worker,
                              (gpointer)retval);
     }
+    else if (frame->slots)
+    {
+        retval->n_alloc = frame->n_alloc;
+        retval->n_slots = frame->n_slots;
+        retval->slots = g_new (KvpFrameSlot, retval->n_alloc);
+        for (i = 0; i < frame->n_slots; i++)
+        {
+            retval->slots[i].key =
+                qof_string_cache_insert ((gpointer) frame->slots[i].key);
+            retval->slots[i].value = kvp_value_copy (frame->slots[i].value);
+        }
+    }
     return retval;
 }
 
@@ -175,10 +246,49 @@ kvp_frame_replace_slot_nc (KvpFrame * frame, const char * slot,
     gpointer orig_key;
     gpointer orig_value = NULL;
     int      key_exists;
+    guint    pos;
 
     if (!frame || !slot) return NULL;
     if (!init_frame_body_if_needed(frame)) return NULL; /* Error ... */
 
+    if (!frame->hash)
+    {
+        if (kvp_frame_find_slot (frame, slot, &pos))
+        {
+            orig_value = frame->slots[pos].value;
+            if (new_value)
+            {
+                frame->slots[pos].value = new_value;
+                return (KvpValue *) orig_value;
+            }
+            qof_string_cache_remove ((gpointer) frame->slots[pos].key);
+            frame->n_slots--;
+            memmove (frame->slots + pos, frame->slots + pos + 1,
+                     (frame->n_slots - pos) * sizeof (KvpFrameSlot));
+            return (KvpValue *) orig_value;
+        }
+        if (!new_value)
+            return NULL;
+
+        if (frame->n_slots < KVP_FRAME_MAX_SLOTS)
+        {
+            if (frame->n_slots == frame->n_alloc)
+            {
+                frame->n_alloc = MIN (frame->n_alloc * 2, KVP_FRAME_MAX_SLOTS);
+                frame->slots = g_renew (KvpFrameSlot, frame->slots,
+                                        frame->n_alloc);
+            }
+            memmove (frame->slots + pos + 1, frame->slots + pos,
+                     (frame->n_slots - pos) * sizeof (KvpFrameSlot));
+            frame->slots[pos].key = qof_string_cache_insert ((gpointer) slot);
+            frame->slots[pos].value = new_value;
+            frame->n_slots++;
+            return NULL;
+        }
+
+        kvp_frame_make_hash (frame);
+    }
+
     key_exists = g_hash_table_lookup_extended(frame->hash, slot,
                  & orig_key, & orig_value);
     if (key_exists)
@@ -598,11 +708,15 @@ kvp_frame_set_slot_nc(KvpFrame * frame, const char * slot,
 KvpValue *
 kvp_frame_get_slot(const KvpFrame * frame, const char * slot)
 {
-    KvpValue *v;
-    if (!frame) return NULL;
-    if (!frame->hash) return NULL;  /* Error ... */
-    v = g_hash_table_lookup(frame->hash, slot);
-    return v;
+    guint pos;
+
+    if (!frame || !slot) return NULL;
+    QOF_STATS_COUNT ("qof.kvp.lookups", 1);
+    if (frame->hash)
+        return g_hash_table_lookup(frame->hash, slot);
+    if (kvp_frame_find_slot (frame, slot, &pos))
+        return frame->slots[pos].value;
+    return NULL;
 }
 
 /* ============================================================ */
@@ -841,6 +955,154 @@ kvp_frame_get_slot_path_gslist (KvpFrame *frame,
     return NULL;
 }
 
+/* *******************************************************************
+ * KvpPath functions
+ ********************************************************************/
+
+/* The keys and their strings are allocated in one block with the
+ * path. */
+struct _KvpPath
+{
+    guint         n_keys;
+    const char  * keys[1];
+};
+
+static KvpPath *
+kvp_path_alloc (guint n_keys, gsize text_len, char **text)
+{
+    gsize size = G_STRUCT_OFFSET (KvpPath, keys) + n_keys * sizeof (char *);
+    KvpPath *path = g_malloc (size + text_len);
+
+    path->n_keys = n_keys;
+    *text = (char *) path + size;
+    return path;
+}
+
+KvpPath *
+kvp_path_new (const char *key_path)
+{
+    KvpPath *path;
+    const char *p;
+    char *text, *q;
+    guint n_keys = 0, i = 0;
+    gsize len;
+
+    if (!key_path || !*key_path) return NULL;
+    len = strlen (key_path);
+    if (key_path[len - 1] == '/') return NULL;
+
+    for (p = key_path; *p; p++)
+        if (*p != '/' && (p == key_path || p[-1] == '/'))
+            n_keys++;
+
+    path = kvp_path_alloc (n_keys, len + 1, &text);
+    memcpy (text, key_path, len + 1);
+    for (q = text; *q; q++)
+    {
+        if (*q == '/')
+            *q = '\0';
+        else if (q == text || q[-1] == '\0')
+            path->keys[i++] = q;
+    }
+    return path;
+}
+
+KvpPath *
+kvp_path_new_keys (const char *first_key, ...)
+{
+    KvpPath *path;
+    va_list ap;
+    const char *key;
+    char *text;
+    guint n_keys = 0, i;
+    gsize len = 0;
+
+    g_return_val_if_fail (first_key, NULL);
+
+    va_start (ap, first_key);
+    for (key = first_key; key; key = va_arg (ap, const char *))
+    {
+        n_keys++;
+        len += strlen (key) + 1;
+    }
+    va_end (ap);
+
+    path = kvp_path_alloc (n_keys, len, &text);
+    va_start (ap, first_key);
+    for (i = 0, key = first_key; key; i++, key = va_arg (ap, const char *))
+    {
+        len = strlen (key) + 1;
+        memcpy (text, key, len);
+        path->keys[i] = text;
+        text += len;
+    }
+    va_end (ap);
+    return path;
+}
+
+void
+kvp_path_free (KvpPath *path)
+{
+    g_free (path);
+}
+
+const KvpPath *
+kvp_path_get_static (gsize *location, const char *key_path)
+{
+    if (g_once_init_enter (location))
+        g_once_init_leave (location, (gsize) kvp_path_new (key_path));
+    return (const KvpPath *) *location;
+}
+
+KvpValue *
+kvp_frame_get_path_value (const KvpFrame *frame, const KvpPath *path)
+{
+    KvpValue *value = NULL;
+    guint i;
+
+    if (!frame || !path) return NULL;
+
+    for (i = 0; i < path->n_keys; i++)
+    {
+        if (i > 0)
+        {
+            frame = kvp_value_get_frame (value);
+            if (!frame) return NULL;
+        }
+        value = kvp_frame_get_slot (frame, path->keys[i]);
+        if (!value) return NULL;
+    }
+    return value;
+}
+
+KvpFrame *
+kvp_frame_set_path_value_nc (KvpFrame *frame, const KvpPath *path,
+                             KvpValue *value)
+{
+    guint i;
+
+    if (!frame || !path || !path->n_keys) return NULL;
+
+    for (i = 0; i + 1 < path->n_keys; i++)
+    {
+        frame = get_or_make (frame, path->keys[i]);
+        if (!frame) return NULL;
+    }
+    kvp_frame_set_slot_destructively (frame, path->keys[i], value);
+    return frame;
+}
+
+KvpFrame *
+kvp_frame_set_path_value (KvpFrame *frame, const KvpPath *path,
+                          const KvpValue *value)
+{
+    KvpValue *new_value = value ? kvp_value_copy (value) : NULL;
+
+    frame = kvp_frame_set_path_value_nc (frame, path, new_value);
+    if (!frame) kvp_value_delete (new_value);
+    return frame;
+}
+
 /* *******************************************************************
  * kvp glist functions
  ********************************************************************/
@@ -1322,11 +1584,33 @@ kvp_frame_for_each_slot(KvpFrame *f,
                                      gpointer data),
                         gpointer data)
 {
+    guint i;
+
     if (!f) return;
     if (!proc) return;
-    if (!(f->hash)) return;
 
-    g_hash_table_foreach(f->hash, (GHFunc) proc, data);
+    if (f->hash)
+        g_hash_table_foreach(f->hash, (GHFunc) proc, data);
+    for (i = 0; i < f->n_slots; i++)
+        proc (f->slots[i].key, f->slots[i].value, data);
+}
+
+void
+kvp_frame_for_each_slot_sorted(KvpFrame *f,
+                               void (*proc)(const char *key,
+                                            KvpValue *value,
+                                            gpointer data),
+                               gpointer data)
+{
+    if (!f) return;
+    if (!proc) return;
+
+    /* The slot array is sorted already */
+    if (f->hash)
+        g_hash_table_foreach_sorted(f->hash, (GHFunc) proc, data,
+                                    (GCompareFunc) strcmp);
+    else
+        kvp_frame_for_each_slot (f, proc, data);
 }
 
 #ifdef _MSC_VER
@@ -1434,8 +1718,8 @@ kvp_frame_compare(const KvpFrame *fa, const KvpFrame *fb)
     if (fa && !fb) return 1;
 
     /* nothing is always less than something */
-    if (!fa->hash && fb->hash) return -1;
-    if (fa->hash && !fb->hash) return 1;
+    if (kvp_frame_is_empty (fa) && !kvp_frame_is_empty (fb)) return -1;
+    if (!kvp_frame_is_empty (fa) && kvp_frame_is_empty (fb)) return 1;
 
     status.compare = 0;
     status.other_frame = (KvpFrame *) fb;
@@ -1625,8 +1909,9 @@ kvp_frame_to_string(const KvpFrame *frame)
 
     tmp1 = g_strdup_printf("{\n");
 
-    if (frame->hash)
-        g_hash_table_foreach(frame->hash, kvp_frame_to_string_helper, &tmp1);
+    kvp_frame_for_each_slot((KvpFrame *) frame,
+                            (void (*)(const char *, KvpValue *, gpointer))
+                            kvp_frame_to_string_helper, &tmp1);
 
     {
         gchar *tmp2;
@@ -1645,4 +1930,13 @@ kvp_frame_get_hash(const KvpFrame *frame)
     return frame->hash;
 }
 
+GHashTable*
+kvp_frame_convert_to_hash(KvpFrame *frame)
+{
+    g_return_val_if_fail (frame != NULL, NULL);
+    if (frame->slots)
+        kvp_frame_make_hash (frame);
+    return frame->hash;
+}
+
 /* ========================== END OF FILE ======================= */
@@ -74,6 +74,9 @@ typedef struct _KvpFrame KvpFrame;
  * KvpValueType enum. */
 typedef struct _KvpValue KvpValue;
 
+/** Opaque key path, split up into its keys once */
+typedef struct _KvpPath KvpPath;
+
 /** \brief possible types in the union KvpValue
  * \todo : People have asked for boolean values,
  *  e.g. in xaccAccountSetAutoInterestXfer
@@ -411,6 +414,51 @@ gint          kvp_frame_compare(const KvpFrame *fa, const KvpFrame *fb);
 
 gint          double_compare(double v1, double v2);
 /** @} */
+
+/** @name KvpPath: Key Paths Parsed Once
+
+  The routines taking a "/"-delimited path parse it on every call.
+  Code that uses the same path over and over can split it up into a
+  KvpPath once and use that instead.
+ @{
+*/
+/** Split key_path at the slashes, like the routines taking a path
+ *  string do.  Returns NULL for an empty path or one ending in a
+ *  slash.  Free it with kvp_path_free(). */
+KvpPath    * kvp_path_new (const gchar *key_path);
+
+/** Make a path of the given keys, terminated by NULL.  The keys are
+ *  used as they are, slashes and all. */
+KvpPath    * kvp_path_new_keys (const gchar *first_key, ...);
+
+void          kvp_path_free (KvpPath *path);
+
+/** Return the path for key_path kept at *location, making it the
+ *  first time.  For static paths which live as long as the program:
+ *
+ *  static gsize code_path = 0;
+ *  kvp_frame_get_path_value (frame,
+ *                            kvp_path_get_static (&code_path, "tax-US/code"));
+ */
+const KvpPath * kvp_path_get_static (gsize *location, const gchar *key_path);
+
+/** Return the value at the end of the path, or NULL if any portion of
+ *  the path doesn't exist. */
+KvpValue   * kvp_frame_get_path_value (const KvpFrame *frame,
+                                       const KvpPath *path);
+
+/** Store value at the end of the path, making the frames on the way
+ *  as needed, and destroy the old value.  A NULL value removes the
+ *  slot.  The value is copied.  Returns the frame holding the slot,
+ *  or NULL on error. */
+KvpFrame   * kvp_frame_set_path_value (KvpFrame *frame, const KvpPath *path,
+                                       const KvpValue *value);
+
+/** As kvp_frame_set_path_value(), but the frame takes over value. */
+KvpFrame   * kvp_frame_set_path_value_nc (KvpFrame *frame,
+                                          const KvpPath *path,
+                                          KvpValue *value);
+/** @} */
 /** @name KvpValue List Convenience Functions
 
   You probably shouldn't be using these low-level routines
@@ -581,12 +629,25 @@ void kvp_frame_for_each_slot(KvpFrame *f,
                                      gpointer data),
                              gpointer data);
 
+/** Like kvp_frame_for_each_slot(), but in strcmp() order of the keys. */
+void kvp_frame_for_each_slot_sorted(KvpFrame *f,
+                                    void (*proc)(const char *key,
+                                            KvpValue *value,
+                                            gpointer data),
+                                    gpointer data);
+
 /** @} */
 
 /** Internal helper routines, you probably shouldn't be using these. */
 gchar* kvp_frame_to_string(const KvpFrame *frame);
 gchar* binary_to_string(const void *data, guint32 size);
+/** Return the frame's hash table, or NULL if it is small enough to keep
+ *  its slots in an array; prefer the iterators above. */
 GHashTable* kvp_frame_get_hash(const KvpFrame *frame);
+/** Move a small frame's slots into a hash table and return it.  This
+ *  changes the frame, so only do it where a slot could be set: within
+ *  an edit of the frame's owner. */
+GHashTable* kvp_frame_convert_to_hash(KvpFrame *frame);
 
 /** @} */
 #endif
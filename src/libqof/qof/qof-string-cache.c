@@ -40,40 +40,117 @@ static QofLogModule log_module = QOF_MOD_UTIL;
 /* =================================================================== */
 /* The QOF string cache                                                */
 /*                                                                     */
-/* The cache is a GHashTable where a copy of the string is the key,    */
-/* and a ref count is the value                                        */
+/* The cache is split into shards picked by the hash of the string, so */
+/* that threads interning different strings rarely wait for each       */
+/* other.  Each shard is a GHashTable, under its own lock, whose keys  */
+/* are the cached copies of the strings.  Each copy is allocated just  */
+/* after its ref count.                                                */
 /* =================================================================== */
 
-static GHashTable* qof_string_cache = NULL;
+#define QOF_STRING_CACHE_SHARDS 16  /* the shard index is 4 bits */
 
-static GHashTable*
-qof_get_string_cache(void)
+typedef struct
 {
-    if (!qof_string_cache)
-    {
-        qof_string_cache = g_hash_table_new_full(
-                               g_str_hash,               /* hash_func          */
-                               g_str_equal,              /* key_equal_func     */
-                               g_free,                   /* key_destroy_func   */
-                               g_free);                  /* value_destroy_func */
-    }
-    return qof_string_cache;
+#ifdef HAVE_GLIB_2_32
+    GMutex       lock;
+#else
+    GStaticMutex lock;
+#endif
+    GHashTable * cache;
+    guint64      inserts;
+    guint64      hits;
+    guint64      bytes_saved;
+} QofStringCacheShard;
+
+static QofStringCacheShard qof_string_cache[QOF_STRING_CACHE_SHARDS];
+
+typedef struct
+{
+    guint refcount;
+    gchar str[1];
+} QofStringCacheEntry;
+
+#define CACHE_ENTRY(key) ((QofStringCacheEntry *) \
+    ((gchar *) (key) - G_STRUCT_OFFSET (QofStringCacheEntry, str)))
+
+static void
+qof_string_cache_entry_free (gpointer key)
+{
+    g_free (CACHE_ENTRY (key));
+}
+
+#ifdef HAVE_GLIB_2_32
+# define SHARD_LOCK(shard)   g_mutex_lock (&(shard)->lock)
+# define SHARD_UNLOCK(shard) g_mutex_unlock (&(shard)->lock)
+#else
+# define SHARD_LOCK(shard)   g_static_mutex_lock (&(shard)->lock)
+# define SHARD_UNLOCK(shard) g_static_mutex_unlock (&(shard)->lock)
+
+static gpointer
+qof_string_cache_init_locks (gpointer unused)
+{
+    int i;
+    for (i = 0; i < QOF_STRING_CACHE_SHARDS; i++)
+        g_static_mutex_init (&qof_string_cache[i].lock);
+    return NULL;
+}
+#endif
+
+/* Static GMutexes need no initialization; GStaticMutexes do. */
+static void
+qof_string_cache_ensure_locks (void)
+{
+#ifndef HAVE_GLIB_2_32
+    static GOnce locks_once = G_ONCE_INIT;
+    g_once (&locks_once, qof_string_cache_init_locks, NULL);
+#endif
+}
+
+/* Return the locked shard for key, creating its table on demand. */
+static QofStringCacheShard *
+qof_string_cache_lock_shard (gconstpointer key)
+{
+    QofStringCacheShard *shard;
+    guint hash = g_str_hash (key);
+
+    qof_string_cache_ensure_locks ();
+
+    /* Short strings leave the high bits of g_str_hash nearly constant,
+     * so spread them before picking the shard. */
+    shard = &qof_string_cache[(guint32) (hash * 0x9E3779B1u) >> 28];
+    SHARD_LOCK (shard);
+    if (!shard->cache)
+        shard->cache = g_hash_table_new_full(
+                           g_str_hash,               /* hash_func          */
+                           g_str_equal,              /* key_equal_func     */
+                           qof_string_cache_entry_free, /* key_destroy_func */
+                           NULL);                    /* value_destroy_func */
+    return shard;
 }
 
 void
 qof_string_cache_init(void)
 {
-    (void)qof_get_string_cache();
+    /* The shards create their tables when first used. */
+    qof_string_cache_ensure_locks ();
 }
 
 void
 qof_string_cache_destroy (void)
 {
-    if (qof_string_cache)
+    int i;
+
+    qof_string_cache_ensure_locks ();
+    for (i = 0; i < QOF_STRING_CACHE_SHARDS; i++)
     {
-        g_hash_table_destroy(qof_string_cache);
+        QofStringCacheShard *shard = &qof_string_cache[i];
+        SHARD_LOCK (shard);
+        if (shard->cache)
+            g_hash_table_destroy(shard->cache);
+        shard->cache = NULL;
+        shard->inserts = shard->hits = shard->bytes_saved = 0;
+        SHARD_UNLOCK (shard);
     }
-    qof_string_cache = NULL;
 }
 
 /* If the key exists in the cache, check the refcount.  If 1, just
@@ -83,21 +160,22 @@ qof_string_cache_remove(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
+        QofStringCacheShard *shard = qof_string_cache_lock_shard (key);
+        gchar *cache_key = g_hash_table_lookup(shard->cache, key);
+        if (cache_key)
         {
-            guint* refcount = (guint*)value;
-            if (*refcount == 1)
+            QofStringCacheEntry *entry = CACHE_ENTRY(cache_key);
+            if (entry->refcount == 1)
             {
-                g_hash_table_remove(cache, key);
+                g_hash_table_remove(shard->cache, key);
             }
             else
             {
-                --(*refcount);
+                --entry->refcount;
+                shard->bytes_saved -= strlen(cache_key) + 1;
             }
         }
+        SHARD_UNLOCK (shard);
     }
 }
 
@@ -108,25 +186,50 @@ qof_string_cache_insert(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
+        QofStringCacheShard *shard = qof_string_cache_lock_shard (key);
+        gchar *cache_key = g_hash_table_lookup(shard->cache, key);
+        shard->inserts++;
+        if (cache_key)
         {
-            guint* refcount = (guint*)value;
-            ++(*refcount);
-            return cache_key;
+            ++CACHE_ENTRY(cache_key)->refcount;
+            shard->hits++;
+            shard->bytes_saved += strlen(cache_key) + 1;
         }
         else
         {
-            gpointer new_key = g_strdup(key);
-            guint* refcount = g_malloc(sizeof(guint));
-            *refcount = 1;
-            g_hash_table_insert(cache, new_key, refcount);
-            return new_key;
+            gsize len = strlen(key);
+            QofStringCacheEntry *entry =
+                g_malloc(G_STRUCT_OFFSET(QofStringCacheEntry, str) + len + 1);
+            entry->refcount = 1;
+            memcpy(entry->str, key, len + 1);
+            cache_key = entry->str;
+            g_hash_table_insert(shard->cache, cache_key, cache_key);
         }
+        SHARD_UNLOCK (shard);
+        return cache_key;
     }
     return NULL;
 }
 
+void
+qof_string_cache_get_stats (QofStringCacheStats *stats)
+{
+    int i;
+
+    g_return_if_fail (stats);
+    memset (stats, 0, sizeof (*stats));
+    qof_string_cache_ensure_locks ();
+    for (i = 0; i < QOF_STRING_CACHE_SHARDS; i++)
+    {
+        QofStringCacheShard *shard = &qof_string_cache[i];
+        SHARD_LOCK (shard);
+        stats->inserts += shard->inserts;
+        stats->hits += shard->hits;
+        stats->bytes_saved += shard->bytes_saved;
+        if (shard->cache)
+            stats->n_strings += g_hash_table_size (shard->cache);
+        SHARD_UNLOCK (shard);
+    }
+}
+
 /* ************************ END OF FILE ***************************** */
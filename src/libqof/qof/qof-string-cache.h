@@ -63,8 +63,23 @@
  *
  * The string cache is demand-created on first use.
  *
+ * The cache may be used from several threads at once.  It is split
+ * into shards by the hash of the string, each with its own lock, so
+ * threads interning different strings seldom wait for each other.
+ *
  **/
 
+/** What the cache has done since it was created, from
+ *  qof_string_cache_get_stats(). */
+typedef struct
+{
+    guint64 inserts;      /**< calls to qof_string_cache_insert() */
+    guint64 hits;         /**< inserts that found the string cached */
+    guint64 bytes_saved;  /**< bytes the extra references would take
+                               as copies of their own */
+    guint   n_strings;    /**< distinct strings in the cache */
+} QofStringCacheStats;
+
 /** Initialize the string cache */
 void qof_string_cache_init(void);
 
@@ -81,6 +96,10 @@ void qof_string_cache_remove(gconstpointer key);
 */
 gpointer qof_string_cache_insert(gconstpointer key);
 
+/** Fill in stats for the whole cache.  The hit rate is
+ *  hits / inserts. */
+void qof_string_cache_get_stats(QofStringCacheStats *stats);
+
 #define CACHE_INSERT(str) qof_string_cache_insert((gconstpointer)(str))
 #define CACHE_REMOVE(str) qof_string_cache_remove((str))
 
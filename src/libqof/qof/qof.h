@@ -95,5 +95,6 @@
 #include "qofchoice.h"
 #include "qofreference.h"
 #include "qof-string-cache.h"
+#include "qofstats.h"
 
 #endif /* QOF_H_ */
@@ -60,11 +60,279 @@ static void coll_destroy(gpointer col)
     qof_collection_destroy((QofCollection *) col);
 }
 
+/* ====================================================================== */
+/* Locking the book for reading from several threads; see qofbook.h.
+ *
+ * The GRWLock does the real work.  Around it we remember which thread
+ * holds the write lock, so that it can take the write lock again and
+ * read without waiting for itself, and each thread keeps the list of
+ * the books it is reading, so that qof_book_is_reading() can answer for
+ * the calling thread.  The cache lock only orders readers filling lazy
+ * caches; writers never need it since they run alone. */
+
+struct _QofBookLocks
+{
+#ifdef HAVE_GLIB_2_32
+    GRWLock         rw_lock;
+    GRecMutex       cache_lock;
+#else
+    GStaticRWLock   rw_lock;
+    GStaticRecMutex cache_lock;
+#endif
+    gpointer        writer;        /* the GThread holding rw_lock to write */
+    guint           write_depth;
+    guint           writer_reads;  /* read locks taken by the writer */
+    gint            n_readers;
+};
+
+#ifdef HAVE_GLIB_2_32
+static GPrivate book_reads = G_PRIVATE_INIT ((GDestroyNotify) g_slist_free);
+# define THREAD_READS()       ((GSList *) g_private_get (&book_reads))
+# define SET_THREAD_READS(l)  g_private_set (&book_reads, (l))
+# define RW_READER_LOCK(l)    g_rw_lock_reader_lock (&(l)->rw_lock)
+# define RW_READER_UNLOCK(l)  g_rw_lock_reader_unlock (&(l)->rw_lock)
+# define RW_WRITER_LOCK(l)    g_rw_lock_writer_lock (&(l)->rw_lock)
+# define RW_WRITER_UNLOCK(l)  g_rw_lock_writer_unlock (&(l)->rw_lock)
+# define CACHE_LOCK(l)        g_rec_mutex_lock (&(l)->cache_lock)
+# define CACHE_UNLOCK(l)      g_rec_mutex_unlock (&(l)->cache_lock)
+#else
+static GStaticPrivate book_reads = G_STATIC_PRIVATE_INIT;
+# define THREAD_READS()       ((GSList *) g_static_private_get (&book_reads))
+# define SET_THREAD_READS(l)  \
+    g_static_private_set (&book_reads, (l), (GDestroyNotify) g_slist_free)
+# define RW_READER_LOCK(l)    g_static_rw_lock_reader_lock (&(l)->rw_lock)
+# define RW_READER_UNLOCK(l)  g_static_rw_lock_reader_unlock (&(l)->rw_lock)
+# define RW_WRITER_LOCK(l)    g_static_rw_lock_writer_lock (&(l)->rw_lock)
+# define RW_WRITER_UNLOCK(l)  g_static_rw_lock_writer_unlock (&(l)->rw_lock)
+# define CACHE_LOCK(l)        g_static_rec_mutex_lock (&(l)->cache_lock)
+# define CACHE_UNLOCK(l)      g_static_rec_mutex_unlock (&(l)->cache_lock)
+#endif
+
+static QofBookLocks *
+qof_book_locks_new (void)
+{
+    QofBookLocks *locks = g_new0 (QofBookLocks, 1);
+#ifdef HAVE_GLIB_2_32
+    g_rw_lock_init (&locks->rw_lock);
+    g_rec_mutex_init (&locks->cache_lock);
+#else
+    g_static_rw_lock_init (&locks->rw_lock);
+    g_static_rec_mutex_init (&locks->cache_lock);
+#endif
+    return locks;
+}
+
+static void
+qof_book_locks_free (QofBookLocks *locks)
+{
+    if (!locks) return;
+#ifdef HAVE_GLIB_2_32
+    g_rw_lock_clear (&locks->rw_lock);
+    g_rec_mutex_clear (&locks->cache_lock);
+#else
+    g_static_rw_lock_free (&locks->rw_lock);
+    g_static_rec_mutex_free (&locks->cache_lock);
+#endif
+    g_free (locks);
+}
+
+static inline gboolean
+is_writer (QofBookLocks *locks)
+{
+    return g_atomic_pointer_get (&locks->writer) == (gpointer) g_thread_self ();
+}
+
+static inline gboolean
+thread_reads (const QofBook *book)
+{
+    return g_slist_find (THREAD_READS (), book) != NULL;
+}
+
+void
+qof_book_read_lock (QofBook *book)
+{
+    QofBookLocks *locks;
+    gboolean again;
+
+    if (!book || !book->locks) return;
+    locks = book->locks;
+
+    again = thread_reads (book);
+    SET_THREAD_READS (g_slist_prepend (THREAD_READS (), book));
+    if (is_writer (locks))
+    {
+        /* Nobody else can write while we hold the write lock. */
+        locks->writer_reads++;
+        return;
+    }
+    /* A thread takes the GRWLock for reading only once, since a second
+     * reader lock would wait for any writer waiting on the first. */
+    if (again)
+        return;
+    RW_READER_LOCK (locks);
+    g_atomic_int_inc (&locks->n_readers);
+}
+
+void
+qof_book_read_unlock (QofBook *book)
+{
+    QofBookLocks *locks;
+    GSList *reads;
+
+    if (!book || !book->locks) return;
+    locks = book->locks;
+
+    reads = THREAD_READS ();
+    if (!g_slist_find (reads, book))
+    {
+        PERR ("book %p is not being read by this thread", book);
+        return;
+    }
+    reads = g_slist_remove (reads, book);
+    SET_THREAD_READS (reads);
+    if (is_writer (locks) && locks->writer_reads > 0)
+    {
+        locks->writer_reads--;
+        return;
+    }
+    if (g_slist_find (reads, book))
+        return;
+    g_atomic_int_add (&locks->n_readers, -1);
+    RW_READER_UNLOCK (locks);
+}
+
+gboolean
+qof_book_write_lock (QofBook *book)
+{
+    QofBookLocks *locks;
+
+    if (!book || !book->locks) return TRUE;
+    locks = book->locks;
+
+    if (is_writer (locks))
+    {
+        locks->write_depth++;
+        return TRUE;
+    }
+    /* Waiting for the readers to finish would wait for ourselves, and
+     * changing the book without waiting would race the other readers. */
+    if (thread_reads (book))
+    {
+        PERR ("book %p is changed by a thread that is reading it", book);
+        return FALSE;
+    }
+    RW_WRITER_LOCK (locks);
+    g_atomic_pointer_set (&locks->writer, g_thread_self ());
+    locks->write_depth = 1;
+    locks->writer_reads = 0;
+    return TRUE;
+}
+
+void
+qof_book_write_unlock (QofBook *book)
+{
+    QofBookLocks *locks;
+    gboolean reads;
+
+    if (!book || !book->locks) return;
+    locks = book->locks;
+
+    if (!is_writer (locks))
+    {
+        PERR ("book %p is not locked for writing by this thread", book);
+        return;
+    }
+    if (--locks->write_depth > 0)
+        return;
+
+    reads = locks->writer_reads > 0;
+    locks->writer_reads = 0;
+    g_atomic_pointer_set (&locks->writer, NULL);
+    RW_WRITER_UNLOCK (locks);
+
+    /* Keep the read locks taken while writing as an ordinary one.
+     * Another writer may get in first, just as if it had been taken
+     * now. */
+    if (reads)
+    {
+        RW_READER_LOCK (locks);
+        g_atomic_int_inc (&locks->n_readers);
+    }
+}
+
+gboolean
+qof_book_is_reading (const QofBook *book)
+{
+    if (!book || !book->locks) return FALSE;
+    return !is_writer (book->locks) && thread_reads (book);
+}
+
+gboolean
+qof_book_is_writing (const QofBook *book)
+{
+    if (!book || !book->locks) return FALSE;
+    return is_writer (book->locks);
+}
+
+gboolean
+qof_book_has_readers (const QofBook *book)
+{
+    if (!book || !book->locks) return FALSE;
+    return g_atomic_int_get (&book->locks->n_readers) > 0;
+}
+
+void
+qof_book_cache_lock (const QofBook *book)
+{
+    if (!book || !book->locks) return;
+    CACHE_LOCK (book->locks);
+}
+
+void
+qof_book_cache_unlock (const QofBook *book)
+{
+    if (!book || !book->locks) return;
+    CACHE_UNLOCK (book->locks);
+}
+
+/* ====================================================================== */
+
+void
+qof_book_begin_bulk_load (QofBook *book)
+{
+    g_return_if_fail (book);
+    book->bulk_load++;
+}
+
+void
+qof_book_end_bulk_load (QofBook *book)
+{
+    g_return_if_fail (book);
+    g_return_if_fail (book->bulk_load > 0);
+
+    if (--book->bulk_load > 0) return;
+
+    ENTER ("book=%p", book);
+    qof_object_bulk_load_end (book);
+    LEAVE ("book=%p", book);
+}
+
+gboolean
+qof_book_is_bulk_loading (const QofBook *book)
+{
+    return book && book->bulk_load > 0;
+}
+
+/* ====================================================================== */
+
 static void
 qof_book_init (QofBook *book)
 {
     if (!book) return;
 
+    /* Adding the book to its own collection takes its write lock. */
+    book->locks = qof_book_locks_new ();
+
     book->hash_of_collections = g_hash_table_new_full(
                                     g_str_hash, g_str_equal,
                                     (GDestroyNotify)qof_string_cache_remove,  /* key_destroy_func   */
@@ -113,6 +381,10 @@ qof_book_dispose_real (GObject *bookp)
 static void
 qof_book_finalize_real (GObject *bookp)
 {
+    QofBook *book = QOF_BOOK (bookp);
+
+    qof_book_locks_free (book->locks);
+    book->locks = NULL;
 }
 
 void
@@ -301,14 +573,11 @@ qof_book_mark_readonly(QofBook *book)
 }
 /* ====================================================================== */
 
-QofCollection *
-qof_book_get_collection (const QofBook *book, QofIdType entity_type)
+static QofCollection *
+qof_book_get_collection_unlocked (const QofBook *book, QofIdType entity_type)
 {
-    QofCollection *col;
-
-    if (!book || !entity_type) return NULL;
-
-    col = g_hash_table_lookup (book->hash_of_collections, entity_type);
+    QofCollection *col = g_hash_table_lookup (book->hash_of_collections,
+                                              entity_type);
     if (!col)
     {
         col = qof_collection_new (entity_type);
@@ -319,6 +588,24 @@ qof_book_get_collection (const QofBook *book, QofIdType entity_type)
     return col;
 }
 
+QofCollection *
+qof_book_get_collection (const QofBook *book, QofIdType entity_type)
+{
+    QofCollection *col;
+
+    if (!book || !entity_type) return NULL;
+
+    /* Readers may create a missing collection at the same time. */
+    if (qof_book_has_readers (book))
+    {
+        qof_book_cache_lock (book);
+        col = qof_book_get_collection_unlocked (book, entity_type);
+        qof_book_cache_unlock (book);
+        return col;
+    }
+    return qof_book_get_collection_unlocked (book, entity_type);
+}
+
 struct _iterate
 {
     QofCollectionForeachCB  fn;
@@ -346,6 +633,15 @@ qof_book_foreach_collection (const QofBook *book,
     iter.fn = cb;
     iter.data = user_data;
 
+    /* Don't let a reader add a collection under our feet; the lock is
+     * recursive, so the callback may still look collections up. */
+    if (qof_book_has_readers (book))
+    {
+        qof_book_cache_lock (book);
+        g_hash_table_foreach (book->hash_of_collections, foreach_cb, &iter);
+        qof_book_cache_unlock (book);
+        return;
+    }
     g_hash_table_foreach (book->hash_of_collections, foreach_cb, &iter);
 }
 
@@ -64,6 +64,10 @@ typedef struct _QofBookClass  QofBookClass;
 
 typedef void (*QofBookDirtyCB) (QofBook *, gboolean dirty, gpointer user_data);
 
+/* The locks that let several threads read a book at once; private
+ * to qofbook.c. */
+typedef struct _QofBookLocks QofBookLocks;
+
 /* Book structure */
 struct _QofBook
 {
@@ -133,6 +137,12 @@ struct _QofBook
      * except that it provides a nice convenience, avoiding a lookup
      * from the session.  Better solutions welcome ... */
     QofBackend *backend;
+
+    /* See qof_book_read_lock() */
+    QofBookLocks *locks;
+
+    /* See qof_book_begin_bulk_load() */
+    gint bulk_load;
 };
 
 struct _QofBookClass
@@ -237,6 +247,78 @@ void qof_book_set_data_fin (QofBook *book, const gchar *key, gpointer data,
 /** Retrieves arbitrary pointers to structs stored by qof_book_set_data. */
 gpointer qof_book_get_data (const QofBook *book, const gchar *key);
 
+/** @name Reading a book from several threads
+ *
+ * Any number of threads may read a book at once, each between
+ * qof_book_read_lock() and qof_book_read_unlock().  Changing the book
+ * needs its write lock, which waits for the readers to finish and
+ * keeps new ones out until the change is done.  The engine takes the
+ * write lock itself: for as long as any of the book's instances is
+ * being edited, from the outermost qof_begin_edit() to the matching
+ * commit, and while an instance is added to or taken out of its
+ * collection.  So code that changes the book through the usual
+ * begin/commit calls need do nothing more, while a reader must never
+ * begin an edit: qof_begin_edit() and the commits fail for a thread
+ * that is reading the book.
+ *
+ * So an edit left open keeps every reader out, including parallel
+ * queries, the workers of a bulk load and gnc_book_snapshot_new(),
+ * until it is committed.  An edit kept open while waiting for the
+ * user, such as the transaction being entered in a register, must be
+ * released with qof_instance_release_edit_lock(), after which the
+ * book is only locked for each change made to it and for its commit.
+ *
+ * The write lock is recursive for the thread that holds it, and that
+ * thread may take read locks too, which it then keeps as an ordinary
+ * reader once its write lock is released.
+ *
+ * Readers still fill in the caches the engine keeps lazily, such as an
+ * account's sorted splits and running balances.  A cache that may be
+ * filled while the book is being read is filled under
+ * qof_book_cache_lock(), and readers skip the caches that are only
+ * worth keeping for a single thread.
+ * @{ */
+
+/** Wait for any writer to finish, then read the book. */
+void qof_book_read_lock (QofBook *book);
+/** Stop reading the book. */
+void qof_book_read_unlock (QofBook *book);
+/** Wait for the readers and any other writer to finish, then keep
+ *  them out until the matching qof_book_write_unlock().  Returns FALSE
+ *  without locking if the calling thread is reading the book, which it
+ *  must then leave alone. */
+gboolean qof_book_write_lock (QofBook *book);
+void qof_book_write_unlock (QofBook *book);
+/** Return TRUE if the calling thread holds a read lock on the book
+ *  and nothing else may be written to it. */
+gboolean qof_book_is_reading (const QofBook *book);
+/** Return TRUE if the calling thread holds the book's write lock. */
+gboolean qof_book_is_writing (const QofBook *book);
+/** Return TRUE if any thread holds a read lock on the book. */
+gboolean qof_book_has_readers (const QofBook *book);
+/** Serialize the filling of lazy caches while the book is being read.
+ *  The lock is recursive. */
+void qof_book_cache_lock (const QofBook *book);
+void qof_book_cache_unlock (const QofBook *book);
+/** @} */
+
+/** @name Loading a book in bulk
+ *
+ * A backend that loads a whole book at once brackets the load with
+ * qof_book_begin_bulk_load() and qof_book_end_bulk_load().  In between
+ * the objects may leave undone the work that only matters to a book
+ * already in use -- keeping lists sorted, balances up to date and
+ * sending events as each instance is added -- and do it all in one go
+ * when the outermost qof_book_end_bulk_load() calls their bulk_load_end
+ * hook.  Nothing but the loader should use the book until then.
+ * @{ */
+void qof_book_begin_bulk_load (QofBook *book);
+void qof_book_end_bulk_load (QofBook *book);
+/** Return TRUE between qof_book_begin_bulk_load() and the matching
+ *  qof_book_end_bulk_load(). */
+gboolean qof_book_is_bulk_loading (const QofBook *book);
+/** @} */
+
 /** Return whether the book is read only. */
 gboolean qof_book_is_readonly(const QofBook *book);
 
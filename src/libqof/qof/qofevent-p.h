@@ -34,9 +34,20 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    /* What the handler subscribed to; see
+     * qof_event_register_filtered_handler() */
+    QofIdType type;
+    QofEventId event_mask;
+    gboolean filtered;
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
 void qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data);
 
+/* The number of events thrown away so far because events were
+ * suspended.  Anything kept up to date by events has to start over
+ * when this changes. */
+guint qof_event_get_dropped_count (void);
+
 #endif
@@ -32,8 +32,24 @@ static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
+static guint   dropped_events    = 0;
+static guint   filtered_handlers = 0;
+static gboolean flushing         = FALSE;
 static GList   *handlers  =   NULL;
 
+/* Events for the filtered handlers held back while events are
+ * suspended, one entry per entity in the order they first turned up,
+ * merged into event_mask.  An entity that goes away before they are
+ * delivered has its entry's entity cleared. */
+typedef struct
+{
+    QofInstance *entity;
+    QofEventId   event_mask;
+} PendingEvents;
+
+static GHashTable *pending_by_entity = NULL;
+static GPtrArray  *pending_events    = NULL;
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -68,8 +84,10 @@ find_next_handler_id(void)
     return handler_id;
 }
 
-gint
-qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+static gint
+register_handler (QofEventHandler handler, gpointer user_data,
+                  QofIdTypeConst type, QofEventId event_mask,
+                  gboolean filtered)
 {
     HandlerInfo *hi;
     gint handler_id;
@@ -92,12 +110,74 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
     hi->handler = handler;
     hi->user_data = user_data;
     hi->handler_id = handler_id;
+    hi->type = type ? CACHE_INSERT (type) : NULL;
+    hi->event_mask = event_mask;
+    hi->filtered = filtered;
+    if (filtered)
+        filtered_handlers++;
 
     handlers = g_list_prepend (handlers, hi);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
 
+gint
+qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+{
+    return register_handler (handler, user_data, NULL, ~0, FALSE);
+}
+
+gint
+qof_event_register_filtered_handler (QofEventHandler handler,
+                                     gpointer user_data,
+                                     QofIdTypeConst type,
+                                     QofEventId event_mask)
+{
+    return register_handler (handler, user_data, type, event_mask, TRUE);
+}
+
+static void
+handler_info_free (HandlerInfo *hi)
+{
+    CACHE_REMOVE (hi->type);
+    g_free (hi);
+}
+
+/* Once no events are being run, free the handlers unregistered while
+ * they were. */
+static void
+purge_pending_deletes (void)
+{
+    GList *node, *next_node;
+
+    if (handler_run_level > 0 || !pending_deletes)
+        return;
+
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = node->data;
+        next_node = node->next;
+        if (hi->handler == NULL)
+        {
+            /* remove this node from the list, then free this node */
+            handlers = g_list_remove_link (handlers, node);
+            g_list_free_1 (node);
+            handler_info_free (hi);
+        }
+    }
+    pending_deletes = 0;
+}
+
+static inline gboolean
+handler_wants (const HandlerInfo *hi, const QofInstance *entity,
+               QofEventId event_id)
+{
+    if (!hi->handler || !(hi->event_mask & event_id))
+        return FALSE;
+    return !hi->type || hi->type == entity->e_type ||
+           !g_strcmp0 (hi->type, entity->e_type);
+}
+
 void
 qof_event_unregister_handler (gint handler_id)
 {
@@ -122,12 +202,14 @@ qof_event_unregister_handler (gint handler_id)
 
         /* safety -- clear the handler in case we're running events now */
         hi->handler = NULL;
+        if (hi->filtered)
+            filtered_handlers--;
 
         if (handler_run_level == 0)
         {
             handlers = g_list_remove_link (handlers, node);
             g_list_free_1 (node);
-            g_free (hi);
+            handler_info_free (hi);
         }
         else
         {
@@ -151,6 +233,137 @@ qof_event_suspend (void)
     }
 }
 
+/* Run the filtered handlers that want an entity's coalesced events */
+static void
+deliver_filtered (QofInstance *entity, QofEventId event_mask,
+                  gpointer event_data)
+{
+    GList *node, *next_node;
+    gint64 start;
+
+    QOF_STATS_COUNT ("qof.event.dispatches", 1);
+    start = qof_stats_timer_start ();
+    handler_run_level++;
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = node->data;
+
+        next_node = node->next;
+        if (hi->filtered && handler_wants (hi, entity, event_mask))
+        {
+            QOF_STATS_COUNT ("qof.event.handler-calls", 1);
+            hi->handler (entity, event_mask & hi->event_mask, hi->user_data,
+                         event_data);
+        }
+    }
+    handler_run_level--;
+    QOF_STATS_TIME ("qof.event.handlers.usec", start);
+    purge_pending_deletes ();
+}
+
+static void
+pending_entity_gone (gpointer unused, GObject *where)
+{
+    PendingEvents *pe = g_hash_table_lookup (pending_by_entity, where);
+
+    if (!pe) return;
+    g_hash_table_remove (pending_by_entity, where);
+    pe->entity = NULL;
+}
+
+/* Hold on to an event for the filtered handlers until events are
+ * resumed, merged with the entity's other events.  An event with data
+ * can't wait: the data, such as the split in an account's
+ * ITEM_REMOVED, may be freed before the resume, and handlers like the
+ * SX instance model's need each item added or removed.  It is
+ * delivered at once.  Nor can a DESTROY, since the entity won't be
+ * around at resume; it is delivered at once together with whatever
+ * else was held. */
+static void
+queue_filtered (QofInstance *entity, QofEventId event_id,
+                gpointer event_data)
+{
+    PendingEvents *pe;
+    GList *node;
+
+    for (node = handlers; node; node = node->next)
+    {
+        HandlerInfo *hi = node->data;
+        if (hi->filtered && handler_wants (hi, entity, event_id))
+            break;
+    }
+    if (!node) return;
+
+    if (event_data)
+    {
+        deliver_filtered (entity, event_id, event_data);
+        return;
+    }
+
+    if (!pending_by_entity)
+    {
+        pending_by_entity = g_hash_table_new (g_direct_hash, g_direct_equal);
+        pending_events = g_ptr_array_new ();
+    }
+
+    pe = g_hash_table_lookup (pending_by_entity, entity);
+    if (!pe)
+    {
+        pe = g_new0 (PendingEvents, 1);
+        pe->entity = entity;
+        g_hash_table_insert (pending_by_entity, entity, pe);
+        g_ptr_array_add (pending_events, pe);
+        g_object_weak_ref (G_OBJECT (entity), pending_entity_gone, NULL);
+    }
+    pe->event_mask |= event_id;
+
+    if (event_id & QOF_EVENT_DESTROY)
+    {
+        g_object_weak_unref (G_OBJECT (entity), pending_entity_gone, NULL);
+        g_hash_table_remove (pending_by_entity, entity);
+        pe->entity = NULL;
+        deliver_filtered (entity, pe->event_mask, NULL);
+        /* Nothing left for the flush to deliver. */
+        pe->event_mask = 0;
+    }
+}
+
+/* Deliver everything held while events were suspended, including
+ * anything the handlers generate while doing so. */
+static void
+flush_filtered (void)
+{
+    if (flushing) return;
+    flushing = TRUE;
+
+    while (pending_events && pending_events->len)
+    {
+        GPtrArray *batch = pending_events;
+        guint i;
+
+        pending_events = g_ptr_array_new ();
+        for (i = 0; i < batch->len; i++)
+        {
+            PendingEvents *pe = g_ptr_array_index (batch, i);
+            QofInstance *entity = pe->entity;
+
+            if (entity)
+            {
+                g_object_weak_unref (G_OBJECT (entity), pending_entity_gone,
+                                     NULL);
+                g_hash_table_remove (pending_by_entity, entity);
+                pe->entity = NULL;
+                if (pe->event_mask)
+                    deliver_filtered (entity, pe->event_mask, NULL);
+            }
+        }
+        for (i = 0; i < batch->len; i++)
+            g_free (g_ptr_array_index (batch, i));
+        g_ptr_array_free (batch, TRUE);
+    }
+    flushing = FALSE;
+}
+
 void
 qof_event_resume (void)
 {
@@ -161,6 +374,8 @@ qof_event_resume (void)
     }
 
     suspend_counter--;
+    if (suspend_counter == 0)
+        flush_filtered ();
 }
 
 static void
@@ -169,6 +384,7 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
 {
     GList *node;
     GList *next_node = NULL;
+    gint64 start;
 
     g_return_if_fail(entity);
 
@@ -181,40 +397,29 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     }
     }
 
+    QOF_STATS_COUNT ("qof.event.dispatches", 1);
+    start = qof_stats_timer_start ();
     handler_run_level++;
     for (node = handlers; node; node = next_node)
     {
         HandlerInfo *hi = node->data;
 
         next_node = node->next;
-        if (hi->handler)
+        if (handler_wants (hi, entity, event_id))
         {
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
                   hi->handler, event_data);
+            QOF_STATS_COUNT ("qof.event.handler-calls", 1);
             hi->handler (entity, event_id, hi->user_data, event_data);
         }
     }
     handler_run_level--;
+    QOF_STATS_TIME ("qof.event.handlers.usec", start);
 
     /* If we're the outermost event runner and we have pending deletes
      * then go delete the handlers now.
      */
-    if (handler_run_level == 0 && pending_deletes)
-    {
-        for (node = handlers; node; node = next_node)
-        {
-            HandlerInfo *hi = node->data;
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
-        }
-        pending_deletes = 0;
-    }
+    purge_pending_deletes ();
 }
 
 void
@@ -233,9 +438,20 @@ qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
         return;
 
     if (suspend_counter)
+    {
+        dropped_events++;
+        if (filtered_handlers && event_id != QOF_EVENT_NONE)
+            queue_filtered (entity, event_id, event_data);
         return;
+    }
 
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+guint
+qof_event_get_dropped_count (void)
+{
+    return dropped_events;
+}
+
 /* =========================== END OF FILE ======================= */
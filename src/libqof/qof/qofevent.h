@@ -93,6 +93,33 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for some events of one type of entity.
+ *
+ * The handler is only called for events in event_mask, and if type is
+ * not NULL, only for entities of that type, so it needn't sort through
+ * everything else itself.
+ *
+ * While events are suspended these events are not dropped, as they
+ * are for the handlers from qof_event_register_handler().  They are
+ * collected per entity instead, ORed together into one event_type and
+ * delivered once when events are resumed, with NULL event_data.  An
+ * event that comes with event_data is delivered right away, since the
+ * data isn't kept and may be gone by the resume; so is an entity that
+ * is destroyed, with the events held for it and QOF_EVENT_DESTROY, as
+ * it won't exist at resume.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ * @param type:      entity type to get events for, or NULL for all
+ * @param event_mask: the events to get
+ *
+ * @return id identifying handler, for qof_event_unregister_handler()
+ */
+gint qof_event_register_filtered_handler (QofEventHandler handler,
+        gpointer handler_data,
+        QofIdTypeConst type,
+        QofEventId event_mask);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -127,7 +154,9 @@ void qof_event_gen (QofInstance *entity, QofEventId event_type,
  *
  *    This function may be called multiple times. To resume event generation,
  *   an equal number of calls to qof_event_resume
- *   must be made.
+ *   must be made.  Events generated in the meantime are lost, except
+ *   to filtered handlers, which get those with event data at once and
+ *   the rest when events are resumed.
  */
 void qof_event_suspend (void);
 
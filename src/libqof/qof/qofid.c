@@ -33,17 +33,118 @@
 static QofLogModule log_module = QOF_MOD_ENGINE;
 static gboolean qof_alt_dirty_mode = FALSE;
 
+/* The entities are kept in an open-addressing table keyed by a copy
+ * of their guid, so a lookup hashes the guid bytes and compares them
+ * in place without following any pointers.  The guids are random, so
+ * folding their two halves together is all the hashing they need.
+ * Collisions are resolved by linear probing, and removal shifts the
+ * following entries back instead of leaving tombstones. */
+typedef struct
+{
+    GncGUID       guid;
+    QofInstance * ent;       /* NULL for an empty slot */
+} QofCollectionSlot;
+
+#define QOF_COLLECTION_MIN_BITS 4
+
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    QofCollectionSlot * slots;
+    guint        n_bits;     /* the table has 1 << n_bits slots */
+    guint        count;
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
 /* =============================================================== */
 
+static inline guint
+collection_slot_index (const GncGUID *guid, guint n_bits)
+{
+    guint64 a, b;
+
+    memcpy (&a, guid->data, sizeof (a));
+    memcpy (&b, guid->data + sizeof (a), sizeof (b));
+    return (guint) (((a ^ b) * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15))
+                    >> (64 - n_bits));
+}
+
+static QofCollectionSlot *
+collection_find_slot (const QofCollection *col, const GncGUID *guid)
+{
+    guint mask = (1u << col->n_bits) - 1;
+    guint i = collection_slot_index (guid, col->n_bits);
+
+    while (col->slots[i].ent &&
+            memcmp (&col->slots[i].guid, guid, sizeof (GncGUID)) != 0)
+        i = (i + 1) & mask;
+    return &col->slots[i];
+}
+
+static void
+collection_resize (QofCollection *col, guint n_bits)
+{
+    QofCollectionSlot *old_slots = col->slots;
+    guint i, old_size = 1u << col->n_bits;
+
+    col->slots = g_new0 (QofCollectionSlot, 1u << n_bits);
+    col->n_bits = n_bits;
+    if (!old_slots) return;
+
+    for (i = 0; i < old_size; i++)
+        if (old_slots[i].ent)
+            *collection_find_slot (col, &old_slots[i].guid) = old_slots[i];
+    g_free (old_slots);
+}
+
+/* Store ent under guid, replacing whatever was there. */
+static void
+collection_insert (QofCollection *col, const GncGUID *guid, QofInstance *ent)
+{
+    QofCollectionSlot *slot;
+
+    /* Keep the table at most three quarters full */
+    if (4 * (col->count + 1) > 3u << col->n_bits)
+        collection_resize (col, col->n_bits + 1);
+
+    slot = collection_find_slot (col, guid);
+    if (!slot->ent)
+    {
+        slot->guid = *guid;
+        col->count++;
+    }
+    slot->ent = ent;
+}
+
+static void
+collection_remove (QofCollection *col, const GncGUID *guid)
+{
+    guint mask = (1u << col->n_bits) - 1;
+    QofCollectionSlot *slot = collection_find_slot (col, guid);
+    guint hole, i;
+
+    if (!slot->ent) return;
+    col->count--;
+
+    /* Move back any entry after the hole that can't be found from its
+     * home slot with the hole there. */
+    hole = slot - col->slots;
+    for (i = (hole + 1) & mask; col->slots[i].ent; i = (i + 1) & mask)
+    {
+        guint home = collection_slot_index (&col->slots[i].guid, col->n_bits);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            col->slots[hole] = col->slots[i];
+            hole = i;
+        }
+    }
+    col->slots[hole].ent = NULL;
+}
+
+/* =============================================================== */
+
 gboolean
 qof_get_alt_dirty_mode (void)
 {
@@ -64,7 +165,7 @@ qof_collection_new (QofIdType type)
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = CACHE_INSERT (type);
-    col->hash_of_entities = guid_hash_table_new();
+    collection_resize (col, QOF_COLLECTION_MIN_BITS);
     col->data = NULL;
     return col;
 }
@@ -73,9 +174,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    g_free (col->slots);
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->slots = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -95,38 +196,47 @@ void
 qof_collection_remove_entity (QofInstance *ent)
 {
     QofCollection *col;
+    QofBook *book;
     const GncGUID *guid;
 
     if (!ent) return;
     col = qof_instance_get_collection(ent);
     if (!col) return;
+    book = qof_instance_get_book(ent);
+    if (!qof_book_write_lock (book)) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_remove (col, guid);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(col);
     qof_instance_set_collection(ent, NULL);
+    qof_book_write_unlock (book);
 }
 
 void
 qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
 {
+    QofBook *book;
     const GncGUID *guid;
 
     if (!col || !ent) return;
     guid = qof_instance_get_guid(ent);
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
+    book = qof_instance_get_book(ent);
+    if (!qof_book_write_lock (book)) return;
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (col, guid, ent);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(col);
     qof_instance_set_collection(ent, col);
+    qof_book_write_unlock (book);
 }
 
 gboolean
 qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
 {
     QofInstance *e;
+    QofBook *book;
     const GncGUID *guid;
 
     e = NULL;
@@ -140,14 +250,20 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
         return FALSE;
     }
     g_return_val_if_fail (coll->e_type == ent->e_type, FALSE);
+    /* The insert may move the slots under a reader's feet. */
+    book = qof_instance_get_book(ent);
+    if (!qof_book_write_lock (book))
+        return FALSE;
     e = qof_collection_lookup_entity(coll, guid);
     if ( e != NULL )
     {
+        qof_book_write_unlock (book);
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (coll, guid, ent);
     if (!qof_alt_dirty_mode)
         qof_collection_mark_dirty(coll);
+    qof_book_write_unlock (book);
     return TRUE;
 }
 
@@ -231,11 +347,9 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = g_hash_table_lookup (col->hash_of_entities, guid);
-    return ent;
+    return collection_find_slot (col, guid)->ent;
 }
 
 QofCollection *
@@ -260,10 +374,7 @@ qof_collection_from_glist (QofIdType type, const GList *glist)
 guint
 qof_collection_count (const QofCollection *col)
 {
-    guint c;
-
-    c = g_hash_table_size(col->hash_of_entities);
-    return c;
+    return col->count;
 }
 
 /* =============================================================== */
@@ -319,40 +430,28 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
-{
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
-
-static void
-foreach_cb (gpointer item, gpointer arg)
-{
-    struct _iterate *iter = arg;
-    QofInstance *ent = item;
-
-    iter->fcn (ent, iter->data);
-}
-
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
+    QofInstance **entries;
+    guint i, n = 0, size;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Collection size of %s before is %u", col->e_type, col->count);
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    /* The callback may add or remove entities, so work from a copy. */
+    size = 1u << col->n_bits;
+    entries = g_new (QofInstance *, col->count);
+    for (i = 0; i < size; i++)
+        if (col->slots[i].ent)
+            entries[n++] = col->slots[i].ent;
+    for (i = 0; i < n; i++)
+        cb_func (entries[i], user_data);
+    g_free (entries);
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Collection size of %s after is %u", col->e_type, col->count);
 }
 /* =============================================================== */
@@ -135,7 +135,7 @@ print error message if its bad  */
 
 @param e_type QofIdType
 @param is_dirty gboolean
-@param hash_of_entities GHashTable
+@param slots open-addressing table of the entities, keyed by guid
 @param data gpointer, place where object class can hang arbitrary data
 
 */
@@ -90,6 +90,10 @@ typedef struct QofInstancePrivate
     /*  Keep track of nesting level of begin/end edit calls */
     int editlevel;
 
+    /*  The outermost edit doesn't hold the book's write lock; see
+     *  qof_instance_release_edit_lock() */
+    gboolean edit_released;
+
     /*  In process of being destroyed */
     gboolean do_free;
 
@@ -125,6 +129,9 @@ static void qof_instance_set_property (GObject         *object,
                                        const GValue    *value,
                                        GParamSpec      *pspec);
 static void qof_instance_dispose(GObject*);
+static int qof_instance_edit_locks (const QofInstancePrivate *priv);
+static void qof_instance_edit_locks_changed (QofInstancePrivate *priv,
+                                             int old_locks);
 static void qof_instance_class_init(QofInstanceClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
@@ -269,7 +276,7 @@ qof_instance_init (QofInstance *inst)
 
     priv = GET_PRIVATE(inst);
     priv->book = NULL;
-    inst->kvp_data = kvp_frame_new();
+    inst->kvp_data = NULL;
     priv->last_update.tv_sec = 0;
     priv->last_update.tv_nsec = -1;
     priv->editlevel = 0;
@@ -328,6 +335,13 @@ qof_instance_dispose (GObject *instp)
     QofInstance* inst = QOF_INSTANCE(instp);
 
     priv = GET_PRIVATE(instp);
+    /* Objects are often destroyed from inside their final commit. */
+    if (priv->editlevel > 0 && priv->collection)
+    {
+        int old_locks = qof_instance_edit_locks (priv);
+        priv->editlevel = 0;
+        qof_instance_edit_locks_changed (priv, old_locks);
+    }
     if (!priv->collection)
         return;
     qof_collection_remove_entity(inst);
@@ -385,7 +399,7 @@ qof_instance_get_property (GObject         *object,
         g_value_take_object(value, priv->book);
         break;
     case PROP_KVP_DATA:
-        g_value_set_pointer(value, inst->kvp_data);
+        g_value_set_pointer(value, qof_instance_get_slots(inst));
         break;
     case PROP_LAST_UPDATE:
         g_value_set_pointer(value, &priv->last_update);
@@ -552,11 +566,27 @@ qof_instance_get_book (gconstpointer inst)
     return GET_PRIVATE(inst)->book;
 }
 
+/* An instance being edited holds its book's write lock. */
+static void
+qof_instance_move_to_book (QofInstancePrivate *priv, QofBook *book)
+{
+    int i, locks = qof_instance_edit_locks (priv);
+
+    if (priv->book != book)
+    {
+        for (i = 0; i < locks; i++)
+            qof_book_write_unlock (priv->book);
+        for (i = 0; i < locks; i++)
+            qof_book_write_lock (book);
+    }
+    priv->book = book;
+}
+
 void
 qof_instance_set_book (gconstpointer inst, QofBook *book)
 {
     g_return_if_fail(QOF_IS_INSTANCE(inst));
-    GET_PRIVATE(inst)->book = book;
+    qof_instance_move_to_book (GET_PRIVATE(inst), book);
 }
 
 void
@@ -565,7 +595,7 @@ qof_instance_copy_book (gpointer ptr1, gconstpointer ptr2)
     g_return_if_fail(QOF_IS_INSTANCE(ptr1));
     g_return_if_fail(QOF_IS_INSTANCE(ptr2));
 
-    GET_PRIVATE(ptr1)->book = GET_PRIVATE(ptr2)->book;
+    qof_instance_move_to_book (GET_PRIVATE(ptr1), GET_PRIVATE(ptr2)->book);
 }
 
 gboolean
@@ -585,8 +615,44 @@ qof_instance_books_equal (gconstpointer ptr1, gconstpointer ptr2)
 KvpFrame*
 qof_instance_get_slots (const QofInstance *inst)
 {
+    KvpFrame *frame;
+
     if (!inst) return NULL;
-    return inst->kvp_data;
+    frame = g_atomic_pointer_get (&inst->kvp_data);
+    if (frame) return frame;
+
+    /* Threads reading the book may get here at the same time; the
+     * first to swap its frame in wins. */
+    frame = kvp_frame_new ();
+    if (!g_atomic_pointer_compare_and_exchange (
+                (gpointer *) &((QofInstance *) inst)->kvp_data, NULL, frame))
+    {
+        kvp_frame_delete (frame);
+        frame = g_atomic_pointer_get (&inst->kvp_data);
+    }
+    return frame;
+}
+
+KvpFrame*
+qof_instance_peek_slots (const QofInstance *inst)
+{
+    static KvpFrame *empty_frame = NULL;
+    KvpFrame *frame;
+
+    if (!inst) return NULL;
+    frame = g_atomic_pointer_get (&inst->kvp_data);
+    if (frame) return frame;
+
+    if (g_once_init_enter (&empty_frame))
+        g_once_init_leave (&empty_frame, kvp_frame_new ());
+    return empty_frame;
+}
+
+gboolean
+qof_instance_has_slots (const QofInstance *inst)
+{
+    if (!inst) return FALSE;
+    return !kvp_frame_is_empty (g_atomic_pointer_get (&inst->kvp_data));
 }
 
 void
@@ -613,6 +679,47 @@ qof_instance_set_last_update (QofInstance *inst, Timespec ts)
     GET_PRIVATE(inst)->last_update = ts;
 }
 
+/* The number of write locks an instance holds on its book for its
+ * edits: one for the whole of them, or, once the outermost one has
+ * been released, one for each nested edit. */
+static int
+qof_instance_edit_locks (const QofInstancePrivate *priv)
+{
+    if (priv->editlevel <= 0)
+        return 0;
+    return priv->edit_released ? priv->editlevel - 1 : 1;
+}
+
+/* Take or drop the write locks after the editlevel changed; see
+ * qof_book_write_lock(). */
+static void
+qof_instance_edit_locks_changed (QofInstancePrivate *priv, int old_locks)
+{
+    int locks;
+
+    if (priv->editlevel <= 0)
+        priv->edit_released = FALSE;
+    for (locks = qof_instance_edit_locks (priv); old_locks < locks; old_locks++)
+        qof_book_write_lock (priv->book);
+    for (; old_locks > locks; old_locks--)
+        qof_book_write_unlock (priv->book);
+}
+
+void
+qof_instance_release_edit_lock (gpointer ptr)
+{
+    QofInstancePrivate *priv;
+    int old_locks;
+
+    g_return_if_fail(QOF_IS_INSTANCE(ptr));
+    priv = GET_PRIVATE(ptr);
+    if (priv->editlevel <= 0 || priv->edit_released)
+        return;
+    old_locks = qof_instance_edit_locks (priv);
+    priv->edit_released = TRUE;
+    qof_instance_edit_locks_changed (priv, old_locks);
+}
+
 gint
 qof_instance_get_editlevel (gconstpointer ptr)
 {
@@ -622,20 +729,35 @@ qof_instance_get_editlevel (gconstpointer ptr)
 
 void qof_instance_increase_editlevel (gpointer ptr)
 {
+    QofInstancePrivate *priv;
+    int old_locks;
     g_return_if_fail(QOF_IS_INSTANCE(ptr));
-    GET_PRIVATE(ptr)->editlevel++;
+    priv = GET_PRIVATE(ptr);
+    old_locks = qof_instance_edit_locks (priv);
+    priv->editlevel++;
+    qof_instance_edit_locks_changed (priv, old_locks);
 }
 
 void qof_instance_decrease_editlevel (gpointer ptr)
 {
+    QofInstancePrivate *priv;
+    int old_locks;
     g_return_if_fail(QOF_IS_INSTANCE(ptr));
-    GET_PRIVATE(ptr)->editlevel--;
+    priv = GET_PRIVATE(ptr);
+    old_locks = qof_instance_edit_locks (priv);
+    priv->editlevel--;
+    qof_instance_edit_locks_changed (priv, old_locks);
 }
 
 void qof_instance_reset_editlevel (gpointer ptr)
 {
+    QofInstancePrivate *priv;
+    int old_locks;
     g_return_if_fail(QOF_IS_INSTANCE(ptr));
-    GET_PRIVATE(ptr)->editlevel = 0;
+    priv = GET_PRIVATE(ptr);
+    old_locks = qof_instance_edit_locks (priv);
+    priv->editlevel = 0;
+    qof_instance_edit_locks_changed (priv, old_locks);
 }
 
 int
@@ -955,14 +1077,23 @@ qof_begin_edit (QofInstance *inst)
 {
     QofInstancePrivate *priv;
     QofBackend * be;
+    int old_locks;
 
     if (!inst) return FALSE;
 
     priv = GET_PRIVATE(inst);
+    /* Changing the book while reading it would race the other readers. */
+    if (qof_book_is_reading (priv->book))
+    {
+        PERR ("instance %p edited by a thread reading its book", inst);
+        return FALSE;
+    }
+    old_locks = qof_instance_edit_locks (priv);
     priv->editlevel++;
-    if (1 < priv->editlevel) return FALSE;
     if (0 >= priv->editlevel)
         priv->editlevel = 1;
+    qof_instance_edit_locks_changed (priv, old_locks);
+    if (1 < priv->editlevel) return FALSE;
 
     be = qof_book_get_backend(priv->book);
     if (be && qof_backend_begin_exists(be))
@@ -976,26 +1107,32 @@ qof_begin_edit (QofInstance *inst)
 gboolean qof_commit_edit (QofInstance *inst)
 {
     QofInstancePrivate *priv;
+    int old_locks;
 
     if (!inst) return FALSE;
 
     priv = GET_PRIVATE(inst);
+    if (qof_book_is_reading (priv->book))
+    {
+        PERR ("instance %p committed by a thread reading its book", inst);
+        return FALSE;
+    }
+    old_locks = qof_instance_edit_locks (priv);
     priv->editlevel--;
-    if (0 < priv->editlevel) return FALSE;
-
     if (0 > priv->editlevel)
     {
         PERR ("unbalanced call - resetting (was %d)", priv->editlevel);
         priv->editlevel = 0;
     }
-    return TRUE;
+    qof_instance_edit_locks_changed (priv, old_locks);
+    return 0 >= priv->editlevel;
 }
 
-gboolean
-qof_commit_edit_part2(QofInstance *inst,
-                      void (*on_error)(QofInstance *, QofBackendError),
-                      void (*on_done)(QofInstance *),
-                      void (*on_free)(QofInstance *))
+static gboolean
+qof_commit_edit_part2_locked (QofInstance *inst,
+                              void (*on_error)(QofInstance *, QofBackendError),
+                              void (*on_done)(QofInstance *),
+                              void (*on_free)(QofInstance *))
 {
     QofInstancePrivate *priv;
     QofBackend * be;
@@ -1007,6 +1144,7 @@ qof_commit_edit_part2(QofInstance *inst,
     if (be && qof_backend_commit_exists(be))
     {
         QofBackendError errcode;
+        gint64 start = qof_stats_timer_start ();
 
         /* clear errors */
         do
@@ -1016,6 +1154,7 @@ qof_commit_edit_part2(QofInstance *inst,
         while (ERR_BACKEND_NO_ERR != errcode);
 
         qof_backend_run_commit(be, inst);
+        QOF_STATS_TIME ("qof.backend.commit.usec", start);
         errcode = qof_backend_get_error(be);
         if (ERR_BACKEND_NO_ERR != errcode)
         {
@@ -1050,5 +1189,26 @@ qof_commit_edit_part2(QofInstance *inst,
     return TRUE;
 }
 
+gboolean
+qof_commit_edit_part2(QofInstance *inst,
+                      void (*on_error)(QofInstance *, QofBackendError),
+                      void (*on_done)(QofInstance *),
+                      void (*on_free)(QofInstance *))
+{
+    QofInstancePrivate *priv;
+    QofBook *book;
+    gboolean result;
+
+    priv = GET_PRIVATE(inst);
+
+    /* on_free may destroy inst, so hold on to its book. */
+    book = priv->book;
+    if (!qof_book_write_lock (book))
+        return FALSE;
+    result = qof_commit_edit_part2_locked (inst, on_error, on_done, on_free);
+    qof_book_write_unlock (book);
+    return result;
+}
+
 /* ========================== END OF FILE ======================= */
 
@@ -71,7 +71,8 @@ struct QofInstance_s
     /* kvp_data is a key-value pair database for storing arbirtary
      * information associated with this instance.
      * See src/engine/kvp_doc.txt for a list and description of the
-     * important keys. */
+     * important keys.  It is NULL until qof_instance_get_slots() is
+     * first called, since most instances never have any slots. */
     KvpFrame *kvp_data;
 };
 
@@ -137,14 +138,32 @@ gint qof_instance_guid_compare(const gconstpointer ptr1, const gconstpointer ptr
 //QofIdType qof_instance_get_e_type (const QofInstance *inst);
 //void qof_instance_set_e_type (QofInstance *ent, QofIdType e_type);
 
-/** Return the pointer to the kvp_data */
+/** Return the pointer to the kvp_data, making an empty frame for the
+ *  instance if it doesn't have one yet.  Use this to change the slots. */
 /*@ dependent @*/
 KvpFrame* qof_instance_get_slots (const QofInstance *);
+
+/** Return the pointer to the kvp_data for reading.  An instance that
+ *  has no frame yet gets one empty frame shared by all such instances,
+ *  which must not be changed. */
+/*@ dependent @*/
+KvpFrame* qof_instance_peek_slots (const QofInstance *);
+
+/** Return TRUE if the instance has any slots set. */
+gboolean qof_instance_has_slots (const QofInstance *);
 void qof_instance_set_editlevel(gpointer inst, gint level);
 gint qof_instance_get_editlevel (gconstpointer ptr);
 void qof_instance_increase_editlevel (gpointer ptr);
 void qof_instance_decrease_editlevel (gpointer ptr);
 void qof_instance_reset_editlevel (gpointer ptr);
+/** An open edit holds its book's write lock until it is committed,
+ *  keeping every other thread from reading the book.  Call this for
+ *  an edit kept open across user input, such as a transaction the user
+ *  is still entering, to let them read meanwhile.  From then on only
+ *  the nested begin/commit pairs of the changes made to inst, and its
+ *  final commit, hold the lock, so readers may see inst half edited.
+ *  The outermost edit of inst must be open. */
+void qof_instance_release_edit_lock (gpointer ptr);
 
 /** Compare two instances, based on thier last update times.
  *  Returns a negative, zero or positive value, respectively,
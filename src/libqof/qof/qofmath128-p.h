@@ -29,9 +29,17 @@
 /** @addtogroup Math128
  *  Quick-n-dirty 128-bit integer math lib.   Things seem to mostly
  *  work, and have been tested, but not comprehensively tested.
+ *
+ *  Where the compiler has a native 128-bit integer, mult128() and
+ *  div128() use it.  They give the same answers as the portable
+ *  versions, which are kept for checking them against.
  * @{
  */
 
+#if defined(__SIZEOF_INT128__) && !defined(QOF_MATH128_PORTABLE)
+#define QOF_MATH128_NATIVE 1
+#endif
+
 typedef struct
 {
     guint64 hi;
@@ -75,6 +83,14 @@ qofint128 div128 (qofint128 n, gint64 d);
  */
 gint64 rem128 (qofint128 n, gint64 d);
 
+/** mult128() done in 64-bit pieces, whether or not there is a native
+ *  128-bit integer. */
+qofint128 mult128_portable (gint64 a, gint64 b);
+
+/** div128() done by long division, whether or not there is a native
+ *  128-bit integer. */
+qofint128 div128_portable (qofint128 n, gint64 d);
+
 /** Return the greatest common factor of two 64-bit numbers */
 guint64 gcf64(guint64 num, guint64 denom);
 
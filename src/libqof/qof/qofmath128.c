@@ -39,6 +39,29 @@
  */
 qofint128
 mult128 (gint64 a, gint64 b)
+{
+#ifdef QOF_MATH128_NATIVE
+    qofint128 prod;
+    unsigned __int128 p;
+
+    /* The portable code can't negate G_MININT64; let it have those, so
+     * that the answer is the same either way. */
+    if (G_UNLIKELY (a == G_MININT64 || b == G_MININT64))
+        return mult128_portable (a, b);
+
+    prod.isneg = (0 > a) != (0 > b);
+    p = (unsigned __int128) (guint64) ABS (a) * (guint64) ABS (b);
+    prod.hi = (guint64) (p >> 64);
+    prod.lo = (guint64) p;
+    prod.isbig = prod.hi || (prod.lo >> 63);
+    return prod;
+#else
+    return mult128_portable (a, b);
+#endif
+}
+
+qofint128
+mult128_portable (gint64 a, gint64 b)
 {
     qofint128 prod;
     guint64 a0, a1;
@@ -178,6 +201,39 @@ inc128 (qofint128 a)
  */
 qofint128
 div128 (qofint128 n, gint64 d)
+{
+#ifdef QOF_MATH128_NATIVE
+    qofint128 quotient;
+    unsigned __int128 q;
+    guint64 dd;
+
+    /* Long division by zero gives all ones; keep that too. */
+    if (G_UNLIKELY (0 == d))
+        return div128_portable (n, d);
+
+    quotient.isneg = n.isneg;
+    if (0 > d)
+    {
+        dd = - (guint64) d;
+        quotient.isneg = !quotient.isneg;
+    }
+    else
+    {
+        dd = d;
+    }
+
+    q = (((unsigned __int128) n.hi << 64) | n.lo) / dd;
+    quotient.hi = (guint64) (q >> 64);
+    quotient.lo = (guint64) q;
+    quotient.isbig = (quotient.hi || (quotient.lo >> 63));
+    return quotient;
+#else
+    return div128_portable (n, d);
+#endif
+}
+
+qofint128
+div128_portable (qofint128 n, gint64 d)
 {
     qofint128 quotient;
     int i;
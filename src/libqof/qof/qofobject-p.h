@@ -39,6 +39,8 @@
 /** To be called from within the book */
 void qof_object_book_begin (QofBook *book);
 void qof_object_book_end (QofBook *book);
+/** Called by the outermost qof_book_end_bulk_load() */
+void qof_object_bulk_load_end (QofBook *book);
 
 gboolean qof_object_is_dirty (const QofBook *book);
 void qof_object_mark_clean (QofBook *book);
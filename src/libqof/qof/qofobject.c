@@ -126,6 +126,21 @@ void qof_object_book_end (QofBook *book)
     LEAVE (" ");
 }
 
+void qof_object_bulk_load_end (QofBook *book)
+{
+    GList *l;
+
+    if (!book) return;
+    ENTER (" ");
+    for (l = object_modules; l; l = l->next)
+    {
+        QofObject *obj = l->data;
+        if (obj->bulk_load_end)
+            obj->bulk_load_end (book);
+    }
+    LEAVE (" ");
+}
+
 gboolean
 qof_object_is_dirty (const QofBook *book)
 {
@@ -119,6 +119,37 @@ struct _QofObject
      *  to or later than than 'instance_right'.
      */
     int                 (*version_cmp)(gpointer instance_left, gpointer instance_right);
+
+    /** Optional index lookup used by the query planner.  Given one
+     *  branch of a query, a list of AND-ed QofQueryTerms (see
+     *  qofquery-p.h), find the terms that can be answered from an
+     *  index the object keeps, return in *used_terms the list of terms
+     *  so answered and in *candidates the list of instances in the book
+     *  that satisfy all of them.  Both lists are newly allocated; the
+     *  terms themselves still belong to the query.  Return FALSE, with
+     *  the lists left NULL, if no index applies and the whole collection
+     *  has to be scanned.  May be NULL.
+     */
+    gboolean            (*index_lookup)(QofBook *book, GList *and_terms,
+                                        GList **used_terms,
+                                        GList **candidates);
+
+    /** Optional: call cb on each instance of type dep_type whose
+     *  parameters are read through this instance, e.g. the splits of a
+     *  transaction.  Live queries use this to find the objects to
+     *  recheck when the instance changes.  Return FALSE if the
+     *  dependents of that type can't be found this way.  May be NULL.
+     */
+    gboolean            (*foreach_dependent)(gpointer instance,
+                                             QofIdTypeConst dep_type,
+                                             QofInstanceForeachCB cb,
+                                             gpointer user_data);
+
+    /** Optional: called when a bulk load of the book ends (see
+     *  qof_book_begin_bulk_load()), to do the work the object put off
+     *  while the instances were loaded.  May be NULL.
+     */
+    void                (*bulk_load_end)(QofBook *book);
 };
 
 /* -------------------------------------------------------------- */
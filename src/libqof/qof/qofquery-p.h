@@ -31,6 +31,11 @@ typedef struct _QofQuerySort QofQuerySort;
 
 /* Functions to get Query information */
 int qof_query_get_max_results (const QofQuery *q);
+gboolean qof_query_get_parallel (const QofQuery *q);
+
+/* The number of objects a collection needs before a parallel query
+ * scans it on several threads.  For the test suite. */
+void qof_query_set_parallel_threshold (guint n_objects);
 
 
 /* Functions to get and look at QueryTerms */
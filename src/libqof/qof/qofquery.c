@@ -33,6 +33,7 @@
 #include "qofbackend-p.h"
 #include "qofbook-p.h"
 #include "qofclass-p.h"
+#include "qofevent-p.h"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
 
@@ -90,6 +91,9 @@ struct _QofQuery
     /* The maximum number of results to return */
     gint              max_results;
 
+    /* The terms may be checked on several threads at once */
+    gboolean          parallel;
+
     /* list of books that will be participating in the query */
     GList *           books;
 
@@ -108,8 +112,22 @@ typedef struct _QofQueryCB
     QofQuery *        query;
     GList *           list;
     gint              count;
+    guint             scanned;    /* objects checked, for the statistics */
+
+    /* When only the last max_results of the sorted matches are wanted,
+     * they are collected in this heap of QofQueryMatch instead of list. */
+    GArray *          top;
+    guint             seq;
 } QofQueryCB;
 
+/* A match remembers when it was found so that matches which sort
+ * equal keep the order a (stable) sort of the full list would give. */
+typedef struct
+{
+    gpointer          object;
+    guint             seq;
+} QofQueryMatch;
+
 /* initial_term will be owned by the new Query */
 static void query_init (QofQuery *q, QofQueryTerm *initial_term)
 {
@@ -356,48 +374,62 @@ static int sort_func (const gconstpointer a, const gconstpointer b, const gpoint
  */
 
 static int
-check_object (const QofQuery *q, gpointer object)
+check_term (const QofQueryTerm *qt, gpointer object)
 {
-    const GList     * and_ptr;
-    const GList     * or_ptr;
-    const QofQueryTerm * qt;
-    int       and_terms_ok = 1;
-
-    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    if (qt->param_fcns && qt->pred_fcn)
     {
-        and_terms_ok = 1;
-        for (and_ptr = or_ptr->data; and_ptr; and_ptr = and_ptr->next)
+        const GSList *node;
+        QofParam *param = NULL;
+        gpointer conv_obj = object;
+
+        /* iterate through the conversions */
+        for (node = qt->param_fcns; node; node = node->next)
         {
-            qt = (QofQueryTerm *)(and_ptr->data);
-            if (qt->param_fcns && qt->pred_fcn)
-            {
-                const GSList *node;
-                QofParam *param = NULL;
-                gpointer conv_obj = object;
+            param = node->data;
 
-                /* iterate through the conversions */
-                for (node = qt->param_fcns; node; node = node->next)
-                {
-                    param = node->data;
+            /* The last term is the actual parameter getter */
+            if (!node->next) break;
 
-                    /* The last term is the actual parameter getter */
-                    if (!node->next) break;
+            conv_obj = param->param_getfcn (conv_obj, param);
+        }
 
-                    conv_obj = param->param_getfcn (conv_obj, param);
-                }
+        if (((qt->pred_fcn)(conv_obj, param, qt->pdata)) == qt->invert)
+            return 0;
+    }
+    else
+    {
+        /* XXX: Don't know how to do this conversion -- do we care? */
+    }
+    return 1;
+}
 
-                if (((qt->pred_fcn)(conv_obj, param, qt->pdata)) == qt->invert)
-                {
-                    and_terms_ok = 0;
-                    break;
-                }
-            }
-            else
-            {
-                /* XXX: Don't know how to do this conversion -- do we care? */
-            }
-        }
-        if (and_terms_ok)
+/* Check the AND-terms of one branch of the query, skipping those in
+ * "skip" which are already known to be satisfied. */
+static int
+check_and_terms (const GList *and_terms, const GList *skip, gpointer object)
+{
+    const GList *and_ptr;
+
+    for (and_ptr = and_terms; and_ptr; and_ptr = and_ptr->next)
+    {
+        const QofQueryTerm *qt = and_ptr->data;
+
+        if (skip && g_list_find ((GList *)skip, qt))
+            continue;
+        if (!check_term (qt, object))
+            return 0;
+    }
+    return 1;
+}
+
+static int
+check_object (const QofQuery *q, gpointer object)
+{
+    const GList     * or_ptr;
+
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        if (check_and_terms (or_ptr->data, NULL, object))
         {
             return 1;
         }
@@ -555,17 +587,84 @@ static void compile_terms (QofQuery *q)
     LEAVE (" query=%p", q);
 }
 
+static gint
+match_cmp (gconstpointer a, gconstpointer b, gpointer q)
+{
+    const QofQueryMatch *ma = a, *mb = b;
+    int retval = sort_func (ma->object, mb->object, q);
+
+    if (retval) return retval;
+    return (ma->seq > mb->seq) - (ma->seq < mb->seq);
+}
+
+/* Keep the max_results greatest matches in a min-heap, so that each
+ * new match costs at most O(log max_results) and the rest of them are
+ * never kept at all.  With max_results == 1 this is just a running
+ * maximum. */
+static void
+top_push (QofQueryCB *qcb, gpointer object)
+{
+    GArray *heap = qcb->top;
+    QofQueryMatch match = { object, qcb->seq++ };
+    guint i, child;
+
+    if (heap->len < (guint) qcb->query->max_results)
+    {
+        g_array_append_val (heap, match);
+        for (i = heap->len - 1; i > 0; i = (i - 1) / 2)
+        {
+            QofQueryMatch *parent = &g_array_index (heap, QofQueryMatch, (i - 1) / 2);
+            QofQueryMatch *node = &g_array_index (heap, QofQueryMatch, i);
+            QofQueryMatch tmp;
+
+            if (match_cmp (parent, node, qcb->query) <= 0) break;
+            tmp = *parent;
+            *parent = *node;
+            *node = tmp;
+        }
+        return;
+    }
+
+    /* Full: the new match only goes in if it beats the least one */
+    if (match_cmp (&match, &g_array_index (heap, QofQueryMatch, 0),
+                   qcb->query) <= 0)
+        return;
+
+    for (i = 0; (child = 2 * i + 1) < heap->len; i = child)
+    {
+        if (child + 1 < heap->len &&
+                match_cmp (&g_array_index (heap, QofQueryMatch, child + 1),
+                           &g_array_index (heap, QofQueryMatch, child),
+                           qcb->query) < 0)
+            child++;
+        if (match_cmp (&match, &g_array_index (heap, QofQueryMatch, child),
+                       qcb->query) <= 0)
+            break;
+        g_array_index (heap, QofQueryMatch, i) =
+            g_array_index (heap, QofQueryMatch, child);
+    }
+    g_array_index (heap, QofQueryMatch, i) = match;
+}
+
+static void
+add_match (QofQueryCB *qcb, gpointer object)
+{
+    qcb->count++;
+    if (qcb->top)
+        top_push (qcb, object);
+    else
+        qcb->list = g_list_prepend (qcb->list, object);
+}
+
 static void check_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB *ql = user_data;
 
     if (!object || !ql) return;
 
+    ql->scanned++;
     if (check_object (ql->query, object))
-    {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
-    }
+        add_match (ql, object);
     return;
 }
 
@@ -714,6 +813,8 @@ static GList * qof_query_run_internal (QofQuery *q,
 {
     GList *matching_objects = NULL;
     int        object_count = 0;
+    gboolean   sorted, selected = FALSE;
+    gint64     start = qof_stats_timer_start ();
 
     if (!q) return NULL;
     g_return_val_if_fail (q->search_for, NULL);
@@ -734,6 +835,9 @@ static GList * qof_query_run_internal (QofQuery *q,
     if (qof_log_check (log_module, QOF_LOG_DEBUG))
         qof_query_print (q);
 
+    sorted = (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+              (q->primary_sort.use_default && q->defaultSort));
+
     /* Now run the query over all the objects and save the results */
     {
         QofQueryCB qcb;
@@ -741,11 +845,37 @@ static GList * qof_query_run_internal (QofQuery *q,
         memset (&qcb, 0, sizeof (qcb));
         qcb.query = q;
 
+        /* If only a few of the sorted matches are wanted, don't keep
+         * (and sort) all of them. */
+        if (sorted && q->max_results > 0)
+            qcb.top = g_array_sized_new (FALSE, FALSE, sizeof (QofQueryMatch),
+                                         MIN (q->max_results, 1024));
+
         /* Run the query callback */
         run_cb(&qcb, cb_arg);
 
         matching_objects = qcb.list;
         object_count = qcb.count;
+        QOF_STATS_COUNT ("qof.query.runs", 1);
+        QOF_STATS_RECORD ("qof.query.scanned", qcb.scanned);
+        QOF_STATS_RECORD ("qof.query.matches", qcb.count);
+
+        if (qcb.top)
+        {
+            guint i;
+
+            g_array_sort_with_data (qcb.top, match_cmp, q);
+            for (i = qcb.top->len; i > 0; i--)
+                matching_objects =
+                    g_list_prepend (matching_objects,
+                                    g_array_index (qcb.top, QofQueryMatch,
+                                                   i - 1).object);
+            PINFO ("kept %u of %d matching objects", qcb.top->len,
+                   object_count);
+            object_count = qcb.top->len;
+            g_array_free (qcb.top, TRUE);
+            selected = TRUE;
+        }
     }
     PINFO ("matching objects=%p count=%d", matching_objects, object_count);
 
@@ -753,13 +883,13 @@ static GList * qof_query_run_internal (QofQuery *q,
      * sorted below. However, in the common case, we will be searching
      * in a confined location where the objects are already in order,
      * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
+     * the sorting go much faster.  The selected ones are already in order.
      */
-    matching_objects = g_list_reverse(matching_objects);
+    if (!selected)
+        matching_objects = g_list_reverse(matching_objects);
 
     /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
+    if (sorted && !selected && q->max_results != 0)
     {
         matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
     }
@@ -796,10 +926,210 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_list_free(q->results);
     q->results = matching_objects;
 
+    QOF_STATS_TIME ("qof.query.usec", start);
     LEAVE (" q=%p", q);
     return matching_objects;
 }
 
+/* One OR-branch of a query as planned against the search type's index. */
+typedef struct
+{
+    GList *and_terms;   /* the branch's terms, owned by the query */
+    GList *used_terms;  /* the terms the index already answered */
+    GList *candidates;  /* the objects satisfying used_terms */
+} QofQueryPlan;
+
+static void
+free_query_plans (GList *plans)
+{
+    GList *node;
+
+    for (node = plans; node; node = node->next)
+    {
+        QofQueryPlan *plan = node->data;
+        g_list_free (plan->used_terms);
+        g_list_free (plan->candidates);
+        g_free (plan);
+    }
+    g_list_free (plans);
+}
+
+/* Try to answer the query from the index_lookup of the search type
+ * instead of scanning the whole collection.  Every OR-branch has to
+ * have an indexable term for this to work, otherwise the objects
+ * matching the unindexed branch could be anywhere.  The candidates of
+ * each branch are then checked against that branch's remaining terms
+ * only.  Returns FALSE if the caller has to fall back to a scan. */
+static gboolean
+run_indexed (QofQueryCB *qcb, QofBook *book)
+{
+    const QofQuery *q = qcb->query;
+    const QofObject *obj;
+    GList *plans = NULL, *or_ptr, *node;
+    GHashTable *seen = NULL;
+
+    /* A query without terms matches everything anyway. */
+    if (!q->terms) return FALSE;
+
+    obj = qof_object_lookup (q->search_for);
+    if (!obj || !obj->index_lookup) return FALSE;
+
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        QofQueryPlan *plan = g_new0 (QofQueryPlan, 1);
+
+        plan->and_terms = or_ptr->data;
+        plans = g_list_prepend (plans, plan);
+        if (!obj->index_lookup (book, plan->and_terms, &plan->used_terms,
+                                &plan->candidates))
+        {
+            free_query_plans (plans);
+            return FALSE;
+        }
+    }
+    plans = g_list_reverse (plans);
+
+    /* An object can satisfy more than one branch, but must only be
+     * returned once. */
+    if (plans->next)
+        seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (node = plans; node; node = node->next)
+    {
+        QofQueryPlan *plan = node->data;
+        GList *cand;
+
+        PINFO ("branch %p: %d candidates from the index",
+               plan->and_terms, g_list_length (plan->candidates));
+        for (cand = plan->candidates; cand; cand = cand->next)
+        {
+            gpointer object = cand->data;
+
+            if (seen && g_hash_table_lookup (seen, object))
+                continue;
+            qcb->scanned++;
+            if (!check_and_terms (plan->and_terms, plan->used_terms, object))
+                continue;
+            if (seen)
+                g_hash_table_insert (seen, object, object);
+            add_match (qcb, object);
+        }
+    }
+
+    if (seen)
+        g_hash_table_destroy (seen);
+    free_query_plans (plans);
+    return TRUE;
+}
+
+/* Collections smaller than this are scanned on one thread; starting
+ * the threads costs more than it saves. */
+static guint parallel_threshold = 10000;
+
+void
+qof_query_set_parallel_threshold (guint n_objects)
+{
+    parallel_threshold = n_objects;
+}
+
+/* A slice of the collection, checked on a worker thread. */
+typedef struct
+{
+    const QofQuery *  query;
+    QofBook *         book;
+    gpointer *        objects;
+    guint             n_objects;
+    GPtrArray *       matches;
+} QofQueryChunk;
+
+static void
+check_chunk (gpointer data, gpointer user_data)
+{
+    QofQueryChunk *chunk = data;
+    guint i;
+
+    qof_book_read_lock (chunk->book);
+    for (i = 0; i < chunk->n_objects; i++)
+    {
+        gpointer object = chunk->objects[i];
+        if (object && check_object (chunk->query, object))
+            g_ptr_array_add (chunk->matches, object);
+    }
+    qof_book_read_unlock (chunk->book);
+}
+
+static void
+collect_item_cb (gpointer object, gpointer user_data)
+{
+    g_ptr_array_add (user_data, object);
+}
+
+/* Check the objects of a big collection on all the processors.  Each
+ * worker holds the book's read lock while it checks its chunk, so no
+ * one changes the objects under it, and the parameter getters and
+ * predicates only have to be safe against each other: see
+ * qof_query_set_parallel.  Queries have to ask for this.  The chunks
+ * are merged in order, so the result is the same as that of a scan on
+ * one thread.  Returns FALSE if the caller should do that scan itself,
+ * which it must if it is writing the book, as the workers would wait
+ * for it forever. */
+static gboolean
+run_parallel (QofQueryCB *qcb, QofBook *book)
+{
+    const QofQuery *q = qcb->query;
+    QofCollection *col;
+    GPtrArray *objects;
+    QofQueryChunk *chunks;
+    GThreadPool *pool;
+    guint n_threads, n_chunks, chunk_size, i, j;
+
+    if (!q->parallel || qof_book_is_writing (book)) return FALSE;
+#ifndef HAVE_GLIB_2_32
+    if (!g_thread_supported ()) return FALSE;
+#endif
+    col = qof_book_get_collection (book, q->search_for);
+    if (!col || qof_collection_count (col) < parallel_threshold)
+        return FALSE;
+    n_threads = qof_get_num_processors ();
+    if (n_threads < 2) return FALSE;
+
+    objects = g_ptr_array_sized_new (qof_collection_count (col));
+    qof_object_foreach (q->search_for, book,
+                        (QofInstanceForeachCB) collect_item_cb, objects);
+
+    /* More chunks than threads, so a slow chunk doesn't hold up the rest. */
+    n_chunks = n_threads * 4;
+    chunk_size = (objects->len + n_chunks - 1) / n_chunks;
+    chunks = g_new0 (QofQueryChunk, n_chunks);
+
+    pool = g_thread_pool_new (check_chunk, NULL, n_threads, FALSE, NULL);
+    for (i = 0; i < n_chunks && i * chunk_size < objects->len; i++)
+    {
+        chunks[i].query = q;
+        chunks[i].book = book;
+        chunks[i].objects = objects->pdata + i * chunk_size;
+        chunks[i].n_objects = MIN (chunk_size, objects->len - i * chunk_size);
+        chunks[i].matches = g_ptr_array_new ();
+        g_thread_pool_push (pool, &chunks[i], NULL);
+    }
+    /* Wait for all of them */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    PINFO ("checked %u objects in %u chunks on %u threads",
+           objects->len, i, n_threads);
+    qcb->scanned += objects->len;
+    for (i = 0; i < n_chunks && chunks[i].matches; i++)
+    {
+        for (j = 0; j < chunks[i].matches->len; j++)
+            add_match (qcb, g_ptr_array_index (chunks[i].matches, j));
+        g_ptr_array_free (chunks[i].matches, TRUE);
+    }
+
+    g_free (chunks);
+    g_ptr_array_free (objects, TRUE);
+    return TRUE;
+}
+
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
@@ -824,9 +1154,15 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* And then iterate over the objects that might match, keeping
+         * out the threads that would change them */
+        if (!run_indexed (qcb, book) && !run_parallel (qcb, book))
+        {
+            qof_book_read_lock (book);
+            qof_object_foreach (qcb->query->search_for, book,
+                                (QofInstanceForeachCB) check_item_cb, qcb);
+            qof_book_read_unlock (book);
+        }
     }
 }
 
@@ -870,6 +1206,319 @@ qof_query_last_run (QofQuery *query)
     return query->results;
 }
 
+/* ==================================================================== */
+/* Live queries.  The set of matching objects is kept up to date from
+ * the engine events, so that asking for the results again only costs
+ * a sort of the matches instead of a scan of the books. */
+
+struct _QofQueryLive
+{
+    QofQuery *        source;     /* the caller's query, not owned */
+    QofQuery *        query;      /* our copy of it, compiled */
+    gint              handler_id;
+
+    /* Types other than search_for whose parameters the terms read. */
+    GHashTable *      dependent_types;
+    /* The same for the sorts, and whether they compare whole objects,
+     * which may read anything. */
+    GHashTable *      sort_types;
+    gboolean          sort_opaque;
+
+    GHashTable *      matches;    /* object -> object */
+    GHashTable *      changed;    /* object -> matched at the last run? */
+    GList *           results;
+
+    guint             dropped;    /* qof_event_get_dropped_count () */
+    gboolean          stale;      /* start over from a scan */
+    gboolean          resort;     /* rebuild the results */
+};
+
+static void
+live_set_match (QofQueryLive *live, gpointer object, gboolean match)
+{
+    gboolean was = g_hash_table_lookup (live->matches, object) != NULL;
+
+    if (was == match) return;
+    if (!g_hash_table_lookup_extended (live->changed, object, NULL, NULL))
+        g_hash_table_insert (live->changed, object, GINT_TO_POINTER (was));
+    if (match)
+        g_hash_table_insert (live->matches, object, object);
+    else
+        g_hash_table_remove (live->matches, object);
+    live->resort = TRUE;
+}
+
+static void
+live_check_cb (gpointer object, gpointer user_data)
+{
+    QofQueryLive *live = user_data;
+    live_set_match (live, object, check_object (live->query, object));
+}
+
+static void
+live_event_handler (QofInstance *ent, QofEventId event_type,
+                    gpointer handler_data, gpointer event_data)
+{
+    QofQueryLive *live = handler_data;
+    const QofObject *obj;
+
+    if (!(event_type & (QOF_EVENT_CREATE | QOF_EVENT_MODIFY |
+                        QOF_EVENT_DESTROY | QOF_EVENT_ADD |
+                        QOF_EVENT_REMOVE)))
+        return;
+    if (live->stale ||
+            !g_list_find (live->query->books, qof_instance_get_book (ent)))
+        return;
+
+    /* A change in the matches resorts them through live_set_match; a
+     * change to a match or to an object its sort keys come from may
+     * have moved it. */
+    if (!g_strcmp0 (ent->e_type, live->query->search_for))
+    {
+        if (event_type == QOF_EVENT_DESTROY)
+            live_set_match (live, ent, FALSE);
+        else
+        {
+            live_check_cb (ent, live);
+            if (g_hash_table_lookup (live->matches, ent))
+                live->resort = TRUE;
+        }
+        return;
+    }
+    if (live->sort_opaque ||
+            g_hash_table_lookup (live->sort_types, ent->e_type))
+        live->resort = TRUE;
+
+    if (!g_hash_table_lookup (live->dependent_types, ent->e_type))
+        return;
+
+    /* One of the objects the terms look into changed; recheck the
+     * objects that depend on it, or scan again if we can't tell which
+     * they are. */
+    obj = qof_object_lookup (ent->e_type);
+    if (!obj || !obj->foreach_dependent ||
+            !obj->foreach_dependent (ent, live->query->search_for,
+                                     (QofInstanceForeachCB) live_check_cb,
+                                     live))
+        live->stale = TRUE;
+}
+
+/* Note the types of the objects a parameter path reads from.  The
+ * object a parameter is read from is of the type returned by the
+ * previous parameter in the path.  Its GUID is just its identity,
+ * which can't change. */
+static void
+live_add_path_types (GHashTable *types, const GSList *param_fcns)
+{
+    const GSList *node;
+
+    for (node = param_fcns; node && node->next; node = node->next)
+    {
+        const QofParam *param = node->data;
+        const QofParam *next = node->next->data;
+
+        if (g_strcmp0 (next->param_name, QOF_PARAM_GUID))
+            g_hash_table_insert (types, (gpointer) param->param_type,
+                                 (gpointer) param->param_type);
+    }
+}
+
+static void
+live_add_sort_types (QofQueryLive *live, const QofQuerySort *sort)
+{
+    live_add_path_types (live->sort_types, sort->param_fcns);
+    if (sort->obj_cmp || (sort->use_default && live->query->defaultSort))
+        live->sort_opaque = TRUE;
+}
+
+static void
+live_compile (QofQueryLive *live)
+{
+    GList *or_ptr, *and_ptr;
+
+    if (live->query)
+        qof_query_destroy (live->query);
+    live->query = qof_query_copy (live->source);
+    query_clear_compiles (live->query);
+    compile_terms (live->query);
+    live->query->changed = 0;
+
+    g_hash_table_remove_all (live->dependent_types);
+    for (or_ptr = live->query->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        for (and_ptr = or_ptr->data; and_ptr; and_ptr = and_ptr->next)
+        {
+            QofQueryTerm *qt = and_ptr->data;
+            live_add_path_types (live->dependent_types, qt->param_fcns);
+        }
+    }
+
+    g_hash_table_remove_all (live->sort_types);
+    live->sort_opaque = FALSE;
+    live_add_sort_types (live, &live->query->primary_sort);
+    live_add_sort_types (live, &live->query->secondary_sort);
+    live_add_sort_types (live, &live->query->tertiary_sort);
+}
+
+static void
+live_rescan (QofQueryLive *live)
+{
+    QofQueryCB qcb;
+    GHashTable *old = live->matches;
+    GHashTableIter iter;
+    gpointer object;
+    GList *node;
+
+    live->matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_hash_table_iter_init (&iter, old);
+    while (g_hash_table_iter_next (&iter, &object, NULL))
+        g_hash_table_insert (live->matches, object, object);
+
+    memset (&qcb, 0, sizeof (qcb));
+    qcb.query = live->query;
+    qof_query_run_cb (&qcb, NULL);
+
+    for (node = qcb.list; node; node = node->next)
+    {
+        live_set_match (live, node->data, TRUE);
+        g_hash_table_remove (old, node->data);
+    }
+    g_hash_table_iter_init (&iter, old);
+    while (g_hash_table_iter_next (&iter, &object, NULL))
+        live_set_match (live, object, FALSE);
+
+    g_list_free (qcb.list);
+    g_hash_table_destroy (old);
+
+    live->dropped = qof_event_get_dropped_count ();
+    live->stale = FALSE;
+    live->resort = TRUE;
+}
+
+static gboolean
+live_source_changed (const QofQueryLive *live)
+{
+    const GList *a = live->source->books, *b = live->query->books;
+
+    for (; a && b; a = a->next, b = b->next)
+        if (a->data != b->data) return TRUE;
+    if (a || b) return TRUE;
+
+    return !qof_query_equal (live->source, live->query);
+}
+
+QofQueryLive *
+qof_query_live_new (QofQuery *q)
+{
+    QofQueryLive *live;
+
+    g_return_val_if_fail (q, NULL);
+    g_return_val_if_fail (q->search_for, NULL);
+
+    live = g_new0 (QofQueryLive, 1);
+    live->source = q;
+    live->dependent_types = g_hash_table_new (g_str_hash, g_str_equal);
+    live->sort_types = g_hash_table_new (g_str_hash, g_str_equal);
+    live->matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+    live->changed = g_hash_table_new (g_direct_hash, g_direct_equal);
+    live->stale = TRUE;
+    live->handler_id = qof_event_register_handler (live_event_handler, live);
+
+    live_compile (live);
+    return live;
+}
+
+void
+qof_query_live_destroy (QofQueryLive *live)
+{
+    if (!live) return;
+
+    qof_event_unregister_handler (live->handler_id);
+    qof_query_destroy (live->query);
+    g_hash_table_destroy (live->dependent_types);
+    g_hash_table_destroy (live->sort_types);
+    g_hash_table_destroy (live->matches);
+    g_hash_table_destroy (live->changed);
+    g_list_free (live->results);
+    g_free (live);
+}
+
+GList *
+qof_query_live_run (QofQueryLive *live, GList **added, GList **removed)
+{
+    GHashTableIter iter;
+    gpointer object, was;
+    QofQuery *q;
+
+    if (added) *added = NULL;
+    if (removed) *removed = NULL;
+    g_return_val_if_fail (live, NULL);
+
+    ENTER ("live=%p", live);
+    if (live_source_changed (live))
+    {
+        live_compile (live);
+        live->stale = TRUE;
+    }
+    if (live->dropped != qof_event_get_dropped_count ())
+        live->stale = TRUE;
+    if (live->stale)
+        live_rescan (live);
+
+    /* Hand out the objects whose membership changed since last time. */
+    g_hash_table_iter_init (&iter, live->changed);
+    while (g_hash_table_iter_next (&iter, &object, &was))
+    {
+        gboolean match = g_hash_table_lookup (live->matches, object) != NULL;
+
+        if (match && !GPOINTER_TO_INT (was) && added)
+            *added = g_list_prepend (*added, object);
+        else if (!match && GPOINTER_TO_INT (was) && removed)
+            *removed = g_list_prepend (*removed, object);
+    }
+    g_hash_table_remove_all (live->changed);
+
+    if (!live->resort)
+    {
+        LEAVE ("live=%p unchanged", live);
+        return live->results;
+    }
+
+    /* Sort and crop the matches like qof_query_run does. */
+    q = live->query;
+    g_list_free (live->results);
+    live->results = g_hash_table_get_keys (live->matches);
+    if ((q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+            (q->primary_sort.use_default && q->defaultSort)))
+        live->results = g_list_sort_with_data (live->results, sort_func, q);
+
+    if (q->max_results > -1)
+    {
+        gint count = g_hash_table_size (live->matches);
+
+        if (count > q->max_results)
+        {
+            GList *mptr = g_list_nth (live->results, count - q->max_results);
+
+            if (mptr && mptr->prev)
+            {
+                mptr->prev->next = NULL;
+                mptr->prev = NULL;
+            }
+            g_list_free (live->results);
+            live->results = mptr;
+        }
+    }
+    live->resort = FALSE;
+
+    /* For those who look at qof_query_last_run of the query. */
+    g_list_free (live->source->results);
+    live->source->results = g_list_copy (live->results);
+
+    LEAVE ("live=%p %d matches", live, g_hash_table_size (live->matches));
+    return live->results;
+}
+
 void qof_query_clear (QofQuery *query)
 {
     QofQuery *q2 = qof_query_create ();
@@ -1033,6 +1682,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 0:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel = q->parallel;
         break;
 
         /* This is the DeMorgan expansion for a single AND expression. */
@@ -1040,6 +1690,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 1:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel = q->parallel;
         retval->books = g_list_copy (q->books);
         retval->search_for = q->search_for;
         retval->changed = 1;
@@ -1073,6 +1724,7 @@ QofQuery * qof_query_invert (QofQuery *q)
         retval = qof_query_merge(iright, ileft, QOF_QUERY_AND);
         retval->books          = g_list_copy (q->books);
         retval->max_results    = q->max_results;
+        retval->parallel       = q->parallel;
         retval->search_for     = q->search_for;
         retval->changed        = 1;
 
@@ -1133,6 +1785,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
             g_list_concat(copy_or_terms(q1->terms), copy_or_terms(q2->terms));
         retval->books           = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
         break;
 
@@ -1140,6 +1793,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
         retval = qof_query_create();
         retval->books          = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
 
         /* g_list_append() can take forever, so let's build the list in
@@ -1342,6 +1996,18 @@ int qof_query_get_max_results (const QofQuery *q)
     return q->max_results;
 }
 
+void qof_query_set_parallel (QofQuery *q, gboolean parallel)
+{
+    if (!q) return;
+    q->parallel = parallel;
+}
+
+gboolean qof_query_get_parallel (const QofQuery *q)
+{
+    if (!q) return FALSE;
+    return q->parallel;
+}
+
 QofIdType qof_query_get_search_for (const QofQuery *q)
 {
     if (!q) return NULL;
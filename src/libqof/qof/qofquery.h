@@ -232,6 +232,37 @@ GList * qof_query_last_run (QofQuery *query);
 GList * qof_query_run_subquery (QofQuery *subquery,
                                 const QofQuery* primary_query);
 
+/** A live query keeps the results of a query up to date as objects
+ *  are created, changed and destroyed, by listening to the engine
+ *  events.  Running it again costs a sort of the matching objects
+ *  instead of a scan of all the objects in the books.
+ */
+typedef struct _QofQueryLive QofQueryLive;
+
+/** Create a live query for q.  The live query works on a copy of q,
+ *  but notices when q is changed afterwards and starts over.  q must
+ *  outlive the live query.
+ */
+QofQueryLive * qof_query_live_new (QofQuery *q);
+
+/** Stop following the events and free the live query. */
+void qof_query_live_destroy (QofQueryLive *live);
+
+/** Return the results of the live query, sorted and trimmed like those
+ *  of qof_query_run().  Do NOT free the resulting list; it is managed
+ *  by the live query.
+ *
+ *  If added or removed are not NULL, they are set to newly allocated
+ *  lists of the objects that started or stopped matching since the
+ *  previous call, regardless of max_results.  Removed objects may have
+ *  been destroyed in the meantime and must only be compared against.
+ *
+ *  The results are also what qof_query_last_run() of the original
+ *  query returns afterwards.
+ */
+GList * qof_query_live_run (QofQueryLive *live, GList **added,
+                            GList **removed);
+
 /** Remove all query terms from query.  query matches nothing
  *  after qof_query_clear().
  */
@@ -355,6 +386,19 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
  */
 void qof_query_set_max_results (QofQuery *q, int n);
 
+/** Allow the query to check the objects of a large collection on
+ *  several threads at once.  The threads hold the book's read lock
+ *  (qof_book_read_lock), so the parameter getters and predicates of
+ *  the terms may run at the same time on different objects but never
+ *  alongside a change.  A getter that caches anything in the objects
+ *  it looks at must therefore either leave the cache alone while
+ *  qof_book_is_reading() (as the transaction and split sort keys do)
+ *  or publish it atomically (as qof_instance_get_slots does).  The
+ *  results are the same either way.  A query run by a thread holding
+ *  the book's write lock is checked on that thread alone.
+ */
+void qof_query_set_parallel (QofQuery *q, gboolean parallel);
+
 /** Compare two queries for equality.
  * Query terms are compared each to each.
  * This is a simplistic
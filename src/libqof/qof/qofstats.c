@@ -0,0 +1,284 @@
+/********************************************************************\
+ * qofstats.c -- counters and histograms of what the engine does    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include "qof.h"
+
+static QofLogModule log_module = QOF_MOD_UTIL;
+
+/* Bucket 0 holds the values below 1; bucket i, for i > 0, the values
+ * from 2^(i-1) up to 2^i. */
+#define QOF_STATS_N_BUCKETS 64
+
+struct _QofStat
+{
+    const char *name;
+    QofStatKind kind;
+    gint64 count;
+    gint64 sum;
+    gint64 min;
+    gint64 max;
+    gint64 buckets[QOF_STATS_N_BUCKETS];
+};
+
+static volatile gint stats_enabled = 0;
+
+/* Guards stats_table and every QofStat in it. */
+G_LOCK_DEFINE_STATIC (stats);
+static GHashTable *stats_table = NULL;
+
+void
+qof_stats_set_enabled (gboolean enabled)
+{
+    g_atomic_int_set (&stats_enabled, enabled ? 1 : 0);
+}
+
+gboolean
+qof_stats_is_enabled (void)
+{
+    return g_atomic_int_get (&stats_enabled) != 0;
+}
+
+static QofStat *
+find_stat (const char *name)
+{
+    if (!stats_table)
+        return NULL;
+    return g_hash_table_lookup (stats_table, name);
+}
+
+QofStat *
+qof_stats_lookup (const char *name, QofStatKind kind)
+{
+    QofStat *stat;
+
+    g_return_val_if_fail (name, NULL);
+
+    G_LOCK (stats);
+    if (!stats_table)
+        stats_table = g_hash_table_new (g_str_hash, g_str_equal);
+    stat = find_stat (name);
+    if (!stat)
+    {
+        stat = g_new0 (QofStat, 1);
+        stat->name = name;
+        stat->kind = kind;
+        g_hash_table_insert (stats_table, (gpointer) name, stat);
+    }
+    else if (stat->kind != kind)
+        PWARN ("statistic %s used as both a counter and a histogram", name);
+    G_UNLOCK (stats);
+    return stat;
+}
+
+static guint
+bucket_of (gint64 v)
+{
+    guint i = 0;
+
+    if (v < 1)
+        return 0;
+    while (v)
+    {
+        v >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void
+qof_stats_add (QofStat *stat, gint64 n)
+{
+    if (!stat) return;
+
+    G_LOCK (stats);
+    if (stat->kind == QOF_STAT_COUNTER)
+        stat->count += n;
+    else
+    {
+        if (stat->count == 0 || n < stat->min)
+            stat->min = n;
+        if (stat->count == 0 || n > stat->max)
+            stat->max = n;
+        stat->count++;
+        stat->sum += n;
+        stat->buckets[bucket_of (n)]++;
+    }
+    G_UNLOCK (stats);
+}
+
+gint64
+qof_stats_get_count (const char *name)
+{
+    QofStat *stat;
+    gint64 count = 0;
+
+    G_LOCK (stats);
+    stat = find_stat (name);
+    if (stat)
+        count = stat->count;
+    G_UNLOCK (stats);
+    return count;
+}
+
+gint64
+qof_stats_get_sum (const char *name)
+{
+    QofStat *stat;
+    gint64 sum = 0;
+
+    G_LOCK (stats);
+    stat = find_stat (name);
+    if (stat)
+        sum = stat->kind == QOF_STAT_COUNTER ? stat->count : stat->sum;
+    G_UNLOCK (stats);
+    return sum;
+}
+
+static void
+reset_stat (gpointer key, gpointer value, gpointer data)
+{
+    QofStat *stat = value;
+
+    stat->count = stat->sum = stat->min = stat->max = 0;
+    memset (stat->buckets, 0, sizeof (stat->buckets));
+}
+
+void
+qof_stats_reset (void)
+{
+    G_LOCK (stats);
+    if (stats_table)
+        g_hash_table_foreach (stats_table, reset_stat, NULL);
+    G_UNLOCK (stats);
+}
+
+static void
+write_stat (GString *json, const QofStat *stat)
+{
+    const char *c;
+    gboolean first = TRUE;
+    guint i;
+
+    /* The names are C identifiers with dots in, but be safe. */
+    g_string_append_c (json, '"');
+    for (c = stat->name; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            g_string_append_c (json, '\\');
+        g_string_append_c (json, *c);
+    }
+    g_string_append_printf (json, "\": {\"count\": %" G_GINT64_FORMAT,
+                            stat->count);
+    if (stat->kind == QOF_STAT_HISTOGRAM)
+    {
+        g_string_append_printf (json, ", \"sum\": %" G_GINT64_FORMAT
+                                ", \"min\": %" G_GINT64_FORMAT
+                                ", \"max\": %" G_GINT64_FORMAT
+                                ", \"buckets\": [",
+                                stat->sum, stat->min, stat->max);
+        for (i = 0; i < QOF_STATS_N_BUCKETS; i++)
+        {
+            if (!stat->buckets[i])
+                continue;
+            g_string_append_printf (json, "%s[%" G_GINT64_FORMAT
+                                    ", %" G_GINT64_FORMAT "]",
+                                    first ? "" : ", ",
+                                    i ? G_GINT64_CONSTANT (1) << (i - 1) : 0,
+                                    stat->buckets[i]);
+            first = FALSE;
+        }
+        g_string_append_c (json, ']');
+    }
+    g_string_append_c (json, '}');
+}
+
+gchar *
+qof_stats_to_json (void)
+{
+    GString *json = g_string_new ("{");
+    GList *names = NULL, *node;
+    gboolean first = TRUE;
+
+    G_LOCK (stats);
+    if (stats_table)
+        names = g_list_sort (g_hash_table_get_keys (stats_table),
+                             (GCompareFunc) strcmp);
+    for (node = names; node; node = node->next)
+    {
+        QofStat *stat = g_hash_table_lookup (stats_table, node->data);
+
+        if (!stat->count)
+            continue;
+        g_string_append (json, first ? "\n  " : ",\n  ");
+        write_stat (json, stat);
+        first = FALSE;
+    }
+    G_UNLOCK (stats);
+    g_list_free (names);
+
+    g_string_append (json, first ? "}" : "\n}");
+    return g_string_free (json, FALSE);
+}
+
+gboolean
+qof_stats_dump (const char *filename)
+{
+    gchar *json;
+    FILE *fout;
+    gboolean ok;
+
+    g_return_val_if_fail (filename, FALSE);
+
+    if (!g_strcmp0 (filename, "stdout"))
+        fout = stdout;
+    else if (!g_strcmp0 (filename, "stderr"))
+        fout = stderr;
+    else
+        fout = g_fopen (filename, "w");
+    if (!fout)
+    {
+        PWARN ("can't write statistics to %s", filename);
+        return FALSE;
+    }
+
+    json = qof_stats_to_json ();
+    ok = fputs (json, fout) >= 0 && fputc ('\n', fout) != EOF;
+    g_free (json);
+    if (fout == stdout || fout == stderr)
+        ok = fflush (fout) == 0 && ok;
+    else
+        ok = fclose (fout) == 0 && ok;
+    return ok;
+}
+
+gint64
+qof_stats_timer_start (void)
+{
+    if (!qof_stats_is_enabled ())
+        return 0;
+    return g_get_monotonic_time ();
+}
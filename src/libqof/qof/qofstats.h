@@ -0,0 +1,143 @@
+/********************************************************************\
+ * qofstats.h -- counters and histograms of what the engine does    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @addtogroup Utilities
+    @{ */
+/** @file qofstats.h
+    @brief Counters and histograms of what the engine does
+
+    The engine counts the work it does -- queries run and the objects
+    they look at, events sent and the time their handlers take, balance
+    recomputes, split sorts, backend commits and kvp lookups -- so that
+    one can see where the time goes without turning on debug logging.
+
+    Statistics are always compiled in but start off.  While they are
+    off each call site costs one test of a flag; turn them on with
+    qof_stats_set_enabled().
+
+    Each statistic has a name, such as "qof.query.runs", and is either a
+    counter, which only has a count, or a histogram, which keeps the
+    count, sum, smallest and largest of the values recorded into it and
+    how many of them fell into each power of two.  Times are recorded in
+    microseconds, and their names end in ".usec".
+
+    The statistics may be updated from several threads at once.
+*/
+
+#ifndef QOF_STATS_H
+#define QOF_STATS_H
+
+#include <glib.h>
+
+typedef enum
+{
+    QOF_STAT_COUNTER,
+    QOF_STAT_HISTOGRAM
+} QofStatKind;
+
+typedef struct _QofStat QofStat;
+
+/** Turn the statistics on or off.  Turning them off keeps what has
+ *  been gathered so far. */
+void qof_stats_set_enabled (gboolean enabled);
+gboolean qof_stats_is_enabled (void);
+
+/** Return the statistic with this name, creating it with the given
+ *  kind if there isn't one yet.  The name is not copied, so pass a
+ *  string constant.  Statistics are never freed, so the result may be
+ *  kept for as long as the program runs. */
+QofStat * qof_stats_lookup (const char *name, QofStatKind kind);
+
+/** Add n to a counter, or record n as one value of a histogram. */
+void qof_stats_add (QofStat *stat, gint64 n);
+
+/** Return the count, or the sum of the values recorded, of the named
+ *  statistic; 0 if there is no such statistic. */
+gint64 qof_stats_get_count (const char *name);
+gint64 qof_stats_get_sum (const char *name);
+
+/** Set all the statistics back to zero. */
+void qof_stats_reset (void);
+
+/** Return all the statistics with a non-zero count as a JSON object,
+ *  keyed and sorted by name.  A counter is written as {"count": n}; a
+ *  histogram also has "sum", "min", "max" and "buckets", a list of
+ *  [low, n] pairs giving the number of values from low up to twice low.
+ *  Free the result with g_free(). */
+gchar * qof_stats_to_json (void);
+
+/** Write qof_stats_to_json() to the named file, or to the standard
+ *  output or standard error if filename is "stdout" or "stderr".
+ *  Returns FALSE if the file can't be written. */
+gboolean qof_stats_dump (const char *filename);
+
+/** Return the time to pass to QOF_STATS_TIME(), or 0 if statistics are
+ *  off. */
+gint64 qof_stats_timer_start (void);
+
+/* The macros below keep the statistic from qof_stats_lookup() in a
+ * static for each place they're used.  Threads that get there first
+ * together all look up and store the same statistic, so the pointer
+ * only needs to be read and written atomically. */
+
+/** Add n to the named counter. */
+#define QOF_STATS_COUNT(name, n)                                      \
+    G_STMT_START {                                                    \
+        if (G_UNLIKELY (qof_stats_is_enabled ()))                     \
+        {                                                             \
+            static QofStat *qof_stat_cache_ = NULL;                   \
+            QofStat *qof_stat_ = g_atomic_pointer_get (&qof_stat_cache_); \
+            if (!qof_stat_)                                           \
+            {                                                         \
+                qof_stat_ = qof_stats_lookup ((name), QOF_STAT_COUNTER); \
+                g_atomic_pointer_set (&qof_stat_cache_, qof_stat_);   \
+            }                                                         \
+            qof_stats_add (qof_stat_, (n));                           \
+        }                                                             \
+    } G_STMT_END
+
+/** Record v in the named histogram. */
+#define QOF_STATS_RECORD(name, v)                                     \
+    G_STMT_START {                                                    \
+        if (G_UNLIKELY (qof_stats_is_enabled ()))                     \
+        {                                                             \
+            static QofStat *qof_stat_cache_ = NULL;                   \
+            QofStat *qof_stat_ = g_atomic_pointer_get (&qof_stat_cache_); \
+            if (!qof_stat_)                                           \
+            {                                                         \
+                qof_stat_ = qof_stats_lookup ((name), QOF_STAT_HISTOGRAM); \
+                g_atomic_pointer_set (&qof_stat_cache_, qof_stat_);   \
+            }                                                         \
+            qof_stats_add (qof_stat_, (v));                           \
+        }                                                             \
+    } G_STMT_END
+
+/** Record the microseconds since start, from qof_stats_timer_start(),
+ *  in the named histogram.  Does nothing if start is 0. */
+#define QOF_STATS_TIME(name, start)                                   \
+    G_STMT_START {                                                    \
+        gint64 qof_stat_start_ = (start);                             \
+        if (qof_stat_start_)                                          \
+            QOF_STATS_RECORD ((name), g_get_monotonic_time () - qof_stat_start_); \
+    } G_STMT_END
+
+#endif /* QOF_STATS_H */
+/** @} */
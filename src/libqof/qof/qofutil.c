@@ -31,6 +31,9 @@
 #include <glib.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 #include "qof.h"
 #include "qofbackend-p.h"
 
@@ -208,6 +211,19 @@ gnc_strisnum(const gchar *s)
     return FALSE;
 }
 
+guint
+qof_get_num_processors (void)
+{
+#ifdef HAVE_GLIB_2_36
+    return g_get_num_processors ();
+#elif defined (HAVE_UNISTD_H) && defined (_SC_NPROCESSORS_ONLN)
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (guint) n : 1;
+#else
+    return 1;
+#endif
+}
+
 /* =================================================================== */
 /* Return NULL if the field is whitespace (blank, tab, formfeed etc.)
  * Else return pointer to first non-whitespace character. */
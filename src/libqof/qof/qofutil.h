@@ -206,6 +206,10 @@ gchar * ultostr (gulong val, gint base);
  * whitespace. */
 gboolean gnc_strisnum(const gchar *s);
 
+/** Return the number of processors the program may run on, or 1 if
+ *  that can't be found out. */
+guint qof_get_num_processors (void);
+
 #ifndef HAVE_STPCPY
 #define stpcpy g_stpcpy
 #endif
@@ -215,6 +219,8 @@ gboolean gnc_strisnum(const gchar *s);
  * @param  inst: an instance of QofInstance
  *
  * The caller should use this macro first and then perform any other operations.
+ * Returns FALSE, and begins nothing, for a thread that is reading the
+ * book (see qof_book_read_lock()).
  */
 gboolean qof_begin_edit(QofInstance *inst);
 
@@ -250,7 +256,8 @@ gboolean qof_commit_edit(QofInstance *inst);
  * callback is NULL).  In particular, 'on_done' will not be called for
  * an object which is to be freed.
  *
- * Returns TRUE, if the commit succeeded, FALSE otherwise.
+ * Returns TRUE, if the commit succeeded, FALSE otherwise.  It fails
+ * without calling anything for a thread that is reading the book.
  */
 gboolean
 qof_commit_edit_part2(QofInstance *inst,
@@ -0,0 +1,104 @@
+/***************************************************************************
+ *            bench-gnc-date.c
+ *
+ *  Measure how fast local time conversions are with and without the
+ *  UTC offset cache.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+/* Not run by "make check": run it by hand as
+ *
+ *   TZ=America/New_York bench-gnc-date [number of conversions]
+ *
+ * It times gnc_localtime_r() and gnc_mktime() on times spread over
+ * 1970-2037, first through the offset cache and then through
+ * GDateTime as they worked before the cache.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include "gnc-date.h"
+#include "gnc-date-p.h"
+
+#define N_TIMES 4096
+
+static time64 times[N_TIMES];
+static gint64 checksum;
+
+static void
+report (const char *what, guint n, gdouble seconds)
+{
+    printf ("%-32s %8.3f s  %12.0f per second\n", what, seconds,
+            seconds > 0 ? n / seconds : 0);
+}
+
+static void
+bench_date (guint n, GTimer *timer, const char *label)
+{
+    gchar *what;
+    struct tm tm;
+    guint i;
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        gnc_localtime_r (&times[i % N_TIMES], &tm);
+        checksum += tm.tm_hour;
+    }
+    what = g_strdup_printf ("gnc_localtime_r, %s", label);
+    report (what, n, g_timer_elapsed (timer, NULL));
+    g_free (what);
+
+    gnc_localtime_r (&times[0], &tm);
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        tm.tm_min += 17;
+        checksum += gnc_mktime (&tm);
+    }
+    what = g_strdup_printf ("gnc_mktime, %s", label);
+    report (what, n, g_timer_elapsed (timer, NULL));
+    g_free (what);
+}
+
+int
+main (int argc, char **argv)
+{
+    guint n = argc > 1 ? atoi (argv[1]) : 1000000;
+    Testfuncs *tf = gnc_date_load_funcs ();
+    GTimer *timer;
+    guint i;
+
+    g_random_set_seed (0);
+    for (i = 0; i < N_TIMES; i++)
+        times[i] = g_random_int_range (0, G_MAXINT32);
+    timer = g_timer_new ();
+
+    tf->set_tz_cache_enabled (TRUE);
+    bench_date (n, timer, "cached");
+    tf->set_tz_cache_enabled (FALSE);
+    bench_date (n, timer, "GDateTime");
+    tf->set_tz_cache_enabled (TRUE);
+
+    printf ("checksum %" G_GINT64_FORMAT "\n", checksum);
+    g_timer_destroy (timer);
+    g_slice_free (Testfuncs, tf);
+    return 0;
+}
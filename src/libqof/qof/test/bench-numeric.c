@@ -0,0 +1,208 @@
+/***************************************************************************
+ *            bench-numeric.c
+ *
+ *  Measure how fast the gnc_numeric and 128-bit math kernels are.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+/* Not run by "make check": run it by hand as
+ *
+ *   bench-numeric [number of operations]
+ *
+ * It times mult128() and div128() against their portable versions,
+ * which are the same thing where there is no native 128-bit integer,
+ * and then the arithmetic on amounts in one denominator, the common
+ * case, and on amounts in different denominators.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include "gnc-numeric.h"
+#include "qofmath128-p.h"
+
+#define N_OPERANDS 4096
+
+static gnc_numeric cents[N_OPERANDS];
+static gnc_numeric prices[N_OPERANDS];
+static gint64 checksum;
+
+static void
+report (const char *what, guint n, gdouble seconds)
+{
+    printf ("%-32s %8.3f s  %12.0f per second\n", what, seconds,
+            seconds > 0 ? n / seconds : 0);
+}
+
+static gint64
+random_amount (void)
+{
+    gint64 amount = g_random_int_range (-10000000, 10000000);
+    return amount * g_random_int_range (1, 1000);
+}
+
+static void
+make_operands (void)
+{
+    static const gint64 price_denoms[] = { 1, 100, 1000, 10000, 1000000 };
+    guint i;
+
+    for (i = 0; i < N_OPERANDS; i++)
+    {
+        cents[i] = gnc_numeric_create (random_amount (), 100);
+        prices[i] = gnc_numeric_create (g_random_int_range (1, 100000000),
+                                        price_denoms[i % G_N_ELEMENTS (price_denoms)]);
+    }
+}
+
+static void
+bench_math128 (guint n, GTimer *timer)
+{
+    qofint128 prod;
+    guint i, j;
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        prod = mult128 (cents[j].num, prices[j].num);
+        checksum += prod.lo;
+    }
+    report ("mult128", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        prod = mult128_portable (cents[j].num, prices[j].num);
+        checksum += prod.lo;
+    }
+    report ("mult128_portable", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        prod = div128 (mult128 (cents[j].num, prices[j].num), prices[j].denom);
+        checksum += prod.lo;
+    }
+    report ("div128", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        prod = div128_portable (mult128 (cents[j].num, prices[j].num),
+                                prices[j].denom);
+        checksum += prod.lo;
+    }
+    report ("div128_portable", n, g_timer_elapsed (timer, NULL));
+}
+
+static void
+bench_numeric (guint n, GTimer *timer)
+{
+    gnc_numeric sum = gnc_numeric_zero ();
+    gnc_numeric r;
+    guint i, j;
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+        sum = gnc_numeric_add (sum, cents[i % N_OPERANDS],
+                               GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    report ("add, one denominator", n, g_timer_elapsed (timer, NULL));
+    checksum += sum.num;
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        r = gnc_numeric_add (cents[j], prices[j], 100, GNC_HOW_RND_ROUND_HALF_UP);
+        checksum += r.num;
+    }
+    report ("add, two denominators", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        r = gnc_numeric_mul (cents[j], cents[(j + 1) % N_OPERANDS], 100,
+                             GNC_HOW_RND_ROUND_HALF_UP);
+        checksum += r.num;
+    }
+    report ("mul, one denominator", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        r = gnc_numeric_mul (cents[j], prices[j], 100, GNC_HOW_RND_ROUND_HALF_UP);
+        checksum += r.num;
+    }
+    report ("mul, two denominators", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        r = gnc_numeric_div (cents[j], prices[j], 100, GNC_HOW_RND_ROUND_HALF_UP);
+        checksum += r.num;
+    }
+    report ("div", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        r = gnc_numeric_convert (prices[j], 100, GNC_HOW_RND_ROUND_HALF_UP);
+        checksum += r.num;
+    }
+    report ("convert", n, g_timer_elapsed (timer, NULL));
+
+    g_timer_start (timer);
+    for (i = 0; i < n; i++)
+    {
+        j = i % N_OPERANDS;
+        checksum += gnc_numeric_compare (cents[j], prices[j]);
+    }
+    report ("compare", n, g_timer_elapsed (timer, NULL));
+}
+
+int
+main (int argc, char **argv)
+{
+    guint n = argc > 1 ? atoi (argv[1]) : 10000000;
+    GTimer *timer;
+
+    g_random_set_seed (0);
+    make_operands ();
+    timer = g_timer_new ();
+#ifdef QOF_MATH128_NATIVE
+    printf ("native 128-bit integer: yes\n");
+#else
+    printf ("native 128-bit integer: no\n");
+#endif
+
+    bench_math128 (n, timer);
+    bench_numeric (n, timer);
+
+    printf ("checksum %" G_GINT64_FORMAT "\n", checksum);
+    g_timer_destroy (timer);
+    return 0;
+}
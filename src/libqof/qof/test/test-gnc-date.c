@@ -23,6 +23,7 @@
  ********************************************************************/
 #include <config.h>
 #include <string.h>
+#include <time.h>
 #include <glib.h>
 #include <unittest-support.h>
 /* Add specific headers for this class */
@@ -241,6 +242,102 @@ test_gnc_mktime (void)
     }
 }
 
+/* gnc_localtime_r and gnc_mktime use a cache of the local zone's
+ * offsets for the years it covers; check that they come out the same
+ * as with GDateTime throughout them, and at every quarter hour of a
+ * year with DST changes. */
+static void
+assert_tm_equal (const struct tm *a, const struct tm *b)
+{
+    g_assert_cmpint (a->tm_sec, ==, b->tm_sec);
+    g_assert_cmpint (a->tm_min, ==, b->tm_min);
+    g_assert_cmpint (a->tm_hour, ==, b->tm_hour);
+    g_assert_cmpint (a->tm_mday, ==, b->tm_mday);
+    g_assert_cmpint (a->tm_mon, ==, b->tm_mon);
+    g_assert_cmpint (a->tm_year, ==, b->tm_year);
+    g_assert_cmpint (a->tm_wday, ==, b->tm_wday);
+    g_assert_cmpint (a->tm_yday, ==, b->tm_yday);
+    g_assert_cmpint (a->tm_isdst, ==, b->tm_isdst);
+#ifdef HAVE_STRUCT_TM_GMTOFF
+    g_assert_cmpint (a->tm_gmtoff, ==, b->tm_gmtoff);
+#endif
+}
+
+static void
+check_tm_cache (Testfuncs *tf, time64 secs)
+{
+    struct tm cached, uncached, mk_cached, mk_uncached;
+    time64 mk_secs;
+
+    tf->set_tz_cache_enabled (TRUE);
+    g_assert (gnc_localtime_r (&secs, &cached) != NULL);
+    tf->set_tz_cache_enabled (FALSE);
+    g_assert (gnc_localtime_r (&secs, &uncached) != NULL);
+    assert_tm_equal (&cached, &uncached);
+
+    mk_cached = mk_uncached = cached;
+    mk_cached.tm_isdst = mk_uncached.tm_isdst = -1;
+    mk_secs = gnc_mktime (&mk_uncached);
+    tf->set_tz_cache_enabled (TRUE);
+    g_assert_cmpint (gnc_mktime (&mk_cached), ==, mk_secs);
+    assert_tm_equal (&mk_cached, &mk_uncached);
+}
+
+static void
+test_gnc_tm_cache (void)
+{
+    Testfuncs *tf = gnc_date_load_funcs ();
+    time64 secs;
+
+    for (secs = -2208988800LL; secs < 7258118400LL; secs += 86400 + 3607)
+        check_tm_cache (tf, secs);
+    for (secs = 1356998400LL; secs < 1388534400LL; secs += 900)
+        check_tm_cache (tf, secs);
+
+    tf->set_tz_cache_enabled (TRUE);
+    g_slice_free (Testfuncs, tf);
+}
+
+/* The days around each change of offset in 2013, in fixed zones so
+ * that the changes are tested wherever the test runs: New York moves
+ * by an hour, Lord Howe Island by half an hour. */
+static void
+test_gnc_tm_cache_dst (void)
+{
+    const gchar *zones[] = { "America/New_York", "Australia/Lord_Howe" };
+    const time64 days[] =
+    {
+        1362787200LL, /* 2013-03-09 */
+        1365206400LL, /* 2013-04-06 */
+        1380931200LL, /* 2013-10-05 */
+        1383350400LL, /* 2013-11-02 */
+    };
+    Testfuncs *tf = gnc_date_load_funcs ();
+    gchar *old_tz = g_strdup (g_getenv ("TZ"));
+    guint i, j;
+    time64 secs;
+
+    for (i = 0; i < G_N_ELEMENTS (zones); i++)
+    {
+        g_setenv ("TZ", zones[i], TRUE);
+        tzset ();
+        tf->reset_tz_cache ();
+        for (j = 0; j < G_N_ELEMENTS (days); j++)
+            for (secs = days[j]; secs < days[j] + 2 * 86400; secs += 300)
+                check_tm_cache (tf, secs);
+    }
+
+    if (old_tz)
+        g_setenv ("TZ", old_tz, TRUE);
+    else
+        g_unsetenv ("TZ");
+    tzset ();
+    tf->reset_tz_cache ();
+    tf->set_tz_cache_enabled (TRUE);
+    g_free (old_tz);
+    g_slice_free (Testfuncs, tf);
+}
+
 /* In addition to computing a time offset from a struct tm, mktime is
  * supposed to normalize struct tms with out-of-range values. This
  * second test exercises that facility in gnc_mktime.
@@ -2375,6 +2472,8 @@ test_suite_gnc_date (void)
     GNC_TEST_ADD_FUNC (suitename, "gnc gmtime", test_gnc_gmtime);
     GNC_TEST_ADD_FUNC (suitename, "gnc mktime", test_gnc_mktime);
     GNC_TEST_ADD_FUNC (suitename, "gnc mktime normalization", test_gnc_mktime_normalization);
+    GNC_TEST_ADD_FUNC (suitename, "gnc localtime and mktime cache", test_gnc_tm_cache);
+    GNC_TEST_ADD_FUNC (suitename, "gnc localtime and mktime cache across DST", test_gnc_tm_cache_dst);
     GNC_TEST_ADD_FUNC (suitename, "gnc ctime", test_gnc_ctime);
     GNC_TEST_ADD_FUNC (suitename, "gnc time", test_gnc_time);
 
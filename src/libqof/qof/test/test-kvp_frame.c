@@ -877,6 +877,119 @@ test_kvp_value_new_foo_nc( void )
     kvp_value_delete( frame_value_nc );
 }
 
+static void
+test_kvp_frame_many_slots_helper( const char *key, KvpValue *value, gpointer data )
+{
+    const char **last_key = data;
+
+    if ( *last_key )
+        g_assert_cmpint( strcmp( *last_key, key ), <, 0 );
+    *last_key = key;
+}
+
+static void
+test_kvp_frame_many_slots( Fixture *fixture, gconstpointer pData )
+{
+    KvpFrame *copy;
+    const char *last_key = NULL;
+    gchar *key;
+    gint i;
+
+    g_test_message( "Test frames outgrowing the slot array" );
+    /* Insert in descending order to exercise the sorted insert */
+    for ( i = 19; i >= 0; i-- )
+    {
+        key = g_strdup_printf( "key%02d", i );
+        kvp_frame_set_gint64( fixture->frame, key, i );
+        g_free( key );
+        g_assert_cmpint( kvp_frame_get_gint64( fixture->frame, "key19" ), == , 19 );
+    }
+    for ( i = 0; i < 20; i++ )
+    {
+        key = g_strdup_printf( "key%02d", i );
+        g_assert_cmpint( kvp_frame_get_gint64( fixture->frame, key ), == , i );
+        g_free( key );
+    }
+    kvp_frame_for_each_slot_sorted( fixture->frame,
+                                    test_kvp_frame_many_slots_helper,
+                                    &last_key );
+    g_assert_cmpstr( last_key, == , "key19" );
+
+    copy = kvp_frame_copy( fixture->frame );
+    g_assert_cmpint( kvp_frame_compare( fixture->frame, copy ), == , 0 );
+    kvp_frame_delete( copy );
+
+    g_test_message( "Test removing slots from a small frame" );
+    copy = kvp_frame_new();
+    kvp_frame_set_gint64( copy, "b", 2 );
+    kvp_frame_set_gint64( copy, "a", 1 );
+    kvp_frame_set_gint64( copy, "c", 3 );
+    kvp_frame_set_slot( copy, "b", NULL );
+    g_assert( kvp_frame_get_slot( copy, "b" ) == NULL );
+    g_assert_cmpint( kvp_frame_get_gint64( copy, "a" ), == , 1 );
+    g_assert_cmpint( kvp_frame_get_gint64( copy, "c" ), == , 3 );
+    kvp_frame_set_slot( copy, "a", NULL );
+    kvp_frame_set_slot( copy, "c", NULL );
+    /* A frame that has been used isn't empty any more */
+    g_assert( !kvp_frame_is_empty( copy ) );
+    last_key = NULL;
+    kvp_frame_for_each_slot_sorted( copy, test_kvp_frame_many_slots_helper,
+                                    &last_key );
+    g_assert( last_key == NULL );
+    kvp_frame_delete( copy );
+}
+
+static void
+test_kvp_path( Fixture *fixture, gconstpointer pData )
+{
+    static gsize static_path = 0;
+    const KvpPath *spath;
+    KvpPath *path, *keys_path;
+    KvpValue *value;
+    KvpFrame *result;
+
+    g_test_message( "Test paths that can't be parsed" );
+    g_assert( kvp_path_new( NULL ) == NULL );
+    g_assert( kvp_path_new( "" ) == NULL );
+    g_assert( kvp_path_new( "a/b/" ) == NULL );
+
+    g_test_message( "Test setting and getting through a parsed path" );
+    path = kvp_path_new( "//a//b/c" );
+    g_assert( path );
+    value = kvp_value_new_gint64( 42 );
+    result = kvp_frame_set_path_value( fixture->frame, path, value );
+    kvp_value_delete( value );
+    g_assert( result );
+    g_assert( result == kvp_frame_get_frame( fixture->frame, "a/b" ) );
+    g_assert_cmpint( kvp_frame_get_gint64( fixture->frame, "a/b/c" ), == , 42 );
+    g_assert_cmpint( kvp_value_get_gint64( kvp_frame_get_path_value( fixture->frame, path ) ), == , 42 );
+
+    g_test_message( "Test a path made of keys" );
+    keys_path = kvp_path_new_keys( "a", "b", "c", NULL );
+    g_assert_cmpint( kvp_value_get_gint64( kvp_frame_get_path_value( fixture->frame, keys_path ) ), == , 42 );
+    kvp_frame_set_path_value_nc( fixture->frame, keys_path, kvp_value_new_gint64( 23 ) );
+    g_assert_cmpint( kvp_value_get_gint64( kvp_frame_get_path_value( fixture->frame, path ) ), == , 23 );
+    kvp_path_free( keys_path );
+
+    g_test_message( "Test a static path" );
+    spath = kvp_path_get_static( &static_path, "a/b/c" );
+    g_assert( spath );
+    g_assert( kvp_path_get_static( &static_path, "a/b/c" ) == spath );
+    g_assert_cmpint( kvp_value_get_gint64( kvp_frame_get_path_value( fixture->frame, spath ) ), == , 23 );
+
+    g_test_message( "Test missing paths and removing through a path" );
+    keys_path = kvp_path_new_keys( "a", "x", NULL );
+    g_assert( kvp_frame_get_path_value( fixture->frame, keys_path ) == NULL );
+    kvp_path_free( keys_path );
+    keys_path = kvp_path_new_keys( "a", "b", "c", "d", NULL );
+    g_assert( kvp_frame_get_path_value( fixture->frame, keys_path ) == NULL );
+    kvp_path_free( keys_path );
+    g_assert( kvp_frame_set_path_value( fixture->frame, path, NULL ) );
+    g_assert( kvp_frame_get_path_value( fixture->frame, path ) == NULL );
+    g_assert( kvp_frame_get_path_value( NULL, path ) == NULL );
+    kvp_path_free( path );
+}
+
 static void
 test_kvp_frame_compare( Fixture *fixture, gconstpointer pData )
 {
@@ -1134,7 +1247,7 @@ test_kvp_frame_set_slot_path( Fixture *fixture, gconstpointer pData )
     g_assert( output_value );
     g_assert( input_value != output_value ); /* copied */
     g_assert_cmpint( kvp_value_compare( output_value, input_value ), == , 0 ); /* old value removed */
-    frame_hash = kvp_frame_get_hash( fixture->frame );
+    frame_hash = kvp_frame_convert_to_hash( fixture->frame );
     g_assert( frame_hash );
     g_assert_cmpint( g_hash_table_size( frame_hash ), == , 1 ); /* be sure it was replaced */
     kvp_value_delete( input_value );
@@ -1189,7 +1302,7 @@ test_kvp_frame_set_slot_path_gslist( Fixture *fixture, gconstpointer pData )
     g_assert( output_value );
     g_assert( input_value != output_value ); /* copied */
     g_assert_cmpint( kvp_value_compare( output_value, input_value ), == , 0 ); /* old value removed */
-    frame_hash = kvp_frame_get_hash( fixture->frame );
+    frame_hash = kvp_frame_convert_to_hash( fixture->frame );
     g_assert( frame_hash );
     g_assert_cmpint( g_hash_table_size( frame_hash ), == , 1 ); /* be sure it was replaced */
     kvp_value_delete( input_value );
@@ -1234,7 +1347,10 @@ test_kvp_frame_replace_slot_nc( Fixture *fixture, gconstpointer pData )
     orig_value = kvp_value_new_gint64( 2 );
     kvp_frame_set_slot( fixture->frame, "test", orig_value );
     g_assert( !kvp_frame_is_empty( fixture->frame ) );
-    frame_hash = kvp_frame_get_hash( fixture->frame );
+    /* Reading doesn't move a small frame's slots into a hash table */
+    g_assert( kvp_frame_get_hash( fixture->frame ) == NULL );
+    frame_hash = kvp_frame_convert_to_hash( fixture->frame );
+    g_assert( kvp_frame_get_hash( fixture->frame ) == frame_hash );
     g_assert( frame_hash );
     g_assert_cmpint( g_hash_table_size( frame_hash ), == , 1 );
     copy_value = g_hash_table_lookup( frame_hash, "test" );
@@ -1244,7 +1360,7 @@ test_kvp_frame_replace_slot_nc( Fixture *fixture, gconstpointer pData )
     g_test_message( "Test when value is replaced" );
     orig_value2 = kvp_value_new_gint64( 5 );
     kvp_frame_set_slot( fixture->frame, "test", orig_value2 );
-    frame_hash = kvp_frame_get_hash( fixture->frame );
+    frame_hash = kvp_frame_convert_to_hash( fixture->frame );
     g_assert( frame_hash );
     g_assert_cmpint( g_hash_table_size( frame_hash ), == , 1 );
     copy_value = g_hash_table_lookup( frame_hash, "test" );
@@ -1471,6 +1587,8 @@ test_suite_kvp_frame( void )
     GNC_TEST_ADD_FUNC( suitename, "kvp value compare", test_kvp_value_compare );
     GNC_TEST_ADD_FUNC( suitename, "kvp value new foo no copy", test_kvp_value_new_foo_nc );
     GNC_TEST_ADD( suitename, "kvp frame compare", Fixture, NULL, setup, test_kvp_frame_compare, teardown );
+    GNC_TEST_ADD( suitename, "kvp frame many slots", Fixture, NULL, setup, test_kvp_frame_many_slots, teardown );
+    GNC_TEST_ADD( suitename, "kvp path", Fixture, NULL, setup, test_kvp_path, teardown );
     GNC_TEST_ADD_FUNC( suitename, "binary to string", test_binary_to_string );
     GNC_TEST_ADD_FUNC( suitename, "kvp value to string", test_kvp_value_to_string );
     GNC_TEST_ADD( suitename, "kvp frame to string", Fixture, NULL, setup, test_kvp_frame_to_string, teardown );
@@ -77,8 +77,95 @@ test_qof_string_cache( void )
     g_assert(str1_1 != str1_4);
 }
 
+static void
+test_qof_string_cache_stats( void )
+{
+    QofStringCacheStats before, after;
+    gchar* str1;
+    gchar* str2;
+
+    qof_string_cache_get_stats(&before);
+    str1 = qof_string_cache_insert("stats string");
+    str2 = qof_string_cache_insert("stats string");
+    qof_string_cache_get_stats(&after);
+    g_assert(str1 == str2);
+    g_assert_cmpuint(after.inserts - before.inserts, ==, 2);
+    g_assert_cmpuint(after.hits - before.hits, ==, 1);
+    g_assert_cmpuint(after.bytes_saved - before.bytes_saved, ==,
+                     strlen("stats string") + 1);
+    g_assert_cmpuint(after.n_strings - before.n_strings, ==, 1);
+
+    qof_string_cache_remove(str2);
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.bytes_saved, ==, before.bytes_saved);
+    qof_string_cache_remove(str1);
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.n_strings, ==, before.n_strings);
+}
+
+#define N_THREADS 4
+#define N_STRINGS 1000
+
+static gpointer
+string_cache_thread( gpointer data )
+{
+    gchar **cached = data;
+    gchar str[32];
+    int i;
+
+    for (i = 0; i < N_STRINGS; i++)
+    {
+        g_snprintf(str, sizeof(str), "thread string %d", i);
+        cached[i] = qof_string_cache_insert(str);
+    }
+    return NULL;
+}
+
+static void
+test_qof_string_cache_threads( void )
+{
+    /* Threads interning the same strings must all get the same
+     * copies, with every reference counted. */
+    gchar *cached[N_THREADS][N_STRINGS];
+    GThread *threads[N_THREADS];
+    QofStringCacheStats before, after;
+    int i, j;
+
+#ifndef HAVE_GLIB_2_32
+    if (!g_thread_supported())
+        return;
+#endif
+    qof_string_cache_get_stats(&before);
+    for (i = 0; i < N_THREADS; i++)
+#ifdef HAVE_GLIB_2_32
+        threads[i] = g_thread_new("string-cache", string_cache_thread,
+                                  cached[i]);
+#else
+        threads[i] = g_thread_create(string_cache_thread, cached[i],
+                                     TRUE, NULL);
+#endif
+    for (i = 0; i < N_THREADS; i++)
+        g_thread_join(threads[i]);
+
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.n_strings - before.n_strings, ==, N_STRINGS);
+    g_assert_cmpuint(after.hits - before.hits, ==,
+                     (N_THREADS - 1) * N_STRINGS);
+    for (i = 0; i < N_STRINGS; i++)
+        for (j = 1; j < N_THREADS; j++)
+            g_assert(cached[j][i] == cached[0][i]);
+
+    for (i = 0; i < N_THREADS; i++)
+        for (j = 0; j < N_STRINGS; j++)
+            qof_string_cache_remove(cached[i][j]);
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.n_strings, ==, before.n_strings);
+}
+
 void
 test_suite_qof_string_cache ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "string-cache", test_qof_string_cache);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache stats", test_qof_string_cache_stats);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache threads", test_qof_string_cache_threads);
 }
@@ -32,6 +32,8 @@ extern void test_suite_qofobject();
 extern void test_suite_qofsession();
 extern void test_suite_gnc_date();
 extern void test_suite_qof_string_cache();
+extern void test_suite_qofevent();
+extern void test_suite_qofstats();
 
 int
 main (int   argc,
@@ -50,6 +52,8 @@ main (int   argc,
     test_suite_qofsession();
     test_suite_gnc_date();
     test_suite_qof_string_cache();
+    test_suite_qofevent();
+    test_suite_qofstats();
 
     return g_test_run( );
 }
@@ -753,6 +753,74 @@ test_book_new_destroy( void )
     g_assert( test_struct.called );
 }
 
+static void
+test_book_read_write_lock( Fixture *fixture, gconstpointer pData )
+{
+    QofBook *book = fixture->book;
+
+    g_assert( !qof_book_is_reading( book ) );
+    g_assert( !qof_book_has_readers( book ) );
+
+    g_test_message( "Testing read locks" );
+    qof_book_read_lock( book );
+    g_assert( qof_book_is_reading( book ) );
+    g_assert( qof_book_has_readers( book ) );
+    qof_book_read_unlock( book );
+    g_assert( !qof_book_is_reading( book ) );
+    g_assert( !qof_book_has_readers( book ) );
+
+    g_test_message( "Testing that the writer may lock again and read" );
+    qof_book_write_lock( book );
+    qof_book_write_lock( book );
+    qof_book_read_lock( book );
+    g_assert( !qof_book_is_reading( book ) );
+    g_assert( !qof_book_has_readers( book ) );
+    qof_book_read_unlock( book );
+    qof_book_write_unlock( book );
+    qof_book_write_unlock( book );
+
+    g_test_message( "Testing that the writer keeps its read lock" );
+    qof_book_write_lock( book );
+    qof_book_read_lock( book );
+    qof_book_write_unlock( book );
+    g_assert( qof_book_is_reading( book ) );
+    g_assert( qof_book_has_readers( book ) );
+    qof_book_read_unlock( book );
+    g_assert( !qof_book_has_readers( book ) );
+
+    g_test_message( "Testing that edits lock the book for writing" );
+    qof_book_begin_edit( book );
+    qof_book_read_lock( book );
+    g_assert( !qof_book_is_reading( book ) );
+    qof_book_read_unlock( book );
+    qof_book_commit_edit( book );
+    qof_book_read_lock( book );
+    g_assert( qof_book_is_reading( book ) );
+    qof_book_read_unlock( book );
+
+    g_test_message( "Testing that a released edit only locks its changes" );
+    qof_book_begin_edit( book );
+    qof_instance_release_edit_lock( book );
+    g_assert( !qof_book_is_writing( book ) );
+    qof_book_read_lock( book );
+    g_assert( qof_book_is_reading( book ) );
+    qof_book_read_unlock( book );
+    qof_book_begin_edit( book );
+    g_assert( qof_book_is_writing( book ) );
+    qof_book_commit_edit( book );
+    g_assert( !qof_book_is_writing( book ) );
+    g_assert_cmpint( qof_instance_get_editlevel( book ), ==, 1 );
+    qof_book_commit_edit( book );
+    g_assert( !qof_book_is_writing( book ) );
+    g_assert_cmpint( qof_instance_get_editlevel( book ), ==, 0 );
+
+    g_test_message( "Testing that the next edit holds the lock again" );
+    qof_book_begin_edit( book );
+    g_assert( qof_book_is_writing( book ) );
+    qof_book_commit_edit( book );
+    g_assert( !qof_book_is_writing( book ) );
+}
+
 void
 test_suite_qofbook ( void )
 {
@@ -779,4 +847,5 @@ test_suite_qofbook ( void )
     GNC_TEST_ADD_FUNC( suitename, "set data finalizers", test_book_set_data_fin );
     GNC_TEST_ADD( suitename, "mark closed", Fixture, NULL, setup, test_book_mark_closed, teardown );
     GNC_TEST_ADD_FUNC( suitename, "book new and destroy", test_book_new_destroy );
+    GNC_TEST_ADD( suitename, "read and write locks", Fixture, NULL, setup, test_book_read_write_lock, teardown );
 }
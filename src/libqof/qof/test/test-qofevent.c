@@ -0,0 +1,209 @@
+/********************************************************************
+ * test-qofevent.c: GLib g_test test suite for qofevent.c.          *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+#include "config.h"
+#include <glib.h>
+#include <unittest-support.h>
+#include "../qof.h"
+#include "../qofevent-p.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+typedef struct
+{
+    QofBook *book;
+    QofInstance *foo1;
+    QofInstance *foo2;
+    QofInstance *bar;
+} Fixture;
+
+typedef struct
+{
+    guint calls;
+    QofInstance *last_entity;
+    QofEventId last_event;
+    gpointer last_data;
+    QofEventId all_events;
+} HandlerRecord;
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->book = qof_book_new();
+    fixture->foo1 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    qof_instance_init_data( fixture->foo1, "foo", fixture->book );
+    fixture->foo2 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    qof_instance_init_data( fixture->foo2, "foo", fixture->book );
+    fixture->bar = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    qof_instance_init_data( fixture->bar, "bar", fixture->book );
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    if ( fixture->foo1 ) g_object_unref( fixture->foo1 );
+    if ( fixture->foo2 ) g_object_unref( fixture->foo2 );
+    g_object_unref( fixture->bar );
+    qof_book_destroy( fixture->book );
+}
+
+static void
+record_handler( QofInstance *ent, QofEventId event_type,
+                gpointer handler_data, gpointer event_data )
+{
+    HandlerRecord *rec = handler_data;
+
+    rec->calls++;
+    rec->last_entity = ent;
+    rec->last_event = event_type;
+    rec->last_data = event_data;
+    rec->all_events |= event_type;
+}
+
+static void
+test_filtered_dispatch( Fixture *fixture, gconstpointer pData )
+{
+    HandlerRecord all = { 0 }, foo = { 0 };
+    gint all_id = qof_event_register_handler( record_handler, &all );
+    gint foo_id = qof_event_register_filtered_handler( record_handler, &foo,
+                  "foo", QOF_EVENT_MODIFY | QOF_EVENT_DESTROY );
+
+    g_test_message( "Test that filtered handlers only get what they asked for" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, &all );
+    g_assert_cmpuint( all.calls, == , 1 );
+    g_assert_cmpuint( foo.calls, == , 1 );
+    g_assert( foo.last_entity == fixture->foo1 );
+    g_assert( foo.last_data == &all );
+    qof_event_gen( fixture->foo1, QOF_EVENT_ADD, NULL );
+    qof_event_gen( fixture->bar, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( all.calls, == , 3 );
+    g_assert_cmpuint( foo.calls, == , 1 );
+
+    qof_event_unregister_handler( foo_id );
+    qof_event_unregister_handler( all_id );
+    qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpuint( all.calls, == , 3 );
+    g_assert_cmpuint( foo.calls, == , 1 );
+}
+
+static void
+test_coalesced_events( Fixture *fixture, gconstpointer pData )
+{
+    HandlerRecord all = { 0 }, foo = { 0 }, empty = { 0 };
+    gint all_id = qof_event_register_handler( record_handler, &all );
+    gint foo_id = qof_event_register_filtered_handler( record_handler, &foo,
+                  "foo", QOF_EVENT_ALL );
+    guint dropped = qof_event_get_dropped_count();
+    int i;
+
+    g_test_message( "Test that events are held and merged while suspended" );
+    qof_event_suspend();
+    for ( i = 0; i < 10; i++ )
+        qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->foo2, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->foo2, QOF_EVENT_CREATE, &foo );
+    qof_event_gen( fixture->foo1, QOF_EVENT_ADD, &foo );
+    qof_event_gen( fixture->bar, QOF_EVENT_MODIFY, NULL );
+    /* The events with data can't be held, as the data may not last */
+    g_assert_cmpuint( foo.calls, == , 2 );
+    g_assert( foo.last_entity == fixture->foo1 );
+    g_assert_cmpint( foo.last_event, == , QOF_EVENT_ADD );
+    g_assert( foo.last_data == &foo );
+    g_assert_cmpuint( qof_event_get_dropped_count() - dropped, == , 14 );
+
+    qof_event_suspend();
+    qof_event_resume();
+    g_assert_cmpuint( foo.calls, == , 2 );
+    qof_event_resume();
+
+    g_assert_cmpuint( all.calls, == , 0 );
+    g_assert_cmpuint( foo.calls, == , 4 );
+    g_assert_cmpint( foo.all_events, == ,
+                     QOF_EVENT_MODIFY | QOF_EVENT_ADD | QOF_EVENT_CREATE );
+    /* Delivered in the order the entities first turned up */
+    g_assert( foo.last_entity == fixture->foo2 );
+    g_assert_cmpint( foo.last_event, == , QOF_EVENT_MODIFY );
+    g_assert( foo.last_data == NULL );
+
+    g_test_message( "Test an entity destroyed while suspended" );
+    foo = empty;
+    qof_event_suspend();
+    qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->foo1, QOF_EVENT_DESTROY, NULL );
+    g_assert_cmpuint( foo.calls, == , 1 );
+    g_assert_cmpint( foo.last_event, == , QOF_EVENT_MODIFY | QOF_EVENT_DESTROY );
+    g_object_unref( fixture->foo1 );
+    fixture->foo1 = NULL;
+
+    g_test_message( "Test an entity freed without a destroy event" );
+    qof_event_gen( fixture->foo2, QOF_EVENT_MODIFY, NULL );
+    g_object_unref( fixture->foo2 );
+    fixture->foo2 = NULL;
+    qof_event_resume();
+    g_assert_cmpuint( foo.calls, == , 1 );
+
+    qof_event_unregister_handler( foo_id );
+    qof_event_unregister_handler( all_id );
+}
+
+static void
+sequence_handler( QofInstance *ent, QofEventId event_type,
+                  gpointer handler_data, gpointer event_data )
+{
+    GString *seq = handler_data;
+
+    g_string_append_printf( seq, "%s%s;",
+                            event_type & QOF_EVENT_ADD ? "+" :
+                            event_type & QOF_EVENT_REMOVE ? "-" : "m",
+                            event_data ? (const char *) event_data : "" );
+}
+
+static void
+test_coalesced_event_data( Fixture *fixture, gconstpointer pData )
+{
+    GString *seq = g_string_new( NULL );
+    gint id = qof_event_register_filtered_handler( sequence_handler, seq,
+              "foo", QOF_EVENT_ALL );
+
+    g_test_message( "Test that events with data are delivered at once, in order" );
+    qof_event_suspend();
+    qof_event_gen( fixture->foo1, QOF_EVENT_ADD, "a" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->foo1, QOF_EVENT_ADD, "b" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_REMOVE, "a" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_REMOVE, "a" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_ADD, "a" );
+    qof_event_gen( fixture->foo1, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpstr( seq->str, == , "+a;+b;-a;-a;+a;" );
+    qof_event_resume();
+    g_assert_cmpstr( seq->str, == , "+a;+b;-a;-a;+a;m;" );
+
+    qof_event_unregister_handler( id );
+    g_string_free( seq, TRUE );
+}
+
+void
+test_suite_qofevent ( void )
+{
+    GNC_TEST_ADD( suitename, "filtered dispatch", Fixture, NULL, setup, test_filtered_dispatch, teardown );
+    GNC_TEST_ADD( suitename, "coalesced events", Fixture, NULL, setup, test_coalesced_events, teardown );
+    GNC_TEST_ADD( suitename, "coalesced event data", Fixture, NULL, setup, test_coalesced_event_data, teardown );
+}
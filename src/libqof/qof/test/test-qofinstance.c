@@ -143,7 +143,7 @@ test_instance_new_destroy( void )
     g_assert( qof_instance_get_guid( inst ) );
     g_assert( !qof_instance_get_collection( inst ) );
     g_assert( qof_instance_get_book( inst ) == NULL );
-    g_assert( inst->kvp_data );
+    g_assert( inst->kvp_data == NULL );
     g_object_get( inst, "last-update", &timespec_priv, NULL);
     g_assert_cmpint( timespec_priv->tv_sec, == , 0 );
     g_assert_cmpint( timespec_priv->tv_nsec, == , -1 );
@@ -185,6 +185,55 @@ test_instance_new_destroy( void )
     g_log_remove_handler (log_domain, hdlr);
 }
 
+static void
+test_instance_collection_cb( QofInstance *inst, gpointer data )
+{
+    (*(guint*)data)++;
+}
+
+static void
+test_instance_collection( void )
+{
+    QofBook *book = qof_book_new();
+    QofIdType type = "test type";
+    QofCollection *col = qof_book_get_collection( book, type );
+    QofInstance *insts[1000];
+    GncGUID guids[1000];
+    guint i, n_seen = 0;
+
+    g_test_message( "Test filling a collection" );
+    for ( i = 0; i < 1000; i++ )
+    {
+        insts[i] = g_object_new( QOF_TYPE_INSTANCE, NULL );
+        qof_instance_init_data( insts[i], type, book );
+        guids[i] = *qof_instance_get_guid( insts[i] );
+    }
+    g_assert_cmpuint( qof_collection_count( col ), == , 1000 );
+    for ( i = 0; i < 1000; i++ )
+        g_assert( qof_collection_lookup_entity( col, &guids[i] ) == insts[i] );
+
+    g_test_message( "Test removing every other instance" );
+    for ( i = 0; i < 1000; i += 2 )
+        g_object_unref( insts[i] );
+    g_assert_cmpuint( qof_collection_count( col ), == , 500 );
+    for ( i = 0; i < 1000; i++ )
+        g_assert( qof_collection_lookup_entity( col, &guids[i] ) ==
+                  ( i % 2 ? insts[i] : NULL ) );
+    qof_collection_foreach( col, test_instance_collection_cb, &n_seen );
+    g_assert_cmpuint( n_seen, == , 500 );
+
+    g_test_message( "Test changing a guid" );
+    guid_new( &guids[1] );
+    qof_instance_set_guid( insts[1], &guids[1] );
+    g_assert( qof_collection_lookup_entity( col, &guids[1] ) == insts[1] );
+    g_assert_cmpuint( qof_collection_count( col ), == , 500 );
+
+    for ( i = 1; i < 1000; i += 2 )
+        g_object_unref( insts[i] );
+    g_assert_cmpuint( qof_collection_count( col ), == , 0 );
+    qof_book_destroy( book );
+}
+
 static void
 test_instance_init_data( void )
 {
@@ -252,9 +301,42 @@ test_instance_get_set_slots( Fixture *fixture, gconstpointer pData )
 
     g_test_message( "Test when kvp frame is null" );
     qof_instance_set_slots( fixture->inst, NULL );
-    g_assert( NULL == qof_instance_get_slots( fixture->inst ) );
+    g_assert( fixture->inst->kvp_data == NULL );
     g_assert( qof_instance_get_dirty_flag( fixture->inst ) );
+    kvp_frame = qof_instance_get_slots( fixture->inst );
+    g_assert( kvp_frame );
+    g_assert( kvp_frame_is_empty( kvp_frame ) );
+
+}
+
+static void
+test_instance_peek_slots( Fixture *fixture, gconstpointer pData )
+{
+    QofInstance *inst2 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    KvpFrame *empty, *kvp_frame;
+
+    g_test_message( "Reading the slots doesn't make a frame" );
+    g_assert( !qof_instance_has_slots( fixture->inst ) );
+    empty = qof_instance_peek_slots( fixture->inst );
+    g_assert( empty );
+    g_assert( kvp_frame_is_empty( empty ) );
+    g_assert( fixture->inst->kvp_data == NULL );
+    g_assert( qof_instance_peek_slots( inst2 ) == empty );
+    g_assert( qof_instance_peek_slots( NULL ) == NULL );
+
+    g_test_message( "Getting the slots to change them does" );
+    kvp_frame = qof_instance_get_slots( fixture->inst );
+    g_assert( kvp_frame && kvp_frame != empty );
+    g_assert( fixture->inst->kvp_data == kvp_frame );
+    g_assert( qof_instance_get_slots( fixture->inst ) == kvp_frame );
+    g_assert( !qof_instance_has_slots( fixture->inst ) );
+
+    kvp_frame_set_string( kvp_frame, "foo", "bar" );
+    g_assert( qof_instance_has_slots( fixture->inst ) );
+    g_assert( qof_instance_peek_slots( fixture->inst ) == kvp_frame );
+    g_assert( kvp_frame_is_empty( qof_instance_peek_slots( inst2 ) ) );
 
+    g_object_unref( inst2 );
 }
 
 static void
@@ -1053,7 +1135,9 @@ test_suite_qofinstance ( void )
     GNC_TEST_ADD( suitename, "set get guid", Fixture, NULL, setup, test_instance_set_get_guid, teardown );
     GNC_TEST_ADD_FUNC( suitename, "instance new and destroy", test_instance_new_destroy );
     GNC_TEST_ADD_FUNC( suitename, "init data", test_instance_init_data );
+    GNC_TEST_ADD_FUNC( suitename, "collection", test_instance_collection );
     GNC_TEST_ADD( suitename, "get set slots", Fixture, NULL, setup, test_instance_get_set_slots, teardown );
+    GNC_TEST_ADD( suitename, "peek slots", Fixture, NULL, setup, test_instance_peek_slots, teardown );
     GNC_TEST_ADD_FUNC( suitename, "version compare", test_instance_version_cmp );
     GNC_TEST_ADD( suitename, "get set dirty", Fixture, NULL, setup, test_instance_get_set_dirty, teardown );
     GNC_TEST_ADD( suitename, "display name", Fixture, NULL, setup, test_instance_display_name, teardown );
@@ -0,0 +1,140 @@
+/********************************************************************
+ * test-qofstats.c: GLib g_test test suite for the engine           *
+ *                  statistics                                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+#include <string.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofstats";
+void test_suite_qofstats ( void );
+
+typedef struct
+{
+} Fixture;
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    qof_stats_reset();
+    qof_stats_set_enabled(TRUE);
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    qof_stats_set_enabled(FALSE);
+    qof_stats_reset();
+}
+
+static void
+bump_counter( gint64 n )
+{
+    QOF_STATS_COUNT("test.counter", n);
+}
+
+static void
+record_value( gint64 v )
+{
+    QOF_STATS_RECORD("test.histogram", v);
+}
+
+static void
+test_qofstats_counter( Fixture *fixture, gconstpointer pData )
+{
+    bump_counter(1);
+    bump_counter(4);
+    g_assert_cmpint(qof_stats_get_count("test.counter"), ==, 5);
+    g_assert_cmpint(qof_stats_get_sum("test.counter"), ==, 5);
+    g_assert_cmpint(qof_stats_get_count("test.no-such-stat"), ==, 0);
+
+    /* Nothing is gathered while the statistics are off. */
+    qof_stats_set_enabled(FALSE);
+    bump_counter(10);
+    g_assert_cmpint(qof_stats_get_count("test.counter"), ==, 5);
+
+    qof_stats_reset();
+    g_assert_cmpint(qof_stats_get_count("test.counter"), ==, 0);
+}
+
+static void
+test_qofstats_histogram( Fixture *fixture, gconstpointer pData )
+{
+    gchar *json;
+
+    record_value(0);
+    record_value(1);
+    record_value(3);
+    record_value(3);
+    record_value(1000);
+    g_assert_cmpint(qof_stats_get_count("test.histogram"), ==, 5);
+    g_assert_cmpint(qof_stats_get_sum("test.histogram"), ==, 1007);
+
+    json = qof_stats_to_json();
+    g_assert(strstr(json, "\"test.histogram\": {\"count\": 5, \"sum\": 1007, "
+                    "\"min\": 0, \"max\": 1000, "
+                    "\"buckets\": [[0, 1], [1, 1], [2, 2], [512, 1]]}"));
+    g_free(json);
+}
+
+static void
+test_qofstats_json( Fixture *fixture, gconstpointer pData )
+{
+    gchar *json;
+
+    json = qof_stats_to_json();
+    g_assert_cmpstr(json, ==, "{}");
+    g_free(json);
+
+    record_value(2);
+    bump_counter(3);
+    json = qof_stats_to_json();
+    g_assert_cmpstr(json, ==,
+                    "{\n"
+                    "  \"test.counter\": {\"count\": 3},\n"
+                    "  \"test.histogram\": {\"count\": 1, \"sum\": 2, "
+                    "\"min\": 2, \"max\": 2, \"buckets\": [[2, 1]]}\n"
+                    "}");
+    g_free(json);
+}
+
+static void
+test_qofstats_kvp_lookups( Fixture *fixture, gconstpointer pData )
+{
+    KvpFrame *frame = kvp_frame_new();
+
+    kvp_frame_set_gint64(frame, "a", 1);
+    kvp_frame_get_slot(frame, "a");
+    kvp_frame_get_slot(frame, "b");
+    g_assert_cmpint(qof_stats_get_count("qof.kvp.lookups"), >=, 2);
+    kvp_frame_delete(frame);
+}
+
+void
+test_suite_qofstats ( void )
+{
+    GNC_TEST_ADD( suitename, "counter", Fixture, NULL, setup, test_qofstats_counter, teardown );
+    GNC_TEST_ADD( suitename, "histogram", Fixture, NULL, setup, test_qofstats_histogram, teardown );
+    GNC_TEST_ADD( suitename, "json", Fixture, NULL, setup, test_qofstats_json, teardown );
+    GNC_TEST_ADD( suitename, "kvp lookups", Fixture, NULL, setup, test_qofstats_kvp_lookups, teardown );
+}
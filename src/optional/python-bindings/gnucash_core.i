@@ -56,6 +56,7 @@
 #include "guid.h"
 #include "qofquery.h"
 #include "qofquerycore.h"
+#include "qofstats.h"
 #include "gnc-module/gnc-module.h"
 #include "engine/gnc-engine.h"
 #include "Transaction.h"
@@ -102,6 +103,9 @@
 
 %include <qofquerycore.h>
 
+%newobject qof_stats_to_json;
+%include <qofstats.h>
+
 /* SWIG doesn't like this macro, so redefine it to simply mean const */
 #define G_CONST_RETURN const
 %include <guid.h>
@@ -58,6 +58,8 @@ struct gnc_ledger_display
     GncGUID leader;
 
     Query *query;
+    QofQueryLive *live;
+    GHashTable *watched;    /* the transactions watched, by pointer */
 
     GNCLedgerDisplayType ld_type;
 
@@ -506,18 +508,14 @@ gnc_ledger_display_parent (void *user_data)
     return gnc_ledger_display_get_parent( ld );
 }
 
+/* Watch the transactions of the splits.  The transactions of splits
+ * that stop matching stay watched until the next full refresh, which
+ * only costs a refresh when they change. */
 static void
-gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
+gnc_ledger_display_add_watches (GNCLedgerDisplay *ld, GList *splits)
 {
     GList *node;
 
-    gnc_gui_component_clear_watches (ld->component_id);
-
-    gnc_gui_component_watch_entity_type (ld->component_id,
-                                         GNC_ID_ACCOUNT,
-                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY
-                                         | GNC_EVENT_ITEM_CHANGED);
-
     for (node = splits; node; node = node->next)
     {
         Split *split = node->data;
@@ -526,7 +524,71 @@ gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
         gnc_gui_component_watch_entity (ld->component_id,
                                         xaccTransGetGUID (trans),
                                         QOF_EVENT_MODIFY);
+        g_hash_table_insert (ld->watched, trans, trans);
+    }
+}
+
+static void
+gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
+{
+    gnc_gui_component_clear_watches (ld->component_id);
+    g_hash_table_remove_all (ld->watched);
+
+    gnc_gui_component_watch_entity_type (ld->component_id,
+                                         GNC_ID_ACCOUNT,
+                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY
+                                         | GNC_EVENT_ITEM_CHANGED);
+
+    gnc_ledger_display_add_watches (ld, splits);
+}
+
+/* Whether any of the events changes what the register shows, other
+ * than splits coming or going: a change to one of its transactions or
+ * to any account, whose name or balance it may show, or anything
+ * destroyed. */
+static gboolean
+gnc_ledger_display_changes_shown (GNCLedgerDisplay *ld, GHashTable *changes)
+{
+    QofBook *book = gnc_get_current_book ();
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init (&iter, changes);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        const GncGUID *guid = key;
+        const EventInfo *info = value;
+        Transaction *trans;
+
+        if (info->event_mask & QOF_EVENT_DESTROY)
+            return TRUE;
+        trans = xaccTransLookup (guid, book);
+        if (trans && g_hash_table_lookup (ld->watched, trans))
+            return TRUE;
+        if (!trans && (info->event_mask & QOF_EVENT_MODIFY) &&
+                xaccAccountLookup (guid, book))
+            return TRUE;
     }
+    return FALSE;
+}
+
+/* Keep the query results up to date from the engine events instead of
+ * searching the whole book on every refresh.  If added and removed
+ * are not NULL they get the splits that started or stopped matching
+ * since the last run; free them with g_list_free. */
+static GList *
+gnc_ledger_display_run_query (GNCLedgerDisplay *ld, GList **added,
+                              GList **removed)
+{
+    if (added)
+        *added = NULL;
+    if (removed)
+        *removed = NULL;
+    if (!ld->query)
+        return NULL;
+    if (!ld->live)
+        ld->live = qof_query_live_new (ld->query);
+    return qof_query_live_run (ld->live, added, removed);
 }
 
 static void
@@ -535,7 +597,7 @@ refresh_handler (GHashTable *changes, gpointer user_data)
     GNCLedgerDisplay *ld = user_data;
     const EventInfo *info;
     gboolean has_leader;
-    GList *splits;
+    GList *splits, *added, *removed;
 
     ENTER("changes=%p, user_data=%p", changes, user_data);
 
@@ -569,16 +631,27 @@ refresh_handler (GHashTable *changes, gpointer user_data)
         }
     }
 
-    /* Its not clear if we should re-run the query, or if we should
-     * just use qof_query_last_run().  Its possible that the dates
-     * changed, requiring a full new query.  Similar considerations
-     * needed for multi-user mode.
+    /* The live query notices date changes and the like by itself and
+     * starts over if the query was changed.  Multi-user mode would
+     * need more than that.
      */
-    splits = qof_query_run (ld->query);
-
-    gnc_ledger_display_set_watches (ld, splits);
+    splits = gnc_ledger_display_run_query (ld, &added, &removed);
 
-    gnc_ledger_display_refresh_internal (ld, splits);
+    /* Only the splits that came or went need their watches changed,
+     * unless this is a refresh of everything. */
+    if (changes)
+        gnc_ledger_display_add_watches (ld, added);
+    else
+        gnc_ledger_display_set_watches (ld, splits);
+
+    /* The register lays out all its rows whenever it loads, so it
+     * takes the whole list; if nothing came or went and nothing it
+     * shows changed, there is nothing to lay out again. */
+    if (!changes || added || removed ||
+            gnc_ledger_display_changes_shown (ld, changes))
+        gnc_ledger_display_refresh_internal (ld, splits);
+    g_list_free (added);
+    g_list_free (removed);
     LEAVE(" ");
 }
 
@@ -598,6 +671,11 @@ close_handler (gpointer user_data)
     gnc_split_register_destroy (ld->reg);
     ld->reg = NULL;
 
+    qof_query_live_destroy (ld->live);
+    ld->live = NULL;
+    g_hash_table_destroy (ld->watched);
+    ld->watched = NULL;
+
     qof_query_destroy (ld->query);
     ld->query = NULL;
 
@@ -629,6 +707,8 @@ gnc_ledger_display_make_query (GNCLedgerDisplay *ld,
         return;
     }
 
+    qof_query_live_destroy (ld->live);
+    ld->live = NULL;
     qof_query_destroy (ld->query);
     ld->query = qof_query_create_for(GNC_ID_SPLIT);
 
@@ -754,6 +834,8 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
 
     ld->leader = *xaccAccountGetGUID (lead_account);
     ld->query = NULL;
+    ld->live = NULL;
+    ld->watched = g_hash_table_new (g_direct_hash, g_direct_equal);
     ld->ld_type = ld_type;
     ld->loading = FALSE;
     ld->destroy = NULL;
@@ -782,7 +864,7 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
 
     gnc_split_register_set_data (ld->reg, ld, gnc_ledger_display_parent);
 
-    splits = qof_query_run (ld->query);
+    splits = gnc_ledger_display_run_query (ld, NULL, NULL);
 
     gnc_ledger_display_set_watches (ld, splits);
 
@@ -799,6 +881,8 @@ gnc_ledger_display_set_query (GNCLedgerDisplay *ledger_display, Query *q)
 
     g_return_if_fail (ledger_display->ld_type == LD_GL);
 
+    qof_query_live_destroy (ledger_display->live);
+    ledger_display->live = NULL;
     qof_query_destroy (ledger_display->query);
     ledger_display->query = qof_query_copy (q);
 }
@@ -850,7 +934,8 @@ gnc_ledger_display_refresh (GNCLedgerDisplay *ld)
         return;
     }
 
-    gnc_ledger_display_refresh_internal (ld, qof_query_run (ld->query));
+    gnc_ledger_display_refresh_internal (ld,
+                                         gnc_ledger_display_run_query (ld, NULL, NULL));
     LEAVE(" ");
 }
 
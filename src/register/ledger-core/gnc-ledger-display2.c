@@ -62,6 +62,7 @@ struct gnc_ledger_display2
     GncGUID leader;
 
     Query *query;
+    QofQueryLive *live;
 
     GNCLedgerDisplay2Type ld_type;
 
@@ -516,27 +517,42 @@ gnc_ledger_display2_parent (void *user_data)
     return gnc_ledger_display2_get_parent( ld );
 }
 
+/* The model follows the transactions it shows by itself; the display
+ * only has to hear of the events that can make splits start or stop
+ * matching its query. */
 static void
-gnc_ledger_display2_set_watches (GNCLedgerDisplay2 *ld, GList *splits)
+gnc_ledger_display2_set_watches (GNCLedgerDisplay2 *ld)
 {
-    GList *node;
-
     gnc_gui_component_clear_watches (ld->component_id);
 
     gnc_gui_component_watch_entity_type (ld->component_id,
                                          GNC_ID_ACCOUNT,
-                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY
-                                         | GNC_EVENT_ITEM_CHANGED);
+                                         QOF_EVENT_DESTROY
+                                         | GNC_EVENT_ITEM_ADDED
+                                         | GNC_EVENT_ITEM_REMOVED);
 
-    for (node = splits; node; node = node->next)
-    {
-        Split *split = node->data;
-        Transaction *trans = xaccSplitGetParent (split);
+    gnc_gui_component_watch_entity_type (ld->component_id,
+                                         GNC_ID_TRANS,
+                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY);
+}
 
-        gnc_gui_component_watch_entity (ld->component_id,
-                                        xaccTransGetGUID (trans),
-                                        QOF_EVENT_MODIFY);
-    }
+/* Keep the query results up to date from the engine events instead of
+ * searching the whole book on every refresh.  If added and removed
+ * are not NULL they get the splits that started or stopped matching
+ * since the last run; free them with g_list_free. */
+static GList *
+gnc_ledger_display2_run_query (GNCLedgerDisplay2 *ld, GList **added,
+                               GList **removed)
+{
+    if (added)
+        *added = NULL;
+    if (removed)
+        *removed = NULL;
+    if (!ld->query)
+        return NULL;
+    if (!ld->live)
+        ld->live = qof_query_live_new (ld->query);
+    return qof_query_live_run (ld->live, added, removed);
 }
 
 static void
@@ -545,7 +561,7 @@ refresh_handler (GHashTable *changes, gpointer user_data)
     GNCLedgerDisplay2 *ld = user_data;
     const EventInfo *info;
     gboolean has_leader;
-    GList *splits;
+    GList *splits, *added, *removed;
 
     ENTER("changes=%p, user_data=%p", changes, user_data);
 
@@ -579,18 +595,21 @@ refresh_handler (GHashTable *changes, gpointer user_data)
         }
     }
 
-    /* Its not clear if we should re-run the query, or if we should
-     * just use qof_query_last_run().  Its possible that the dates
-     * changed, requiring a full new query.  Similar considerations
-     * needed for multi-user mode.
+    /* The live query notices date changes and the like by itself and
+     * starts over if the query was changed.  Multi-user mode would
+     * need more than that.
      */
-    splits = qof_query_run (ld->query);
-
-//FIXME Not Needed ?    gnc_ledger_display2_set_watches (ld, splits);
-//    gnc_ledger_display2_set_watches (ld, splits);
-
-    //preference changes come this way
-    gnc_ledger_display2_refresh_internal (ld, splits);
+    splits = gnc_ledger_display2_run_query (ld, &added, &removed);
+
+    /* Only the transactions that came or went need to go in or out of
+     * the model; preference changes come without changes and load
+     * everything again. */
+    if (!changes ||
+            !gnc_tree_model_split_reg_apply_query_changes (ld->model, splits,
+                                                           added, removed))
+        gnc_ledger_display2_refresh_internal (ld, splits);
+    g_list_free (added);
+    g_list_free (removed);
 
     LEAVE(" ");
 }
@@ -614,6 +633,9 @@ close_handler (gpointer user_data)
     ld->model = NULL;
     ld->view = NULL;
 
+    qof_query_live_destroy (ld->live);
+    ld->live = NULL;
+
     qof_query_destroy (ld->query);
     ld->query = NULL;
 
@@ -646,6 +668,8 @@ gnc_ledger_display2_make_query (GNCLedgerDisplay2 *ld,
         return;
     }
 
+    qof_query_live_destroy (ld->live);
+    ld->live = NULL;
     qof_query_destroy (ld->query);
     ld->query = qof_query_create_for(GNC_ID_SPLIT);
 
@@ -775,6 +799,7 @@ gnc_ledger_display2_internal (Account *lead_account, Query *q,
 
     ld->leader = *xaccAccountGetGUID (lead_account);
     ld->query = NULL;
+    ld->live = NULL;
     ld->ld_type = ld_type;
     ld->loading = FALSE;
     ld->refresh_ok = FALSE;
@@ -809,8 +834,7 @@ gnc_ledger_display2_internal (Account *lead_account, Query *q,
     g_signal_connect (G_OBJECT (ld->model), "refresh_trans",
                       G_CALLBACK (gnc_ledger_display2_refresh_cb), ld );
 
-//FIXME Not Needed ?    gnc_ledger_display2_set_watches (ld, splits);
-//    gnc_ledger_display2_set_watches (ld, splits);
+    gnc_ledger_display2_set_watches (ld);
 
     // Populate the model with an empty split
     // An empty model could cause our gui callbacks to crash
@@ -845,6 +869,8 @@ gnc_ledger_display2_set_query (GNCLedgerDisplay2 *ledger_display, Query *q)
 
     g_return_if_fail (ledger_display->ld_type == LD2_GL);
 
+    qof_query_live_destroy (ledger_display->live);
+    ledger_display->live = NULL;
     qof_query_destroy (ledger_display->query);
     ledger_display->query = qof_query_copy (q);
 }
@@ -965,7 +991,8 @@ gnc_ledger_display2_refresh (GNCLedgerDisplay2 *ld)
 
     // Update the query before refresh
     gnc_tree_model_split_reg_update_query (ld->model, ld->query);
-    gnc_ledger_display2_refresh_internal (ld, qof_query_run (ld->query));
+    gnc_ledger_display2_refresh_internal (ld,
+                                          gnc_ledger_display2_run_query (ld, NULL, NULL));
     LEAVE(" ");
 }
 
@@ -866,6 +866,7 @@ gnc_split_register_auto_completion (SplitRegister *reg,
         {
             if (!xaccTransIsOpen(trans))
                 xaccTransBeginEdit(trans);
+            qof_instance_release_edit_lock (QOF_INSTANCE (trans));
             /* This is now the pending transaction */
             info->pending_trans_guid = *xaccTransGetGUID(trans);
             if (pending_trans != NULL)
@@ -268,6 +268,9 @@ create_blank_split (Account *default_account, SRInfo *info)
     xaccTransSetDatePostedSecsNormalized(new_trans, info->last_date_entered);
     blank_split = xaccMallocSplit (gnc_get_current_book ());
     xaccSplitSetParent(blank_split, new_trans);
+    /* The blank transaction stays open for as long as the register is
+       shown, so don't keep the other threads from reading the book. */
+    qof_instance_release_edit_lock (QOF_INSTANCE (new_trans));
     /* We don't want to commit this transaction yet, because the split
        doesn't even belong to an account yet.  But, we don't want to
        set this transaction as the pending transaction either, because
@@ -157,6 +157,9 @@ gnc_split_register_begin_edit_or_warn(SRInfo *info, Transaction *trans)
     if (!xaccTransIsOpen(trans))
     {
         xaccTransBeginEdit(trans);
+        /* It stays open while the user edits it, so don't keep the
+         * other threads from reading the book meanwhile. */
+        qof_instance_release_edit_lock (QOF_INSTANCE (trans));
         /* This is now the pending transaction */
         info->pending_trans_guid = *xaccTransGetGUID(trans);
         LEAVE("opened and marked pending");